@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "balance.h"
+#include "block.h"
+#include "metrics.h"
+#include "global.h"
+
+// the controller and the counts of running threads, only used with --adaptive
+static struct {
+    int enabled;                 // Flag set by start_balance() with --adaptive
+    int pool[2];                 // Threads of each role launched
+    int target[2];               // Threads of each role allowed to run
+    int running[2];              // Threads of each role neither parked nor finished
+    int budget;                  // Number of CPUs, the most threads worth running at once
+    atomic_int blockWords;       // Words per new block
+    int stopping;                // Flag to stop the controller thread
+    pthread_mutex_t mutex;       // Mutex protecting the counts and the flag
+    pthread_cond_t changed;      // Signaled when parked threads may run
+    pthread_cond_t stop;         // Signaled to stop the controller thread
+    pthread_t thread;            // Thread of the controller
+} balance;
+
+// names of the roles in the decisions
+static const char* ROLE_NAMES[2] = { "producers", "consumers" };
+
+int block_words() {
+    if (!balance.enabled) {
+        return MAX_LOCAL_BUFFER_SIZE;
+    }
+    return atomic_load_explicit(&balance.blockWords, memory_order_relaxed);
+}
+
+void balance_park(int role) {
+    if (!balance.enabled) {
+        return;
+    }
+    pthread_mutex_lock(&balance.mutex);
+    if (balance.running[role] > balance.target[role]) {
+        balance.running[role]--;
+        // consumers also drain what is left once the producers are done
+        while (balance.running[role] >= balance.target[role] && !isFound && !balance.stopping
+            && !(role == ROLE_CONSUMER && isDone)) {
+            pthread_cond_wait(&balance.changed, &balance.mutex);
+        }
+        balance.running[role]++;
+    }
+    pthread_mutex_unlock(&balance.mutex);
+}
+
+void balance_exit(int role) {
+    if (!balance.enabled) {
+        return;
+    }
+    pthread_mutex_lock(&balance.mutex);
+    balance.running[role]--;
+    pthread_cond_broadcast(&balance.changed);
+    pthread_mutex_unlock(&balance.mutex);
+}
+
+void balance_wake() {
+    if (!balance.enabled) {
+        return;
+    }
+    pthread_mutex_lock(&balance.mutex);
+    pthread_cond_broadcast(&balance.changed);
+    pthread_mutex_unlock(&balance.mutex);
+}
+
+// let one more thread of a role run, in exchange for one of the other role if the CPUs
+// are all taken, returns 1 if a thread was woken
+static int unpark(int role) {
+    int other = 1 - role;
+    if (balance.target[role] >= balance.pool[role]) {
+        return 0;
+    }
+    if (balance.target[role] + balance.target[other] >= balance.budget) {
+        if (balance.target[other] == 1) {
+            return 0;
+        }
+        balance.target[other]--;
+    }
+    balance.target[role]++;
+    return 1;
+}
+
+// park up to `count` threads of a role, keeping one running, returns 1 if any was parked
+static int park(int role, int count) {
+    int parked = balance.target[role] - 1 < count ? balance.target[role] - 1 : count;
+    balance.target[role] -= parked;
+    return parked > 0;
+}
+
+// take one decision from the measurements of an interval, returns its reason or NULL
+static const char* decide(double starved, double blocked, double contended, double fill) {
+    const char* reason = NULL;
+    int words = atomic_load(&balance.blockWords);
+    int excess = balance.target[ROLE_PRODUCER] + balance.target[ROLE_CONSUMER] - balance.budget;
+
+    // the input cannot keep the consumers busy, read more of it at once
+    if (starved > BALANCE_STARVED && fill < 0.25 && unpark(ROLE_PRODUCER)) {
+        reason = "consumers starved";
+    }
+    // the hashing cannot keep up with the input, hash more of it at once or read less
+    else if (blocked > BALANCE_BLOCKED && fill > 0.75 && (unpark(ROLE_CONSUMER) || park(ROLE_PRODUCER, 1))) {
+        reason = "producers blocked";
+    }
+    // more threads than CPUs, park half the excess, first of the role that waits the most
+    else if (excess > 0) {
+        int role = blocked > starved ? ROLE_PRODUCER : ROLE_CONSUMER;
+        if (park(role, (excess + 1) / 2) || park(1 - role, (excess + 1) / 2)) {
+            reason = "more threads than CPUs";
+        }
+    }
+
+    // fewer hand-offs for a contended mutex, smaller ones for starving consumers
+    if (contended > BALANCE_CONTENDED && words < MAX_BLOCK_WORDS) {
+        words = words * 2 < MAX_BLOCK_WORDS ? words * 2 : MAX_BLOCK_WORDS;
+        reason = reason == NULL ? "buffer mutex contended" : reason;
+    }
+    else if (contended < BALANCE_CONTENDED / 5 && starved > BALANCE_STARVED && words > MIN_BLOCK_WORDS) {
+        words = words / 2 > MIN_BLOCK_WORDS ? words / 2 : MIN_BLOCK_WORDS;
+        reason = reason == NULL ? "consumers starved" : reason;
+    }
+    atomic_store(&balance.blockWords, words);
+    return reason;
+}
+
+// sample the pipeline every BALANCE_INTERVAL seconds and rebalance it until stopped
+static void* controller(void* arg) {
+    uint64_t last[2][NUM_METRICS], totals[2][NUM_METRICS];
+    uint64_t previous = metrics_now();
+    metrics_sum(last);
+
+    pthread_mutex_lock(&balance.mutex);
+    while (!balance.stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += (long)(BALANCE_INTERVAL * 1e9);
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+        if (pthread_cond_timedwait(&balance.stop, &balance.mutex, &deadline) == 0 || balance.stopping) {
+            continue;
+        }
+        // the buffer mutex is never taken under the controller's
+        pthread_mutex_unlock(&balance.mutex);
+        pthread_mutex_lock(&BUFFER.mutex);
+        double fill = (double)BUFFER.count / MAX_GLOBAL_BLOCKS;
+        pthread_mutex_unlock(&BUFFER.mutex);
+        uint64_t now = metrics_now();
+        metrics_sum(totals);
+        pthread_mutex_lock(&balance.mutex);
+
+        // shares of the time of the threads that ran during the interval
+        double interval = (now - previous) * 1.0;
+        int producers = balance.target[ROLE_PRODUCER], consumers = balance.target[ROLE_CONSUMER];
+        int words = atomic_load(&balance.blockWords);
+        double blocked = (totals[ROLE_PRODUCER][METRIC_FULL_WAIT] - last[ROLE_PRODUCER][METRIC_FULL_WAIT])
+            / (interval * producers);
+        double starved = (totals[ROLE_CONSUMER][METRIC_EMPTY_WAIT] - last[ROLE_CONSUMER][METRIC_EMPTY_WAIT])
+            / (interval * consumers);
+        double contended = 0;
+        for (int role = 0; role < 2; role++) {
+            contended += totals[role][METRIC_LOCK_WAIT] - last[role][METRIC_LOCK_WAIT];
+        }
+        contended /= interval * (producers + consumers);
+        // threads parked or woken during the interval may count a little more than it
+        blocked = blocked < 1 ? blocked : 1;
+        starved = starved < 1 ? starved : 1;
+        memcpy(last, totals, sizeof(totals));
+        previous = now;
+
+        // once the producers are done the pipeline only drains
+        const char* reason = isDone || isFound ? NULL : decide(starved, blocked, contended, fill);
+        if (reason != NULL) {
+            printf("balance:     %.1f s, %s (buffer %.0f%% full, producers %.0f%% blocked, consumers %.0f%% "
+                "starved, mutex %.1f%% contended): %s %d -> %d, %s %d -> %d, block %d -> %d words\n",
+                (now - METRICS.startTime) / 1e9, reason, 100 * fill, 100 * blocked, 100 * starved, 100 * contended,
+                ROLE_NAMES[ROLE_PRODUCER], producers, balance.target[ROLE_PRODUCER], ROLE_NAMES[ROLE_CONSUMER],
+                consumers, balance.target[ROLE_CONSUMER], words, atomic_load(&balance.blockWords));
+            fflush(stdout);
+            pthread_cond_broadcast(&balance.changed);
+        }
+    }
+    pthread_mutex_unlock(&balance.mutex);
+    return NULL;
+}
+
+void start_balance(int numProducers, int numConsumers) {
+    if (!OPTIONS.adaptive) {
+        return;
+    }
+    balance.pool[ROLE_PRODUCER] = balance.target[ROLE_PRODUCER] = balance.running[ROLE_PRODUCER] = numProducers;
+    balance.pool[ROLE_CONSUMER] = balance.target[ROLE_CONSUMER] = balance.running[ROLE_CONSUMER] = numConsumers;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    balance.budget = cpus > 1 ? (int)cpus : 1;
+    atomic_init(&balance.blockWords, MAX_LOCAL_BUFFER_SIZE);
+    balance.stopping = 0;
+    pthread_mutex_init(&balance.mutex, NULL);
+    pthread_cond_init(&balance.changed, NULL);
+    pthread_cond_init(&balance.stop, NULL);
+    balance.enabled = 1;
+    printf("balance:     adaptive, %d producer%s and %d consumer%s on %d CPU%s, blocks of %d-%d words\n",
+        numProducers, numProducers == 1 ? "" : "s", numConsumers, numConsumers == 1 ? "" : "s", balance.budget,
+        balance.budget == 1 ? "" : "s", MIN_BLOCK_WORDS, MAX_BLOCK_WORDS);
+    pthread_create(&balance.thread, NULL, controller, NULL);
+}
+
+void finish_balance() {
+    if (!balance.enabled) {
+        return;
+    }
+    pthread_mutex_lock(&balance.mutex);
+    balance.stopping = 1;
+    pthread_cond_signal(&balance.stop);
+    pthread_mutex_unlock(&balance.mutex);
+    pthread_join(balance.thread, NULL);
+    balance.enabled = 0;
+    pthread_mutex_destroy(&balance.mutex);
+    pthread_cond_destroy(&balance.changed);
+    pthread_cond_destroy(&balance.stop);
+}
@@ -0,0 +1,87 @@
+/** balance.h
+ * This file contains the declarations of the adaptive controller of `--adaptive`, which
+ * rebalances the producer/consumer pipeline while it runs instead of relying on the
+ * block size and thread counts fixed at launch. Every BALANCE_INTERVAL seconds it samples
+ * the occupancy of the global buffer and, from the metrics of the interval (see
+ * metrics.h), the share of time the producers spent blocked on `notFull`, the consumers
+ * blocked on `notEmpty`, and every thread contending for the buffer mutex. It then takes
+ * at most one step of each kind:
+ * - Readers: consumers starving on a nearly empty buffer mean the input is the bottleneck,
+ *   so a parked producer is woken; producers blocked on a nearly full buffer mean the
+ *   hashing is, so a parked consumer is woken, or else a producer is parked. A thread
+ *   woken beyond the number of CPUs parks one of the other role in exchange.
+ * - Batch size: a contended mutex doubles the number of words per block, so fewer hand-offs
+ *   move the same words; starving consumers on an uncontended mutex halve it, so the
+ *   words that arrive reach more consumers sooner. Blocks stay between MIN_BLOCK_WORDS
+ *   and MAX_BLOCK_WORDS (see block.h).
+ *
+ * The threads are the fixed pool created at launch. A thread parks only between two
+ * blocks, while it holds none, and a producer that finishes its range lets a parked one
+ * continue in its place, so no range is left unread. At least one thread of each role
+ * keeps running, and every parked thread wakes when the producers are done or every
+ * target is cracked. Every decision is printed with the measurements behind it.
+ *
+ * The main components of this file include:
+ * - start_balance()/finish_balance(): Run and stop the controller thread.
+ * - block_words(): The current number of words per block.
+ * - balance_park(): Parks the calling thread while its role has too many running.
+ * - balance_exit(): Records that a thread has finished.
+ * - balance_wake(): Wakes every parked thread to see a new state of the run.
+ */
+
+#ifndef __BALANCE__
+#define __BALANCE__
+
+// seconds between two decisions of the controller
+#define BALANCE_INTERVAL 0.5
+// share of their time consumers must spend waiting for blocks to be starving
+#define BALANCE_STARVED 0.2
+// share of their time producers must spend waiting for room to be blocked
+#define BALANCE_BLOCKED 0.5
+// share of the thread time spent acquiring the buffer mutex above which it is contended
+#define BALANCE_CONTENDED 0.05
+
+/** start_balance()
+ * This function starts the controller thread when `--adaptive` is given, with every
+ * thread of the pool running and blocks of MAX_LOCAL_BUFFER_SIZE words. It must be
+ * called after start_metrics() and before the threads are created.
+ *
+ * @param numProducers Number of producer threads of the pool.
+ * @param numConsumers Number of consumer threads of the pool.
+ */
+void start_balance(int, int);
+
+/** finish_balance()
+ * This function stops the controller thread once every thread has been joined.
+ */
+void finish_balance();
+
+/** block_words()
+ * @return int The number of words a new block holds, MAX_LOCAL_BUFFER_SIZE without
+ *             `--adaptive`.
+ */
+int block_words();
+
+/** balance_park()
+ * This function parks the calling thread while more threads of its role are running than
+ * the controller allows, and returns at once otherwise or without `--adaptive`. It must
+ * only be called between two blocks.
+ *
+ * @param role ROLE_PRODUCER or ROLE_CONSUMER (see metrics.h).
+ */
+void balance_park(int);
+
+/** balance_exit()
+ * This function records that the calling thread has finished, so a parked thread of its
+ * role may run in its place.
+ *
+ * @param role ROLE_PRODUCER or ROLE_CONSUMER.
+ */
+void balance_exit(int);
+
+/** balance_wake()
+ * This function wakes every parked thread after `isDone` or `isFound` is set.
+ */
+void balance_wake();
+
+#endif
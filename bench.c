@@ -0,0 +1,565 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include "sha-256.h"
+#include "sha-256-simd.h"
+#include "producer.h"
+#include "consumer.h"
+#include "bench.h"
+#include "block.h"
+#include "dictionary.h"
+#include "metrics.h"
+#include "rules.h"
+#include "global.h"
+
+// most points of a grid
+#define MAX_GRID_POINTS 32
+// the prefix of the shared-prefix measurement, as long as a typical stem output
+static const char* PREFIX = "correcthorsebatt";
+// stem output lengths of the shared-prefix crossover measurement
+static const int CROSSOVER_LENGTHS[] = {4, 8, 12, 16, 24, 32};
+#define NUM_CROSSOVER_LENGTHS ((int)(sizeof(CROSSOVER_LENGTHS) / sizeof(CROSSOVER_LENGTHS[0])))
+// one-digit suffixes per stem in the crossover measurement, as in the classic rules
+#define CROSSOVER_SUFFIXES 10
+// seed of the synthetic dictionary, fixed so every version measures the same words
+#define BENCH_SEED 0x9e3779b97f4a7c15ull
+
+/** GridPoint
+ * The thread counts of one run of the queue and crack measurements.
+ */
+typedef struct {
+    int producers;
+    int consumers;
+    double blocksPerSecond;      // Blocks moved through the global buffer
+    double queueWordsPerSecond;  // Words moved through the global buffer
+    double wordsPerSecond;       // Words processed by a whole run
+    double hashesPerSecond;      // Candidates hashed by a whole run
+} GridPoint;
+
+/** QueueThread
+ * One producer or consumer of the queue measurement.
+ */
+typedef struct {
+    const Dictionary* dict;      // Synthetic dictionary the producers copy words from
+    int numProducers;            // Number of producer threads
+    long blocks;                 // Blocks taken by a consumer
+    long words;                  // Words taken by a consumer
+} QueueThread;
+
+// set once the queue measurement has run for long enough
+static atomic_int queueStop;
+// digests are added up into it, so the hashing cannot be optimized away
+static volatile unsigned benchSink;
+
+// seconds since a time read with metrics_now()
+static double seconds_since(uint64_t start) {
+    return (metrics_now() - start) / 1e9;
+}
+
+// xorshift64*, deterministic across platforms
+static uint64_t next_random(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545f4914f6cdd1dull;
+}
+
+// parse a length distribution such as "8", "6-12" or "6-8:3,12:1" into a weight per
+// length, returns 0 if it is invalid
+static int parse_lengths(const char* spec, long weights[MAX_WORD_LENGTH]) {
+    const char* p = spec;
+    memset(weights, 0, MAX_WORD_LENGTH * sizeof(long));
+    while (*p != '\0') {
+        char* end;
+        long low = strtol(p, &end, 10), high = low, weight = 1;
+        if (end == p) {
+            return 0;
+        }
+        if (*end == '-') {
+            p = end + 1;
+            high = strtol(p, &end, 10);
+            if (end == p) {
+                return 0;
+            }
+        }
+        if (*end == ':') {
+            p = end + 1;
+            weight = strtol(p, &end, 10);
+            if (end == p || weight < 1) {
+                return 0;
+            }
+        }
+        // words the dictionary reader would skip cannot be measured
+        if (low < 1 || high < low || high > MAX_WORD_LENGTH - 2 || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+        for (long len = low; len <= high; len++) {
+            weights[len] += weight;
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return 1;
+}
+
+// parse a grid such as "1x1,2x4", returns the number of points or 0 if it is invalid
+static int parse_grid(const char* spec, GridPoint* grid) {
+    int count = 0;
+    const char* p = spec;
+    while (*p != '\0') {
+        int producers, consumers, used;
+        if (count == MAX_GRID_POINTS || sscanf(p, "%dx%d%n", &producers, &consumers, &used) != 2
+                || producers < 1 || consumers < 1 || (p[used] != ',' && p[used] != '\0')) {
+            return 0;
+        }
+        memset(&grid[count], 0, sizeof(GridPoint));
+        grid[count].producers = producers;
+        grid[count].consumers = consumers;
+        count++;
+        p += used + (p[used] == ',');
+    }
+    return count;
+}
+
+// write `numWords` random lowercase words with lengths drawn from `weights`
+static void write_words(FILE* file, long numWords, const long weights[MAX_WORD_LENGTH]) {
+    uint64_t state = BENCH_SEED;
+    long total = 0;
+    char word[MAX_WORD_LENGTH];
+    for (int len = 0; len < MAX_WORD_LENGTH; len++) {
+        total += weights[len];
+    }
+    for (long i = 0; i < numWords; i++) {
+        long pick = next_random(&state) % total;
+        int len = 1;
+        while (pick >= weights[len]) {
+            pick -= weights[len++];
+        }
+        for (int c = 0; c < len; c++) {
+            word[c] = 'a' + next_random(&state) % 26;
+        }
+        fprintf(file, "%.*s\n", len, word);
+    }
+}
+
+// candidates per second of the scalar hash
+static double bench_scalar(const WordView* words, int n) {
+    uint8_t hash[32];
+    unsigned sink = 0;
+    long count = 0;
+    uint64_t start = metrics_now();
+    do {
+        for (int i = 0; i < n; i++) {
+            calc_sha_256(hash, words[i].ptr, words[i].len);
+            sink += hash[0];
+        }
+        count += n;
+    } while (seconds_since(start) < BENCH_SECONDS);
+    benchSink = sink;
+    return count / seconds_since(start);
+}
+
+// candidates per second of the batch API, of prefix + word hashed whole or, with
+// `prefixed`, finished from the shared prefix
+static double bench_batch(const WordView* words, int n, int withPrefix, int prefixed) {
+    int lanes = sha_256_engine_lanes();
+    int prefixLen = withPrefix ? (int)strlen(PREFIX) : 0;
+    struct sha_256_prefix prefix;
+    const struct sha_256_prefix* prefixes[SHA_256_MAX_LANES];
+    const char* msgs[SHA_256_MAX_LANES];
+    size_t lens[SHA_256_MAX_LANES];
+    char whole[SHA_256_MAX_LANES][2 * MAX_WORD_LENGTH];
+    uint32_t digests[SHA_256_MAX_LANES][8];
+    unsigned sink = 0;
+    long count = 0;
+
+    sha_256_prefix_init(&prefix, PREFIX, prefixLen);
+    for (int i = 0; i < lanes; i++) {
+        prefixes[i] = &prefix;
+        memcpy(whole[i], PREFIX, prefixLen);
+    }
+    uint64_t start = metrics_now();
+    do {
+        for (int i = 0; i + lanes <= n; i += lanes) {
+            for (int l = 0; l < lanes; l++) {
+                const WordView* word = &words[i + l];
+                if (prefixed || prefixLen == 0) {
+                    msgs[l] = word->ptr;
+                    lens[l] = word->len;
+                }
+                else {
+                    // hashing whole needs the candidate in one piece, as in a consumer
+                    memcpy(whole[l] + prefixLen, word->ptr, word->len);
+                    msgs[l] = whole[l];
+                    lens[l] = prefixLen + word->len;
+                }
+            }
+            if (prefixed) {
+                sha_256_prefix_batch(prefixes, msgs, lens, lanes, digests);
+            }
+            else {
+                sha_256_batch(msgs, lens, lanes, digests);
+            }
+            sink += digests[0][0];
+            count += lanes;
+        }
+    } while (seconds_since(start) < BENCH_SECONDS);
+    benchSink = sink;
+    return count / seconds_since(start);
+}
+
+// candidates per second of stems of `stemLen` characters, each followed by
+// CROSSOVER_SUFFIXES one-digit suffixes, hashed whole or, with `shared`, finished from a
+// prefix computed once per stem, as process_word() does, the computation included
+static double bench_crossover(const WordView* words, int n, int stemLen, int shared) {
+    int lanes = sha_256_engine_lanes();
+    // a batch spans at most one stem per lane plus the one being started
+    struct sha_256_prefix prefixes[SHA_256_MAX_LANES + 1];
+    const struct sha_256_prefix* batchPrefixes[SHA_256_MAX_LANES];
+    const char* msgs[SHA_256_MAX_LANES];
+    size_t lens[SHA_256_MAX_LANES];
+    char whole[SHA_256_MAX_LANES][MAX_WORD_LENGTH];
+    char stem[MAX_WORD_LENGTH];
+    uint32_t digests[SHA_256_MAX_LANES][8];
+    static const char* DIGITS = "0123456789";
+    unsigned sink = 0;
+    long count = 0;
+    int filled = 0, slot = 0;
+
+    uint64_t start = metrics_now();
+    do {
+        for (int i = 0; i < n; i++) {
+            // the stem output, the word repeated up to the measured length
+            for (int j = 0; j < stemLen; j++) {
+                stem[j] = words[i].ptr[j % words[i].len];
+            }
+            struct sha_256_prefix* prefix = &prefixes[slot];
+            slot = (slot + 1) % (SHA_256_MAX_LANES + 1);
+            if (shared) {
+                sha_256_prefix_init(prefix, stem, stemLen);
+            }
+            for (int k = 0; k < CROSSOVER_SUFFIXES; k++) {
+                if (shared) {
+                    batchPrefixes[filled] = prefix;
+                    msgs[filled] = DIGITS + k;
+                    lens[filled] = 1;
+                }
+                else {
+                    memcpy(whole[filled], stem, stemLen);
+                    whole[filled][stemLen] = DIGITS[k];
+                    msgs[filled] = whole[filled];
+                    lens[filled] = stemLen + 1;
+                }
+                if (++filled < lanes) {
+                    continue;
+                }
+                if (shared) {
+                    sha_256_prefix_batch(batchPrefixes, msgs, lens, lanes, digests);
+                }
+                else {
+                    sha_256_batch(msgs, lens, lanes, digests);
+                }
+                sink += digests[0][0];
+                count += lanes;
+                filled = 0;
+            }
+        }
+    } while (seconds_since(start) < BENCH_SECONDS);
+    benchSink = sink;
+    return count / seconds_since(start);
+}
+
+// words per second the rules turn into candidates, and candidates generated and kept
+// per word, with the repeats and length limit of process_word() but no hashing
+static double bench_rules(const WordView* words, int n, double* generatedPerWord, double* uniquePerWord) {
+    CandidateBuffers buffers;
+    long count = 0, generated = 0, unique = 0;
+    init_candidate_buffers(&buffers);
+    uint64_t start = metrics_now();
+    do {
+        for (int i = 0; i < n; i++) {
+            candidate_set_clear(&buffers.seen);
+            candidate_set_clear(&buffers.stemsSeen);
+            for (int s = 0; s < RULES.numStems; s++) {
+                const RuleStem* stem = &RULES.stems[s];
+                int outLen = apply_stem(s, words[i].ptr, words[i].len, buffers.stems[s]);
+                if (outLen < 0 || !candidate_set_add(&buffers.stemsSeen, buffers.stems[s], outLen,
+                        (const char*)&stem->firstSuffix, sizeof(int))) {
+                    continue;
+                }
+                for (int k = stem->firstSuffix; k < stem->firstSuffix + stem->numSuffixes; k++) {
+                    generated++;
+                    if (outLen + RULES.suffixLens[k] <= MAX_WORD_LENGTH - 1
+                            && candidate_set_add(&buffers.seen, buffers.stems[s], outLen,
+                                RULES.suffixes + RULES.suffixOffsets[k], RULES.suffixLens[k])) {
+                        unique++;
+                    }
+                }
+            }
+        }
+        count += n;
+    } while (seconds_since(start) < BENCH_SECONDS);
+    double elapsed = seconds_since(start);
+    free_candidate_buffers(&buffers);
+    *generatedPerWord = (double)generated / count;
+    *uniquePerWord = (double)unique / count;
+    return count / elapsed;
+}
+
+// fill blocks with words of the dictionary and hand them to the global buffer until
+// the measurement stops
+static void* queue_producer(void* arg) {
+    QueueThread* data = (QueueThread*)arg;
+    DictRange whole = {data->dict->data, data->dict->data + data->dict->size};
+    DictRange range = whole;
+    WordView word;
+
+    while (!atomic_load_explicit(&queueStop, memory_order_relaxed)) {
+        WordBlock* block = acquire_block();
+        while (block->count < MAX_LOCAL_BUFFER_SIZE) {
+            // cycle through the dictionary
+            if (!next_word(&range, &word)) {
+                range = whole;
+                continue;
+            }
+            if (!add_word(block, word.ptr, word.len)) {
+                break;
+            }
+        }
+        writeToBuffer(block);
+    }
+    // the last producer lets the consumers drain the buffer and finish
+    pthread_mutex_lock(&BUFFER.mutex);
+    if (++numProdsDone == data->numProducers) {
+        isDone = 1;
+        pthread_cond_broadcast(&BUFFER.notEmpty);
+    }
+    pthread_mutex_unlock(&BUFFER.mutex);
+    return NULL;
+}
+
+// take blocks from the global buffer and recycle them straight away
+static void* queue_consumer(void* arg) {
+    QueueThread* data = (QueueThread*)arg;
+    WordBlock* block;
+    while ((block = get_block()) != NULL) {
+        data->blocks++;
+        data->words += block->count;
+        release_block(block);
+    }
+    return NULL;
+}
+
+// blocks and words per second through the global buffer with the point's thread counts
+static void bench_queue(const Dictionary* dict, GridPoint* point) {
+    int n = point->producers + point->consumers;
+    QueueThread* data = calloc(n, sizeof(QueueThread));
+    pthread_t* ids = malloc(n * sizeof(pthread_t));
+    struct timespec pause = {(time_t)BENCH_SECONDS, (long)((BENCH_SECONDS - (time_t)BENCH_SECONDS) * 1e9)};
+
+    init_global_buffer();
+    isDone = numProdsDone = 0;
+    atomic_store(&queueStop, 0);
+    uint64_t start = metrics_now();
+    for (int i = 0; i < n; i++) {
+        data[i].dict = dict;
+        data[i].numProducers = point->producers;
+        pthread_create(&ids[i], NULL, i < point->producers ? queue_producer : queue_consumer, &data[i]);
+    }
+    nanosleep(&pause, NULL);
+    atomic_store(&queueStop, 1);
+    for (int i = 0; i < n; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = seconds_since(start);
+
+    long blocks = 0, words = 0;
+    for (int i = point->producers; i < n; i++) {
+        blocks += data[i].blocks;
+        words += data[i].words;
+    }
+    point->blocksPerSecond = blocks / elapsed;
+    point->queueWordsPerSecond = words / elapsed;
+    free_global_buffer();
+    isDone = numProdsDone = 0;
+    free(data);
+    free(ids);
+}
+
+// words and hashes per second of a whole run of this program, returns 0 if it failed
+static int bench_crack(const char* dictPath, const char* hashPath, const char* outPath, GridPoint* point) {
+    char command[8192];
+    char line[1024];
+    char rules[4200] = "";
+    char self[4096];
+    int found = 0;
+
+    // the shell popen() starts would be /proc/self/exe itself, so resolve it first
+    ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len < 0) {
+        return 0;
+    }
+    self[len] = '\0';
+
+    if (OPTIONS.ruleFile != NULL) {
+        snprintf(rules, sizeof(rules), " --rules '%s'", OPTIONS.ruleFile);
+    }
+    snprintf(command, sizeof(command), "'%s' --status-timer 0 --scheduler %s%s%s '%s' '%s' '%s' %d %d",
+        self, OPTIONS.scheduler == SCHED_STEAL ? "steal" : "global", OPTIONS.fused ? " --fused" : "", rules,
+        dictPath, hashPath, outPath, point->producers, point->consumers);
+    FILE* run = popen(command, "r");
+    if (run == NULL) {
+        return 0;
+    }
+    // the run ends with its rates (see main)
+    while (fgets(line, sizeof(line), run) != NULL) {
+        double elapsed;
+        long words;
+        if (sscanf(line, "elapsed: %lf s, %ld words, %lf words/s, %lf hashes/s", &elapsed, &words,
+                &point->wordsPerSecond, &point->hashesPerSecond) == 4) {
+            found = 1;
+        }
+    }
+    return pclose(run) == 0 && found;
+}
+
+// write every result as JSON
+static void write_results(FILE* file, const char* lengths, double sha[4], const double* crossover,
+        int crossoverLength, double rules[3], GridPoint* grid, int numPoints) {
+    fprintf(file, "{\n  \"engine\": \"%s\",\n  \"lanes\": %d,\n", sha_256_engine_name(), sha_256_engine_lanes());
+    fprintf(file, "  \"words\": %ld,\n  \"lengths\": \"%s\",\n  \"num_rules\": %d,\n  \"seconds\": %.3f,\n",
+        OPTIONS.benchWords, lengths, RULES.numRules, BENCH_SECONDS);
+    fprintf(file, "  \"sha256\": {\"scalar_per_s\": %.0f, \"batch_per_s\": %.0f, \"prefix_whole_per_s\": %.0f, "
+        "\"prefix_shared_per_s\": %.0f, \"prefix_speedup\": %.3f},\n", sha[0], sha[1], sha[2], sha[3], sha[3] / sha[2]);
+    fprintf(file, "  \"prefix_crossover\": {\"speedups\": {");
+    for (int i = 0; i < NUM_CROSSOVER_LENGTHS; i++) {
+        fprintf(file, "\"%d\": %.3f%s", CROSSOVER_LENGTHS[i], crossover[i], i + 1 < NUM_CROSSOVER_LENGTHS ? ", " : "");
+    }
+    fprintf(file, "}, \"length\": %d, \"min_shared_prefix_length\": %d},\n", crossoverLength,
+        MIN_SHARED_PREFIX_LENGTH);
+    fprintf(file, "  \"rules\": {\"words_per_s\": %.0f, \"candidates_per_s\": %.0f, \"generated_per_word\": %.3f, "
+        "\"unique_per_word\": %.3f},\n", rules[0], rules[0] * rules[2], rules[1], rules[2]);
+    fprintf(file, "  \"grid\": [\n");
+    for (int i = 0; i < numPoints; i++) {
+        fprintf(file, "    {\"producers\": %d, \"consumers\": %d, \"queue_blocks_per_s\": %.0f, "
+            "\"queue_words_per_s\": %.0f, \"crack_words_per_s\": %.0f, \"crack_hashes_per_s\": %.0f}%s\n",
+            grid[i].producers, grid[i].consumers, grid[i].blocksPerSecond, grid[i].queueWordsPerSecond,
+            grid[i].wordsPerSecond, grid[i].hashesPerSecond, i + 1 < numPoints ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+int run_benchmark() {
+    long weights[MAX_WORD_LENGTH];
+    GridPoint grid[MAX_GRID_POINTS];
+    char dictPath[] = "/tmp/cracker-bench-XXXXXX";
+    char hashPath[] = "/tmp/cracker-bench-XXXXXX";
+    char outPath[] = "/tmp/cracker-bench-XXXXXX";
+    int status = 0;
+
+    if (!parse_lengths(OPTIONS.benchLengths, weights)) {
+        printf("error: invalid length distribution '%s', expected e.g. 8, 6-12 or 6-8:3,12:1 with lengths "
+            "from 1 to %d\n", OPTIONS.benchLengths, MAX_WORD_LENGTH - 2);
+        exit(1);
+    }
+    int numPoints = parse_grid(OPTIONS.benchGrid, grid);
+    if (numPoints == 0) {
+        printf("error: invalid grid '%s', expected e.g. 1x1,2x4 (producers x consumers)\n", OPTIONS.benchGrid);
+        exit(1);
+    }
+    sha_256_engine_init();
+    load_rules(OPTIONS.ruleFile);
+    printf("hash engine: %s (%d %s)\n", sha_256_engine_name(), sha_256_engine_lanes(),
+        sha_256_engine_lanes() == 1 ? "lane" : "lanes");
+    printf("rules:       %d read, %d unique in %d stems\n", RULES.numRules, RULES.numCandidates, RULES.numStems);
+
+    // the synthetic dictionary, and a target no candidate matches so no run stops early
+    int dictFd = mkstemp(dictPath), hashFd = mkstemp(hashPath), outFd = mkstemp(outPath);
+    if (dictFd < 0 || hashFd < 0 || outFd < 0) {
+        printf("error: failed to create the benchmark files in /tmp\n");
+        exit(1);
+    }
+    FILE* file = fdopen(dictFd, "w");
+    write_words(file, OPTIONS.benchWords, weights);
+    fclose(file);
+    file = fdopen(hashFd, "w");
+    fprintf(file, "%064d\n", 0);
+    fclose(file);
+    close(outFd);
+    printf("benchmark:   %ld words of lengths %s, %.1f s per measurement\n", OPTIONS.benchWords,
+        OPTIONS.benchLengths, BENCH_SECONDS);
+
+    // read the words back the way the program does
+    Dictionary dict;
+    DictRange range;
+    WordView word;
+    open_dictionary(dictPath, &dict);
+    WordView* words = malloc(OPTIONS.benchWords * sizeof(WordView));
+    int numWords = 0;
+    range.cursor = dict.data;
+    range.end = dict.data + dict.size;
+    while (numWords < OPTIONS.benchWords && next_word(&range, &word)) {
+        words[numWords++] = word;
+    }
+
+    double sha[4];
+    sha[0] = bench_scalar(words, numWords);
+    sha[1] = bench_batch(words, numWords, 0, 0);
+    sha[2] = bench_batch(words, numWords, 1, 0);
+    sha[3] = bench_batch(words, numWords, 1, 1);
+    printf("sha256:      scalar %.2f MH/s, batch %.2f MH/s, %zu-byte prefix %.2f MH/s shared vs %.2f MH/s "
+        "whole (%.2fx)\n", sha[0] / 1e6, sha[1] / 1e6, strlen(PREFIX), sha[3] / 1e6, sha[2] / 1e6, sha[3] / sha[2]);
+    // the shortest stem output whose shared prefix beats hashing its candidates whole
+    double crossover[NUM_CROSSOVER_LENGTHS];
+    int crossoverLength = 0;
+    printf("prefix:     ");
+    for (int i = 0; i < NUM_CROSSOVER_LENGTHS; i++) {
+        double whole = bench_crossover(words, numWords, CROSSOVER_LENGTHS[i], 0);
+        crossover[i] = bench_crossover(words, numWords, CROSSOVER_LENGTHS[i], 1) / whole;
+        if (crossoverLength == 0 && crossover[i] > 1.0) {
+            crossoverLength = CROSSOVER_LENGTHS[i];
+        }
+        printf(" %d:%.2fx", CROSSOVER_LENGTHS[i], crossover[i]);
+    }
+    printf(", shared from %d bytes (MIN_SHARED_PREFIX_LENGTH %d)\n", crossoverLength, MIN_SHARED_PREFIX_LENGTH);
+    double rules[3];
+    rules[0] = bench_rules(words, numWords, &rules[1], &rules[2]);
+    printf("rule gen:    %.0f words/s, %.2f M candidates/s, %.1f generated and %.1f unique per word\n",
+        rules[0], rules[0] * rules[2] / 1e6, rules[1], rules[2]);
+
+    for (int i = 0; i < numPoints; i++) {
+        bench_queue(&dict, &grid[i]);
+        if (!bench_crack(dictPath, hashPath, outPath, &grid[i])) {
+            printf("error: run with %d producers and %d consumers failed\n", grid[i].producers, grid[i].consumers);
+            status = 1;
+        }
+        printf("grid:        %dx%d, queue %.0f blocks/s (%.2f M words/s), crack %.0f words/s, %.2f MH/s\n",
+            grid[i].producers, grid[i].consumers, grid[i].blocksPerSecond, grid[i].queueWordsPerSecond / 1e6,
+            grid[i].wordsPerSecond, grid[i].hashesPerSecond / 1e6);
+    }
+
+    if (OPTIONS.metricsFile != NULL) {
+        file = fopen(OPTIONS.metricsFile, "w");
+        if (file == NULL) {
+            printf("warning: failed to write the results to '%s'\n", OPTIONS.metricsFile);
+        }
+        else {
+            write_results(file, OPTIONS.benchLengths, sha, crossover, crossoverLength, rules, grid, numPoints);
+            fclose(file);
+            printf("metrics:     %s\n", OPTIONS.metricsFile);
+        }
+    }
+    printf("\n");
+
+    free(words);
+    close_dictionary(&dict);
+    free_rules();
+    unlink(dictPath);
+    unlink(hashPath);
+    unlink(outPath);
+    return status;
+}
@@ -0,0 +1,41 @@
+/** bench.h
+ * This file contains the declarations of the built-in benchmark, run with `--benchmark`
+ * instead of a crack. It generates a synthetic dictionary of `--bench-words` words whose
+ * lengths follow `--bench-lengths`, from a fixed seed so every version of the program
+ * measures the same workload, and a target no candidate can match, so no run stops
+ * early. It then measures each stage of the program on its own:
+ * - sha256: the scalar `calc_sha_256`, the batch API of the selected kernel, and the
+ *   shared-prefix batch API against hashing the same candidates whole.
+ * - prefix: the speedup of the shared prefix for stem outputs of 4 to 32 bytes with ten
+ *   one-digit suffixes each, the prefix computed once per stem, and the shortest of them
+ *   that gains, to check MIN_SHARED_PREFIX_LENGTH against the selected kernel.
+ * - rules: the candidates the rules generate per second, without hashing them.
+ * - queue: the blocks per second moved through the global buffer by empty producers
+ *   and consumers, for every point of `--bench-grid`.
+ * - crack: the words and hashes per second of a whole run of the program on the
+ *   synthetic dictionary, for every point of `--bench-grid`, with the scheduler,
+ *   `--fused` and `--rules` options of the benchmark command.
+ * Each measurement runs for BENCH_SECONDS. The results are printed, and written as JSON
+ * to the `--metrics` file if one is given, so they can be compared between versions.
+ *
+ * The main components of this file include:
+ * - run_benchmark(): Runs every measurement and reports the results.
+ */
+
+#ifndef __BENCH__
+#define __BENCH__
+
+// seconds each measurement runs for, at least
+#define BENCH_SECONDS 1.0
+
+/** run_benchmark()
+ * This function generates the synthetic workload in temporary files, runs every
+ * measurement, prints the results, writes them to the `--metrics` file if one was given
+ * and removes the temporary files. If the length distribution or the grid is invalid,
+ * the function prints an error and exits.
+ *
+ * @return int 0 on success, 1 if a measurement failed.
+ */
+int run_benchmark();
+
+#endif
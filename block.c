@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "block.h"
+#include "balance.h"
+#include "dictionary.h"
+#include "global.h"
+
+WordBlock* acquire_block() {
+    // pop a recycled block off the free list
+    pthread_mutex_lock(&BUFFER.poolMutex);
+    WordBlock* block = BUFFER.freeBlocks;
+    if (block != NULL) {
+        BUFFER.freeBlocks = block->next;
+    }
+    pthread_mutex_unlock(&BUFFER.poolMutex);
+
+    // the pool is empty, allocate a new block with its arena
+    if (block == NULL) {
+        block = malloc(sizeof(WordBlock));
+        block->lens = malloc(MAX_BLOCK_WORDS * sizeof(unsigned char));
+        block->bytes = malloc(BLOCK_ARENA_SIZE * sizeof(char));
+    }
+    block->count = 0;
+    block->capacity = block_words();
+    block->used = 0;
+    block->next = NULL;
+    return block;
+}
+
+int add_word(WordBlock* block, const char* word, int len) {
+    // check if the block has room for one more word
+    if (block->count == block->capacity || block->used + len > BLOCK_ARENA_SIZE) {
+        return 0;
+    }
+    memcpy(block->bytes + block->used, word, len);
+    block->lens[block->count++] = (unsigned char)len;
+    block->used += len;
+    return 1;
+}
+
+void block_word(const WordBlock* block, int index, int* offset, WordView* word) {
+    word->ptr = block->bytes + *offset;
+    word->len = block->lens[index];
+    *offset += word->len;
+}
+
+void release_block(WordBlock* block) {
+    // push the block back onto the free list
+    pthread_mutex_lock(&BUFFER.poolMutex);
+    block->next = BUFFER.freeBlocks;
+    BUFFER.freeBlocks = block;
+    pthread_mutex_unlock(&BUFFER.poolMutex);
+}
+
+void free_block_pool() {
+    while (BUFFER.freeBlocks != NULL) {
+        WordBlock* block = BUFFER.freeBlocks;
+        BUFFER.freeBlocks = block->next;
+        free(block->lens);
+        free(block->bytes);
+        free(block);
+    }
+}
+
+void init_global_buffer() {
+    BUFFER.start = BUFFER.end = BUFFER.count = 0;
+    BUFFER.freeBlocks = NULL;
+    pthread_mutex_init(&BUFFER.mutex, NULL);
+    pthread_mutex_init(&BUFFER.poolMutex, NULL);
+    pthread_cond_init(&BUFFER.notEmpty, NULL);
+    pthread_cond_init(&BUFFER.notFull, NULL);
+    // the circular array holds pointers, the blocks themselves come from the pool
+    BUFFER.buffer = malloc(MAX_GLOBAL_BLOCKS * sizeof(WordBlock*));
+}
+
+void free_global_buffer() {
+    // recycle blocks left queued by an early finish and free the pool
+    while (BUFFER.count > 0) {
+        release_block(BUFFER.buffer[BUFFER.start]);
+        BUFFER.start = (BUFFER.start + 1) % MAX_GLOBAL_BLOCKS;
+        BUFFER.count--;
+    }
+    free_block_pool();
+    pthread_mutex_destroy(&BUFFER.mutex);
+    pthread_mutex_destroy(&BUFFER.poolMutex);
+    pthread_cond_destroy(&BUFFER.notEmpty);
+    pthread_cond_destroy(&BUFFER.notFull);
+    free(BUFFER.buffer);
+    BUFFER.buffer = NULL;
+}
@@ -0,0 +1,105 @@
+/** block.h
+ * This file contains the declarations of the word blocks handed from producer threads to
+ * consumer threads. Instead of moving one word per lock acquisition, a producer packs up
+ * to MAX_LOCAL_BUFFER_SIZE words (or the size picked by `--adaptive`) into a block (their
+ * lengths plus their characters back to back in one arena) and enqueues a single pointer;
+ * a consumer dequeues the whole block in one lock round-trip. Blocks are recycled through
+ * a free-list pool, so after warm-up no memory is allocated while cracking.
+ *
+ * The main components of this file include:
+ * - The `WordBlock` structure, a packed batch of words.
+ * - acquire_block(): Takes an empty block from the pool, allocating one if it is empty.
+ * - add_word(): Appends a word to a block.
+ * - block_word(): Iterates over the words of a block.
+ * - release_block(): Returns a block to the pool.
+ * - free_block_pool(): Frees every pooled block at exit.
+ * - init_global_buffer()/free_global_buffer(): Set up and tear down the global buffer
+ *   and its pool.
+ */
+
+#ifndef __BLOCK__
+#define __BLOCK__
+#include <stdint.h>
+#include "dictionary.h"
+#include "global.h"
+
+// size of a block's arena, enough for a full block of maximum length words
+#define BLOCK_ARENA_SIZE (MAX_LOCAL_BUFFER_SIZE * MAX_WORD_LENGTH)
+// range of words per block `--adaptive` may pick (see balance.h); a block also ends when
+// its arena is full, so larger blocks only hold that many words when they are short
+#define MIN_BLOCK_WORDS (MAX_LOCAL_BUFFER_SIZE / 10)
+#define MAX_BLOCK_WORDS (MAX_LOCAL_BUFFER_SIZE * 4)
+
+/** WordBlock
+ * A batch of words packed into one allocation. Word i starts right after word i - 1
+ * in `bytes`, so the words are read back in order by summing their lengths.
+ */
+typedef struct WordBlock {
+    int count;                   // Number of words in the block
+    int capacity;                // Number of words the block takes, at most MAX_BLOCK_WORDS
+    int used;                    // Number of arena bytes used
+    unsigned char* lens;         // Length of each word (at most MAX_WORD_LENGTH - 2)
+    char* bytes;                 // Arena holding the characters of every word, unterminated
+    struct WordBlock* next;      // Next block in the free-list pool
+    int range;                   // Checkpoint range the words come from (see checkpoint.h)
+    uint64_t seq;                // Number of the block within its range
+} WordBlock;
+
+/** acquire_block()
+ * This function takes an empty block from the global pool, or allocates a new one if the
+ * pool is empty. The block takes the current number of words per block (see block_words()
+ * in balance.h). The number of blocks is bounded by the queue capacity plus one per
+ * thread, so the pool stops growing after warm-up.
+ *
+ * @return WordBlock* An empty block.
+ */
+WordBlock* acquire_block();
+
+/** add_word()
+ * This function appends a word to a block.
+ *
+ * @param block The block to append to.
+ * @param word The characters of the word, not necessarily terminated.
+ * @param len The length of the word.
+ * @return int 1 if the word was added, 0 if the block is full.
+ */
+int add_word(WordBlock*, const char*, int);
+
+/** block_word()
+ * This function returns a view of the next word of a block, in place in its arena. The
+ * caller keeps the arena position in `offset`, which starts at 0 for the first word.
+ *
+ * @param block The block to read from.
+ * @param index Index of the word to read, in order from 0.
+ * @param offset Arena position of the word, advanced past it on return.
+ * @param word Receives the view of the word, valid until the block is released.
+ */
+void block_word(const WordBlock*, int, int*, WordView*);
+
+/** release_block()
+ * This function empties a block and returns it to the global pool.
+ *
+ * @param block The block to release.
+ */
+void release_block(WordBlock*);
+
+/** free_block_pool()
+ * This function frees every block in the global pool. It must only be called after
+ * all threads have been joined and every block has been released.
+ */
+void free_block_pool();
+
+/** init_global_buffer()
+ * This function sets up the global buffer: an empty circular array of
+ * MAX_GLOBAL_BLOCKS blocks, an empty pool and their mutexes and condition variables.
+ */
+void init_global_buffer();
+
+/** free_global_buffer()
+ * This function returns the blocks left queued by an early finish to the pool, frees
+ * the pool and tears down the global buffer. It must only be called after all threads
+ * have been joined.
+ */
+void free_global_buffer();
+
+#endif
@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "checkpoint.h"
+#include "shard.h"
+#include "sink.h"
+#include "block.h"
+#include "dictionary.h"
+#include "hash.h"
+#include "mask.h"
+#include "rules.h"
+#include "targets.h"
+#include "global.h"
+
+// first line of every state file, bumped whenever the format changes
+#define STATE_VERSION "cracker-checkpoint 2"
+// blocks a range can have in flight before its rings grow
+#define INITIAL_RING_CAPACITY 64
+
+// settings of this run written to every state file, see settings()
+static char runSettings[5][4096];
+
+// fingerprint of the parsed mask, a checkpoint is only resumed with the same one
+static uint64_t mask_checksum() {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int p = 0; p < MASK.length; p++) {
+        for (int i = 0; i < MASK.sizes[p]; i++) {
+            hash = (hash ^ (unsigned char)MASK.charsets[p][i]) * 0x100000001b3ULL;
+        }
+        // separate the positions, so moving a character to the next one changes the hash
+        hash = (hash ^ 0x100) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// the thread count that decides the number of ranges: the producers, or the workers
+// of fused and mask mode
+static int* reader_count() {
+    if (OPTIONS.dictFile == NULL || OPTIONS.fused) {
+        return &OPTIONS.numConsumers;
+    }
+    return &OPTIONS.numProducers;
+}
+
+// allocate the ranges and their rings
+static void alloc_ranges(int n) {
+    CHECKPOINT.numRanges = n;
+    CHECKPOINT.ranges = aligned_alloc(64, n * sizeof(ProgressRange));
+    for (int i = 0; i < n; i++) {
+        ProgressRange* range = &CHECKPOINT.ranges[i];
+        range->nextSeq = range->doneSeq = 0;
+        range->capacity = INITIAL_RING_CAPACITY;
+        range->blockEnds = malloc(range->capacity * sizeof(uint64_t));
+        range->blockDone = malloc(range->capacity * sizeof(unsigned char));
+        pthread_mutex_init(&range->mutex, NULL);
+    }
+}
+
+// split a fresh run into one range per reading thread
+static void split_work(const Dictionary* dict, int n) {
+    alloc_ranges(n);
+    if (OPTIONS.dictFile == NULL) {
+        // one contiguous range of this shard's keyspace per worker, the first ones one longer
+        uint64_t start, end;
+        shard_keyspace(&start, &end);
+        uint64_t size = end - start;
+        for (int i = 0; i < n; i++) {
+            CHECKPOINT.ranges[i].start = start;
+            start += size / n + ((uint64_t)i < size % n ? 1 : 0);
+            CHECKPOINT.ranges[i].end = start;
+        }
+    }
+    else {
+        // one newline-aligned range of this shard's slice per reader, as offsets into
+        // the whole dictionary
+        Dictionary slice;
+        DictRange* split = malloc(n * sizeof(DictRange));
+        shard_dictionary(dict, &slice);
+        split_dictionary(&slice, n, split);
+        for (int i = 0; i < n; i++) {
+            CHECKPOINT.ranges[i].start = split[i].cursor - dict->data;
+            CHECKPOINT.ranges[i].end = split[i].end - dict->data;
+        }
+        free(split);
+    }
+    for (int i = 0; i < n; i++) {
+        CHECKPOINT.ranges[i].resume = CHECKPOINT.ranges[i].start;
+        atomic_init(&CHECKPOINT.ranges[i].watermark, CHECKPOINT.ranges[i].start);
+    }
+}
+
+// read a line of the state file without its newline, exits if it is missing
+static void read_line(FILE* file, char* line, int size) {
+    if (fgets(line, size, file) == NULL) {
+        printf("error: checkpoint '%s' is truncated\n", CHECKPOINT.path);
+        exit(1);
+    }
+    line[strcspn(line, "\r\n")] = '\0';
+}
+
+// exit unless a line of the state file records the same setting as this run
+static void expect_line(FILE* file, const char* expected, const char* what) {
+    char line[4096];
+    read_line(file, line, sizeof(line));
+    if (strcmp(line, expected) != 0) {
+        printf("error: checkpoint '%s' was written for a different %s\n", CHECKPOINT.path, what);
+        exit(1);
+    }
+}
+
+// record a cracked target, the caller holds CHECKPOINT.mutex or runs alone
+static void add_cracked(const char* line) {
+    if (CHECKPOINT.numCracked == CHECKPOINT.crackedCapacity) {
+        CHECKPOINT.crackedCapacity = CHECKPOINT.crackedCapacity ? CHECKPOINT.crackedCapacity * 2 : 16;
+        CHECKPOINT.cracked = realloc(CHECKPOINT.cracked, CHECKPOINT.crackedCapacity * sizeof(char*));
+    }
+    CHECKPOINT.cracked[CHECKPOINT.numCracked++] = strdup(line);
+}
+
+// the settings a run is resumed with, one per line in the order of the state file
+static void settings(const Dictionary* dict, char lines[5][4096]) {
+    snprintf(lines[0], sizeof(lines[0]), "dictionary %zu %s", dict->size,
+        OPTIONS.dictFile != NULL ? OPTIONS.dictFile : "-");
+    snprintf(lines[1], sizeof(lines[1]), "rules %016llx", OPTIONS.dictFile != NULL ?
+        (unsigned long long)RULES.checksum : 0ULL);
+    snprintf(lines[2], sizeof(lines[2]), "mask %d %016llx %s", OPTIONS.maskSide,
+        (unsigned long long)mask_checksum(), OPTIONS.mask != NULL ? OPTIONS.mask : "-");
+    snprintf(lines[3], sizeof(lines[3]), "shard %d/%d", OPTIONS.shardIndex + 1, OPTIONS.numShards);
+    // a key-derivation hash has its iterations and takes the salt apart, the side of
+    // the salts only matters to the other algorithms with a salted hash file
+    char iterations[16] = "";
+    if (HASH.saltedBatch != NULL) {
+        snprintf(iterations, sizeof(iterations), " %u", OPTIONS.iterations);
+    }
+    snprintf(lines[4], sizeof(lines[4]), "hash %s%s%s", HASH.name, iterations,
+        !TARGETS.salted || HASH.saltedBatch != NULL ? "" :
+        OPTIONS.saltSide == SALT_PREPEND ? " salt prepend" : " salt append");
+}
+
+// read the ranges and cracked targets of an interrupted run back
+static void load_checkpoint() {
+    FILE* file = fopen(CHECKPOINT.path, "r");
+    if (file == NULL) {
+        printf("error: cannot resume, '%s' is an invalid file\n", CHECKPOINT.path);
+        exit(1);
+    }
+    char line[4096];
+    expect_line(file, STATE_VERSION, "version of the program");
+    expect_line(file, runSettings[0], "dictionary");
+    expect_line(file, runSettings[1], "rule set");
+    expect_line(file, runSettings[2], "mask");
+    expect_line(file, runSettings[3], "shard");
+    expect_line(file, runSettings[4], "hash type, iterations or salt side");
+
+    int n;
+    read_line(file, line, sizeof(line));
+    if (sscanf(line, "ranges %d", &n) != 1 || n < 1) {
+        printf("error: checkpoint '%s' is corrupted\n", CHECKPOINT.path);
+        exit(1);
+    }
+    alloc_ranges(n);
+    for (int i = 0; i < n; i++) {
+        ProgressRange* range = &CHECKPOINT.ranges[i];
+        unsigned long long start, end, watermark;
+        read_line(file, line, sizeof(line));
+        if (sscanf(line, "%llu %llu %llu", &start, &end, &watermark) != 3
+                || start > watermark || watermark > end) {
+            printf("error: checkpoint '%s' is corrupted\n", CHECKPOINT.path);
+            exit(1);
+        }
+        range->start = start;
+        range->end = end;
+        range->resume = watermark;
+        atomic_init(&range->watermark, watermark);
+    }
+
+    // mark every target cracked before the interruption
+    read_line(file, line, sizeof(line));
+    if (sscanf(line, "cracked %d", &n) != 1) {
+        printf("error: checkpoint '%s' is corrupted\n", CHECKPOINT.path);
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        read_line(file, line, sizeof(line));
+        int index = find_target_text(line, NULL);
+        if (index < 0) {
+            continue;
+        }
+        mark_cracked(index);
+        add_cracked(line);
+    }
+    fclose(file);
+}
+
+void init_checkpoint(const Dictionary* dict) {
+    static char defaultPath[4096];
+    CHECKPOINT.path = OPTIONS.stateFile;
+    if (CHECKPOINT.path == NULL) {
+        snprintf(defaultPath, sizeof(defaultPath), "%s.state", OPTIONS.outputFile);
+        CHECKPOINT.path = defaultPath;
+    }
+    CHECKPOINT.base = dict->data;
+    CHECKPOINT.cracked = NULL;
+    CHECKPOINT.numCracked = CHECKPOINT.crackedCapacity = 0;
+    pthread_mutex_init(&CHECKPOINT.mutex, NULL);
+    settings(dict, runSettings);
+
+    int* readers = reader_count();
+    if (!OPTIONS.resume) {
+        split_work(dict, *readers);
+        return;
+    }
+
+    load_checkpoint();
+    // the ranges were split for the interrupted run, so it sets the number of readers
+    if (*readers != CHECKPOINT.numRanges) {
+        printf("resume:      using %d %s, as in the interrupted run\n", CHECKPOINT.numRanges,
+            readers == &OPTIONS.numProducers ? "producers" : "workers");
+        *readers = CHECKPOINT.numRanges;
+    }
+    uint64_t done = 0, total = 0;
+    for (int i = 0; i < CHECKPOINT.numRanges; i++) {
+        done += CHECKPOINT.ranges[i].resume - CHECKPOINT.ranges[i].start;
+        total += CHECKPOINT.ranges[i].end - CHECKPOINT.ranges[i].start;
+    }
+    printf("resume:      %llu of %llu %s done, %d hashes already cracked\n", (unsigned long long)done,
+        (unsigned long long)total, OPTIONS.dictFile != NULL ? "bytes" : "candidates", CHECKPOINT.numCracked);
+}
+
+DictRange checkpoint_range(int index) {
+    DictRange range;
+    range.cursor = CHECKPOINT.base + atomic_load(&CHECKPOINT.ranges[index].watermark);
+    range.end = CHECKPOINT.base + CHECKPOINT.ranges[index].end;
+    return range;
+}
+
+void checkpoint_block_start(WordBlock* block, int index, uint64_t end) {
+    ProgressRange* range = &CHECKPOINT.ranges[index];
+    pthread_mutex_lock(&range->mutex);
+    // every slot holds a block in flight, double the rings keeping each at seq % capacity
+    if (range->nextSeq - range->doneSeq == range->capacity) {
+        uint64_t capacity = range->capacity * 2;
+        uint64_t* blockEnds = malloc(capacity * sizeof(uint64_t));
+        unsigned char* blockDone = malloc(capacity * sizeof(unsigned char));
+        for (uint64_t seq = range->doneSeq; seq < range->nextSeq; seq++) {
+            blockEnds[seq % capacity] = range->blockEnds[seq % range->capacity];
+            blockDone[seq % capacity] = range->blockDone[seq % range->capacity];
+        }
+        free(range->blockEnds);
+        free(range->blockDone);
+        range->blockEnds = blockEnds;
+        range->blockDone = blockDone;
+        range->capacity = capacity;
+    }
+    block->range = index;
+    block->seq = range->nextSeq++;
+    range->blockEnds[block->seq % range->capacity] = end;
+    range->blockDone[block->seq % range->capacity] = 0;
+    pthread_mutex_unlock(&range->mutex);
+}
+
+void checkpoint_block_done(const WordBlock* block) {
+    ProgressRange* range = &CHECKPOINT.ranges[block->range];
+    pthread_mutex_lock(&range->mutex);
+    range->blockDone[block->seq % range->capacity] = 1;
+    // the watermark passes the oldest blocks only once they are all finished
+    while (range->doneSeq < range->nextSeq && range->blockDone[range->doneSeq % range->capacity]) {
+        atomic_store_explicit(&range->watermark, range->blockEnds[range->doneSeq % range->capacity],
+            memory_order_release);
+        range->doneSeq++;
+    }
+    pthread_mutex_unlock(&range->mutex);
+}
+
+void checkpoint_cracked(const char* target, const char* word) {
+    char line[MAX_TARGET_TEXT + MAX_WORD_LENGTH + 2];
+    snprintf(line, sizeof(line), "%s:%s", target, word);
+    pthread_mutex_lock(&CHECKPOINT.mutex);
+    add_cracked(line);
+    pthread_mutex_unlock(&CHECKPOINT.mutex);
+}
+
+// write the state file, replacing the previous one atomically
+static void write_checkpoint() {
+    char tmpPath[4200];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", CHECKPOINT.path);
+    FILE* file = fopen(tmpPath, "w");
+    if (file == NULL) {
+        printf("warning: failed to write checkpoint '%s'\n", tmpPath);
+        return;
+    }
+
+    // read the watermarks before the cracked targets: a hit is queued before its word
+    // is finished, so every hit below a watermark read here is in the list once the
+    // writer of the hits has caught up (see sink.h)
+    fprintf(file, "%s\n%s\n%s\n%s\n%s\n%s\n", STATE_VERSION, runSettings[0], runSettings[1], runSettings[2],
+        runSettings[3], runSettings[4]);
+    fprintf(file, "ranges %d\n", CHECKPOINT.numRanges);
+    for (int i = 0; i < CHECKPOINT.numRanges; i++) {
+        ProgressRange* range = &CHECKPOINT.ranges[i];
+        fprintf(file, "%llu %llu %llu\n", (unsigned long long)range->start, (unsigned long long)range->end,
+            (unsigned long long)atomic_load_explicit(&range->watermark, memory_order_acquire));
+    }
+    sink_sync();
+    pthread_mutex_lock(&CHECKPOINT.mutex);
+    fprintf(file, "cracked %d\n", CHECKPOINT.numCracked);
+    for (int i = 0; i < CHECKPOINT.numCracked; i++) {
+        fprintf(file, "%s\n", CHECKPOINT.cracked[i]);
+    }
+    pthread_mutex_unlock(&CHECKPOINT.mutex);
+
+    // make sure the new state is on disk before it replaces the old one
+    fflush(file);
+    fsync(fileno(file));
+    fclose(file);
+    rename(tmpPath, CHECKPOINT.path);
+}
+
+// the signals handled by the checkpoint thread: interruptions, and SIGUSR1 from main
+static void checkpoint_signals(sigset_t* signals) {
+    sigemptyset(signals);
+    sigaddset(signals, SIGINT);
+    sigaddset(signals, SIGTERM);
+    sigaddset(signals, SIGUSR1);
+}
+
+// write a checkpoint every CHECKPOINT_INTERVAL seconds until main stops the thread, or
+// write a last one and exit when the run is interrupted
+static void* checkpoint_thread(void* arg) {
+    sigset_t signals;
+    struct timespec interval = { CHECKPOINT_INTERVAL, 0 };
+    checkpoint_signals(&signals);
+
+    while (1) {
+        int sig = sigtimedwait(&signals, NULL, &interval);
+        if (sig == SIGUSR1) {
+            break;
+        }
+        if (sig < 0 && errno == EINTR) {
+            continue;
+        }
+        // a streamed dictionary is read once, so it has no progress to save, but its hits
+        // still have to reach the output file
+        if (OPTIONS.stream) {
+            sink_sync();
+        }
+        else {
+            write_checkpoint();
+        }
+        if (sig == SIGINT || sig == SIGTERM) {
+            if (OPTIONS.stream) {
+                printf("\ninterrupted, a streamed dictionary cannot be resumed\n");
+            }
+            else {
+                printf("\ninterrupted, progress saved to %s (continue with --resume)\n", CHECKPOINT.path);
+            }
+            exit(128 + sig);
+        }
+    }
+    return NULL;
+}
+
+void start_checkpoints() {
+    sigset_t signals;
+    checkpoint_signals(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    pthread_create(&CHECKPOINT.thread, NULL, checkpoint_thread, NULL);
+}
+
+void finish_checkpoints() {
+    pthread_kill(CHECKPOINT.thread, SIGUSR1);
+    pthread_join(CHECKPOINT.thread, NULL);
+    // the run is complete, there is nothing left to resume
+    remove(CHECKPOINT.path);
+
+    for (int i = 0; i < CHECKPOINT.numRanges; i++) {
+        free(CHECKPOINT.ranges[i].blockEnds);
+        free(CHECKPOINT.ranges[i].blockDone);
+        pthread_mutex_destroy(&CHECKPOINT.ranges[i].mutex);
+    }
+    free(CHECKPOINT.ranges);
+    for (int i = 0; i < CHECKPOINT.numCracked; i++) {
+        free(CHECKPOINT.cracked[i]);
+    }
+    free(CHECKPOINT.cracked);
+    pthread_mutex_destroy(&CHECKPOINT.mutex);
+}
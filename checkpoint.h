@@ -0,0 +1,140 @@
+/** checkpoint.h
+ * This file contains the declarations of the checkpoints that let a long run be resumed
+ * after it is killed. The work of a run is split into ranges, byte ranges of the
+ * dictionary or index ranges of a mask's keyspace, one per reading thread. Each range
+ * keeps a watermark below which every word (or candidate) has been fully processed, and
+ * a checkpoint thread periodically writes the watermarks, the active rules or mask and
+ * every hash cracked so far to a state file. `--resume` reads the state file back and
+ * continues every range from its watermark.
+ *
+ * In the producer/consumer pipeline, blocks of one range are finished out of order by
+ * different consumers, so the watermark cannot simply follow the consumers. Each block is
+ * numbered when its producer hands it off, and the range keeps a ring of the end offsets
+ * of the blocks still in flight: when a consumer finishes a block it is flagged, and the
+ * watermark only moves past the oldest blocks once every one of them is finished. Fused
+ * and mask workers process their range in order, so they just store their position.
+ *
+ * The state file is replaced atomically (written to a temporary file, synced, then
+ * renamed) every CHECKPOINT_INTERVAL seconds and once more when the run is interrupted
+ * with SIGINT or SIGTERM. It is removed when the run finishes. A run of a streamed
+ * dictionary (see stream.h) writes none, since its input cannot be read again.
+ *
+ * The main components of this file include:
+ * - The `ProgressRange` structure, one range and its watermark.
+ * - The `Checkpoint` structure, every range and the state of the checkpoint thread.
+ * - init_checkpoint(): Splits the work into ranges, or reads them back with `--resume`.
+ * - checkpoint_block_start()/checkpoint_block_done(): Track the blocks of a range.
+ * - checkpoint_cracked(): Records a cracked hash for the state file.
+ * - start_checkpoints()/finish_checkpoints(): Run and stop the checkpoint thread.
+ */
+
+#ifndef __CHECKPOINT__
+#define __CHECKPOINT__
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "dictionary.h"
+#include "block.h"
+
+// seconds between two checkpoints
+#define CHECKPOINT_INTERVAL 10
+
+/** ProgressRange
+ * One range of the work, read by a single thread. Positions are byte offsets in the
+ * dictionary, or keyspace indices in a mask attack. Each range sits on its own cache
+ * lines, since its thread updates the watermark as it goes.
+ */
+typedef struct {
+    uint64_t start;              // First position of the range
+    uint64_t end;                // One past the last position of the range
+    uint64_t resume;             // Watermark the range was resumed from, `start` on a fresh run
+    atomic_ullong watermark;     // Every position below it has been fully processed
+    uint64_t nextSeq;            // Sequence number of the next block handed off
+    uint64_t doneSeq;            // Sequence number of the oldest block not yet finished
+    uint64_t* blockEnds;         // Ring of the end position of every block in flight
+    unsigned char* blockDone;    // Ring of the finished flag of every block in flight
+    uint64_t capacity;           // Size of both rings, grown when more blocks are in flight
+    pthread_mutex_t mutex;       // Mutex protecting the rings
+} __attribute__((aligned(64))) ProgressRange;
+
+/** Checkpoint
+ * Every range of the run, the hashes cracked so far and the checkpoint thread.
+ */
+typedef struct {
+    char* path;                  // Path of the state file
+    ProgressRange* ranges;       // One range per reading thread
+    int numRanges;               // Number of ranges
+    const char* base;            // Start of the mapped dictionary, offsets are relative to it
+    char** cracked;              // Every cracked target as hash:password
+    int numCracked;              // Number of entries in `cracked`
+    int crackedCapacity;         // Allocated size of `cracked`
+    pthread_mutex_t mutex;       // Mutex protecting `cracked`
+    pthread_t thread;            // Thread writing the checkpoints
+} Checkpoint;
+
+// progress of the run, written to the state file
+extern Checkpoint CHECKPOINT;
+
+/** init_checkpoint()
+ * This function splits the work of the run into one range per reading thread: the
+ * producers, or the workers in fused and mask mode. With `--resume`, the ranges and the
+ * cracked hashes are read back from the state file instead, and the cracked targets are
+ * marked as such. The number of reading threads is then taken from the state file. If the
+ * state file cannot be read or was written for a different dictionary, rule set, mask,
+ * shard, hash type or salt side, the function prints an error and exits. It must be
+ * called after the targets, rules and mask are loaded and the global buffer is
+ * initialized.
+ *
+ * @param dict The mapped dictionary, empty in a plain mask attack.
+ */
+void init_checkpoint(const Dictionary*);
+
+/** checkpoint_range()
+ * This function returns the part of a dictionary range that is left to scan.
+ *
+ * @param index Index of the range.
+ * @return DictRange The range from its watermark to its end.
+ */
+DictRange checkpoint_range(int);
+
+/** checkpoint_block_start()
+ * This function numbers a block as the next one of its range before it is handed off.
+ * Blocks of a range must be started in order, by its single producer.
+ *
+ * @param block The block, which records its range and number.
+ * @param range Index of the range the words of the block come from.
+ * @param end Offset just past the last word of the block.
+ */
+void checkpoint_block_start(WordBlock*, int, uint64_t);
+
+/** checkpoint_block_done()
+ * This function records that every word of a block has been processed, and moves the
+ * watermark of its range past every finished block that no older block holds back.
+ *
+ * @param block The finished block.
+ */
+void checkpoint_block_done(const WordBlock*);
+
+/** checkpoint_cracked()
+ * This function records a cracked target for the state file.
+ *
+ * @param target The target as written in the hash file, hash or hash:salt.
+ * @param word The password.
+ */
+void checkpoint_cracked(const char*, const char*);
+
+/** start_checkpoints()
+ * This function starts the checkpoint thread. SIGINT and SIGTERM are blocked in the
+ * calling thread, and so in every thread it creates afterwards, so that only the
+ * checkpoint thread receives them: it then writes a last checkpoint and exits.
+ */
+void start_checkpoints();
+
+/** finish_checkpoints()
+ * This function stops the checkpoint thread once the run is finished, removes the state
+ * file and frees the ranges.
+ */
+void finish_checkpoints();
+
+#endif
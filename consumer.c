@@ -1,153 +1,551 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <pthread.h>
-#include <stdint.h>
-#include "sha-256.h"
-#include "consumer.h"
-#include "global.h"
-
-char* get_word() {
-    // Declare a static buffer for the word
-    static char tempWord[MAX_WORD_LENGTH];
-
-    // Acquire lock
-    pthread_mutex_lock(&BUFFER.mutex);
-
-    // While conditions are not met
-    while (BUFFER.count == 0 && !isDone && !isFound) {
-        // Wait for buffer to have data to process
-        pthread_cond_wait(&BUFFER.notEmpty, &BUFFER.mutex);
-    }
-    if (isFound || (isDone && BUFFER.count == 0)) {
-        pthread_mutex_unlock(&BUFFER.mutex);
-        return NULL;
-    }
-
-    // Pop word from end of the buffer and update global variables
-    BUFFER.end = (BUFFER.end - 1 + MAX_GLOBAL_BUFFER_SIZE) % MAX_GLOBAL_BUFFER_SIZE;
-    strcpy(tempWord, BUFFER.buffer[BUFFER.end]);
-    BUFFER.count--;
-
-    // Signal a producer and unlock mutex
-    pthread_cond_signal(&BUFFER.notFull);
-    pthread_mutex_unlock(&BUFFER.mutex);
-
-    // Return static buffer
-    return tempWord;
-}
-
-void get_variants(char* word, char variants[88][MAX_WORD_LENGTH]) {
-    // Start all 8 words at the base word
-    for (int i = 0; i < 8; i++) {
-        strcpy(variants[i], word);
-    }
-
-    // Loop through to get the 8 permutations
-    for (int j = 0; j < strlen(word); j++) {
-        if (word[j] == 'i') {
-            variants[1][j] = '!';
-            variants[3][j] = '!';
-            variants[5][j] = '!';
-            variants[7][j] = '!';
-        }
-        if (word[j] == 'l') {
-            variants[2][j] = '1';
-            variants[3][j] = '1';
-            variants[6][j] = '1';
-            variants[7][j] = '1';
-        }
-        if (word[j] == 'o') {
-            variants[4][j] = '0';
-            variants[5][j] = '0';
-            variants[6][j] = '0';
-            variants[7][j] = '0';
-        }
-    }
-
-    // Add trailing digits to variants
-    int index;
-    for (int i = 0; i < 8; i++) { 
-        for (int j = 0; j < 10; j++) { 
-            index = 8 + i * 10 + j;
-            sprintf(variants[index], "%s%d", variants[i], j); 
-        }
-    }
-}
-
-char* process_word(char* word) {
-    // store all of the generated variants in this array
-    char variants[88][MAX_WORD_LENGTH];
-    // store the hashed value
-    char hash[65];
-    // store the target word
-    static char correct[MAX_WORD_LENGTH];
-
-    // get the variants
-    get_variants(word, variants);
-
-    // loop through all variants
-    for (int i = 0; i < 88; i++) {
-        // convert the input word to the hashed value
-        sha_256_string(hash, variants[i], strlen(variants[i]));
-        // acquire lock
-        pthread_mutex_lock(&BUFFER.mutex);
-        if (strcmp(hash, TARGET) == 0) {
-            // output to user
-            printf("Correct password has been found!\npassword: %s\n", variants[i]);
-            // change flag
-            isFound = 1;
-            // store the correct password
-            strcpy(correct, variants[i]);
-            // signal all waiting consumers
-            pthread_cond_broadcast(&BUFFER.notFull);
-            pthread_cond_broadcast(&BUFFER.notEmpty);
-            pthread_mutex_unlock(&BUFFER.mutex);
-            // return the correct password
-            return correct;
-        }
-        // release lock
-        pthread_mutex_unlock(&BUFFER.mutex);
-    }
-    // return NULL if nothing was found
-    return NULL;
-}
-
-void output_to_file(char* outfile, char* word){
-    // open outfile
-    FILE* file = fopen(outfile, "w");
-    if (file == NULL) {
-        printf("Failed to open file\n");
-        exit(1);
-    }
-    fprintf(file, "%s\n", word);
-    fclose(file);
-}
-
-void* consumer(void* arg) {
-    struct consumerData* con_arg = (struct consumerData*)arg;
-    char* filename = con_arg->outputFileName;
-
-    while (1) {
-        char* word = get_word();
-        // this means either buffer is empty or ending condition was met
-        if (word == NULL) {
-            pthread_mutex_lock(&BUFFER.mutex);
-            // one of the ending conditions, exit the program
-            if (isFound || (isDone && BUFFER.count == 0)) {
-                pthread_mutex_unlock(&BUFFER.mutex);
-                pthread_exit(NULL);
-            }
-            pthread_mutex_unlock(&BUFFER.mutex);
-        } 
-        // else, consume the word
-        else {
-            char* found_word = process_word(word);
-            if (found_word != NULL) {
-                // output to file, free memory, exit thread
-                output_to_file(filename, found_word);
-                pthread_exit(NULL);
-            }
-        }
-    }
-}
\ No newline at end of file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "sha-256.h"
+#include "sha-256-simd.h"
+#include "consumer.h"
+#include "sink.h"
+#include "topology.h"
+#include "balance.h"
+#include "block.h"
+#include "checkpoint.h"
+#include "dictionary.h"
+#include "hash.h"
+#include "jobs.h"
+#include "mask.h"
+#include "metrics.h"
+#include "rules.h"
+#include "steal.h"
+#include "targets.h"
+#include "global.h"
+
+WordBlock* get_block() {
+    // Acquire lock, timing the wait and hold for the metrics
+    uint64_t acquired = metrics_lock(&BUFFER.mutex);
+    uint64_t waited = 0;
+
+    // While conditions are not met
+    while (BUFFER.count == 0 && !isDone && !isFound) {
+        // Wait for buffer to have data to process
+        waited += metrics_wait(&BUFFER.notEmpty, &BUFFER.mutex, METRIC_EMPTY_WAIT);
+    }
+    if (isFound || (isDone && BUFFER.count == 0)) {
+        metrics_unlock(&BUFFER.mutex, acquired, waited);
+        return NULL;
+    }
+
+    // Pop block from start of the buffer and update global variables
+    WordBlock* block = BUFFER.buffer[BUFFER.start];
+    BUFFER.start = (BUFFER.start + 1) % MAX_GLOBAL_BLOCKS;
+    BUFFER.count--;
+
+    // Signal a producer and unlock mutex
+    pthread_cond_signal(&BUFFER.notFull);
+    metrics_unlock(&BUFFER.mutex, acquired, waited);
+
+    // Return the whole block
+    return block;
+}
+
+/** CandidateBatch
+ * Candidates waiting to be hashed together. Each lane keeps the stem output and suffix
+ * the candidate was built from, so a hit can be reported as a whole password, and the
+ * salt it was hashed with. A staged batch copies every message into `whole` and keeps
+ * the password as its stem, so it outlives the word.
+ */
+typedef struct CandidateBatch {
+    int count;
+    const char* msgs[HASH_MAX_LANES];                       // Whole candidate, or tail after a prefix
+    size_t lens[HASH_MAX_LANES];                            // Length of each message
+    const struct sha_256_prefix* prefixes[HASH_MAX_LANES];  // Shared SHA-256 prefix of each lane, if any
+    const char* stems[HASH_MAX_LANES];                      // Stem output of each candidate
+    int stemLens[HASH_MAX_LANES];                           // Length of each stem output
+    const char* suffixes[HASH_MAX_LANES];                   // Suffix of each candidate
+    int suffixLens[HASH_MAX_LANES];                         // Length of each suffix
+    int salts[HASH_MAX_LANES];                              // Salt of each candidate
+    char whole[HASH_MAX_LANES][MAX_WORD_LENGTH + MAX_SALT_LENGTH]; // Storage for joined messages
+} CandidateBatch;
+
+void init_candidate_buffers(CandidateBuffers* buffers) {
+    buffers->stems = malloc(RULES.numStems * sizeof(*buffers->stems));
+    buffers->prefixes = malloc(RULES.numStems * sizeof(struct sha_256_prefix));
+    buffers->candidates = malloc(RULES.numCandidates * sizeof(Candidate));
+    candidate_set_init(&buffers->seen, RULES.numCandidates);
+    candidate_set_init(&buffers->stemsSeen, RULES.numStems);
+    buffers->numHashes = 0;
+    // one staging batch per message length up to the longest single block, and one for
+    // the longer messages
+    int longest = HASH.maxSingleBlock < MAX_WORD_LENGTH + MAX_SALT_LENGTH - 1 ? HASH.maxSingleBlock :
+        MAX_WORD_LENGTH + MAX_SALT_LENGTH - 1;
+    buffers->numStaged = longest + 2;
+    buffers->staged = malloc(buffers->numStaged * sizeof(CandidateBatch));
+    for (int i = 0; i < buffers->numStaged; i++) {
+        buffers->staged[i].count = 0;
+    }
+}
+
+void free_candidate_buffers(CandidateBuffers* buffers) {
+    free(buffers->stems);
+    free(buffers->prefixes);
+    free(buffers->candidates);
+    candidate_set_free(&buffers->seen);
+    candidate_set_free(&buffers->stemsSeen);
+    free(buffers->staged);
+}
+
+// look every digest of a batch up in the target set and report new hits,
+// returns the number of targets newly cracked
+static int check_batch(const uint32_t* digests, const CandidateBatch* batch, FILE* outfile) {
+    int cracked = 0;
+    for (int i = 0; i < batch->count; i++) {
+        // look the digest up without holding the lock,
+        // most misses are rejected on the first digest word
+        int index = find_target(digests + i * HASH.digestWords, batch->salts[i]);
+        if (index < 0) {
+            continue;
+        }
+        // record the hit unless another consumer beat us to it
+        if (mark_cracked(index)) {
+            // rebuild the password from its stem output and suffix
+            char password[MAX_WORD_LENGTH];
+            memcpy(password, batch->stems[i], batch->stemLens[i]);
+            memcpy(password + batch->stemLens[i], batch->suffixes[i], batch->suffixLens[i]);
+            password[batch->stemLens[i] + batch->suffixLens[i]] = '\0';
+            output_to_file(outfile, index, password);
+            cracked++;
+        }
+    }
+    return cracked;
+}
+
+// hash a batch of whole candidates or of shared-prefix candidates and empty it,
+// returns the number of targets newly cracked
+static int flush_batch(CandidateBatch* batch, int prefixed, CandidateBuffers* buffers, FILE* outfile) {
+    uint32_t digests[HASH_MAX_LANES * HASH_MAX_WORDS];
+    if (batch->count == 0) {
+        return 0;
+    }
+    if (prefixed) {
+        sha_256_prefix_batch(batch->prefixes, batch->msgs, batch->lens, batch->count, (uint32_t (*)[8])digests);
+    }
+    else {
+        HASH.batch(batch->msgs, batch->lens, batch->count, digests);
+    }
+    buffers->numHashes += batch->count;
+    metrics_add(METRIC_HASHES, batch->count);
+    int cracked = check_batch(digests, batch, outfile);
+    batch->count = 0;
+    return cracked;
+}
+
+// the message of a lane from its three parts, copied into `storage` unless a single part
+// holds all of it, returns the message and its length in `len`
+static const char* join_parts(char* storage, const char* const parts[3], const int lens[3], size_t* len) {
+    int nonEmpty = 0, last = 0;
+    *len = 0;
+    for (int p = 0; p < 3; p++) {
+        if (lens[p] > 0) {
+            nonEmpty++;
+            last = p;
+        }
+        *len += lens[p];
+    }
+    if (nonEmpty <= 1) {
+        return parts[last];
+    }
+    size_t at = 0;
+    for (int p = 0; p < 3; p++) {
+        memcpy(storage + at, parts[p], lens[p]);
+        at += lens[p];
+    }
+    return storage;
+}
+
+// run every rule stem on the word and list its distinct candidates in `buffers`, with the
+// shared prefix of the stems worth one when `prefixes` is set, or in a hybrid attack hash
+// each of them with the whole mask instead; returns the number of candidates listed
+static int list_candidates(CandidateBuffers* buffers, const char* word, int len, int prefixes, FILE* outfile,
+        int* cracked) {
+    // number of candidates the rules generated, repeats included
+    int generated = 0;
+    // number of distinct candidates listed for the salts
+    int numCandidates = 0;
+
+    candidate_set_clear(&buffers->seen);
+    candidate_set_clear(&buffers->stemsSeen);
+
+    // generate every candidate of the word once, whatever the number of salts
+    for (int s = 0; s < RULES.numStems; s++) {
+        const RuleStem* stem = &RULES.stems[s];
+        char* out = buffers->stems[s];
+        int outLen = apply_stem(s, word, len, out);
+        // the rule rejected the word
+        if (outLen < 0) {
+            continue;
+        }
+        // an earlier stem produced the same output with the same suffixes, so every
+        // candidate of this one is a repeat (e.g. a substitution of a missing letter)
+        if (!candidate_set_add(&buffers->stemsSeen, out, outLen, (const char*)&stem->firstSuffix, sizeof(int))) {
+            continue;
+        }
+        // short outputs fix too few rounds for a shared prefix to pay off, and a single
+        // suffix would not share it at all
+        int share = prefixes && outLen >= MIN_SHARED_PREFIX_LENGTH && stem->numSuffixes > 2;
+        int prefixReady = 0;
+
+        for (int k = stem->firstSuffix; k < stem->firstSuffix + stem->numSuffixes; k++) {
+            const char* suffix = RULES.suffixes + RULES.suffixOffsets[k];
+            int suffixLen = RULES.suffixLens[k];
+            generated++;
+            // skip candidates too long to store and candidates another rule already produced
+            if (outLen + suffixLen > MAX_WORD_LENGTH - 1
+                    || !candidate_set_add(&buffers->seen, out, outLen, suffix, suffixLen)) {
+                continue;
+            }
+
+            if (MASK.length > 0) {
+                // hybrid attack: the candidate is the fixed part of a whole mask of them
+                char candidate[MAX_WORD_LENGTH];
+                atomic_ullong hashed;
+                memcpy(candidate, out, outLen);
+                memcpy(candidate + outLen, suffix, suffixLen);
+                atomic_init(&hashed, 0);
+                *cracked += hash_mask_range(candidate, outLen + suffixLen, 0, MASK.keyspace, outfile, &hashed);
+                buffers->numHashes += atomic_load_explicit(&hashed, memory_order_relaxed);
+                continue;
+            }
+            Candidate* candidate = &buffers->candidates[numCandidates++];
+            candidate->stem = s;
+            candidate->stemLen = outLen;
+            candidate->suffix = suffix;
+            candidate->suffixLen = suffixLen;
+            candidate->shared = share && suffixLen > 0;
+            // precompute the stem's prefix the first time one of its candidates needs it
+            if (candidate->shared && !prefixReady) {
+                sha_256_prefix_init(&buffers->prefixes[s], out, outLen);
+                prefixReady = 1;
+            }
+        }
+    }
+    metrics_add(METRIC_CANDIDATES, generated);
+    return numCandidates;
+}
+
+// copy the three parts of a message into a staged lane
+static size_t copy_parts(char* storage, const char* const parts[3], const int lens[3]) {
+    size_t at = 0;
+    for (int p = 0; p < 3; p++) {
+        memcpy(storage + at, parts[p], lens[p]);
+        at += lens[p];
+    }
+    return at;
+}
+
+int flush_candidates(CandidateBuffers* buffers, FILE* outfile) {
+    int cracked = 0;
+    for (int i = 0; i < buffers->numStaged; i++) {
+        // once every target is cracked the staged candidates are simply dropped
+        if (isFound) {
+            buffers->staged[i].count = 0;
+        }
+        cracked += flush_batch(&buffers->staged[i], 0, buffers, outfile);
+    }
+    return cracked;
+}
+
+int process_word(CandidateBuffers* buffers, const char* word, int len, FILE* outfile) {
+    // candidates finishing a shared prefix, which only lasts as long as the word
+    CandidateBatch prefixed;
+    // number of candidates hashed per pass of the selected kernel
+    int lanes = HASH.lanes;
+    // a prepended salt is the shared SHA-256 prefix of every candidate hashed with it,
+    // and it comes before any stem output
+    int saltPrefixes = HASH.type == HASH_SHA256 && OPTIONS.saltSide == SALT_PREPEND;
+    // only SHA-256 has a shared-prefix kernel
+    int prefixes = HASH.type == HASH_SHA256 && !(saltPrefixes && TARGETS.salted);
+    // number of targets cracked by this word
+    int cracked = 0;
+
+    prefixed.count = 0;
+    int numCandidates = list_candidates(buffers, word, len, prefixes, outfile, &cracked);
+
+    // hash the list with one salt after the other: the candidates of a word stay in cache
+    // while each salt is read once per word
+    for (int t = 0; t < TARGETS.numSalts && numCandidates > 0 && !isFound; t++) {
+        const Salt* salt = &TARGETS.salts[t];
+        // every target of this salt has been cracked
+        if (atomic_load_explicit(&salt->numLeft, memory_order_relaxed) == 0) {
+            continue;
+        }
+        for (int c = 0; c < numCandidates; c++) {
+            const Candidate* candidate = &buffers->candidates[c];
+            const char* out = buffers->stems[candidate->stem];
+            const char* parts[3] = { "", "", "" };
+            int partLens[3] = { 0, 0, 0 };
+            CandidateBatch* batch;
+            int i;
+            int saltLen = salt->len;
+
+            if (saltPrefixes && salt->len > 0) {
+                // resume from the salt's state, the candidate is the tail
+                batch = &prefixed;
+                i = batch->count++;
+                batch->prefixes[i] = &salt->prefix;
+                parts[0] = out;
+                partLens[0] = candidate->stemLen;
+                parts[1] = candidate->suffix;
+                partLens[1] = candidate->suffixLen;
+            }
+            else if (candidate->shared) {
+                // resume from the stem's state, the suffix and an appended salt are the tail
+                batch = &prefixed;
+                i = batch->count++;
+                batch->prefixes[i] = &buffers->prefixes[candidate->stem];
+                parts[0] = candidate->suffix;
+                partLens[0] = candidate->suffixLen;
+                parts[1] = salt->text;
+                partLens[1] = salt->len;
+            }
+            else {
+                // a whole message is staged with the messages of its length, of this word
+                // and the next ones, until a full batch of them shares one padding layout
+                int whole = candidate->stemLen + candidate->suffixLen + saltLen;
+                int prepend = OPTIONS.saltSide == SALT_PREPEND;
+                batch = &buffers->staged[whole < buffers->numStaged - 1 ? whole : buffers->numStaged - 1];
+                i = batch->count++;
+                parts[prepend] = out;
+                partLens[prepend] = candidate->stemLen;
+                parts[prepend + 1] = candidate->suffix;
+                partLens[prepend + 1] = candidate->suffixLen;
+                parts[prepend ? 0 : 2] = salt->text;
+                partLens[prepend ? 0 : 2] = saltLen;
+                batch->msgs[i] = batch->whole[i];
+                batch->lens[i] = copy_parts(batch->whole[i], parts, partLens);
+                // the password is the message without its salt
+                batch->stems[i] = batch->whole[i] + (prepend ? saltLen : 0);
+                batch->stemLens[i] = candidate->stemLen + candidate->suffixLen;
+                batch->suffixes[i] = "";
+                batch->suffixLens[i] = 0;
+                batch->salts[i] = t;
+                if (batch->count == lanes) {
+                    cracked += flush_batch(batch, 0, buffers, outfile);
+                }
+                continue;
+            }
+            batch->msgs[i] = join_parts(batch->whole[i], parts, partLens, &batch->lens[i]);
+            batch->stems[i] = out;
+            batch->stemLens[i] = candidate->stemLen;
+            batch->suffixes[i] = candidate->suffix;
+            batch->suffixLens[i] = candidate->suffixLen;
+            batch->salts[i] = t;
+            if (batch->count == lanes) {
+                cracked += flush_batch(batch, 1, buffers, outfile);
+            }
+        }
+    }
+
+    // hash the partial batch of shared prefixes left at the end of the word, the staged
+    // candidates wait for flush_candidates()
+    cracked += flush_batch(&prefixed, 1, buffers, outfile);
+    // return the number of targets cracked
+    return cracked;
+}
+
+// list the candidates of a word into a job, each one whole: a slow hash type takes the
+// salt apart and has no shared prefixes
+static void queue_word(CandidateBuffers* buffers, CandidateJob* job, const char* word, int len, FILE* outfile) {
+    int cracked = 0;
+    int numCandidates = list_candidates(buffers, word, len, 0, outfile, &cracked);
+    for (int c = 0; c < numCandidates; c++) {
+        const Candidate* candidate = &buffers->candidates[c];
+        char text[MAX_WORD_LENGTH];
+        memcpy(text, buffers->stems[candidate->stem], candidate->stemLen);
+        memcpy(text + candidate->stemLen, candidate->suffix, candidate->suffixLen);
+        job_add(job, text, candidate->stemLen + candidate->suffixLen);
+    }
+}
+
+// hash one batch of a job with the salted kernel, returns the number of targets newly cracked
+static int hash_job_batch(const CandidateJob* job, int b, CandidateBuffers* buffers, FILE* outfile) {
+    CandidateBatch batch;
+    const char* saltTexts[HASH_MAX_LANES];
+    size_t saltLens[HASH_MAX_LANES];
+    uint32_t digests[HASH_MAX_LANES * HASH_MAX_WORDS];
+    int t, first;
+    int count = job_batch(job, b, &t, &first);
+    const Salt* salt = &TARGETS.salts[t];
+    // every target of this salt has been cracked
+    if (atomic_load_explicit(&salt->numLeft, memory_order_relaxed) == 0) {
+        return 0;
+    }
+    batch.count = count;
+    for (int i = 0; i < count; i++) {
+        batch.msgs[i] = job->text + job->offsets[first + i];
+        batch.lens[i] = job->lens[first + i];
+        batch.stems[i] = batch.msgs[i];
+        batch.stemLens[i] = job->lens[first + i];
+        batch.suffixes[i] = "";
+        batch.suffixLens[i] = 0;
+        batch.salts[i] = t;
+        saltTexts[i] = salt->text;
+        saltLens[i] = salt->len;
+    }
+    HASH.saltedBatch(batch.msgs, batch.lens, saltTexts, saltLens, count, digests);
+    buffers->numHashes += count;
+    metrics_add(METRIC_HASHES, count);
+    return check_batch(digests, &batch, outfile);
+}
+
+// publish a job of this consumer and hash its batches, while idle consumers take some
+// of them, returns 1 if every batch was hashed
+static int run_job(int id, CandidateJob* job, CandidateBuffers* buffers, FILE* outfile) {
+    int b;
+    publish_job(id, job, HASH.lanes);
+    while ((b = take_batch(job)) >= 0) {
+        hash_job_batch(job, b, buffers, outfile);
+        batch_done(job);
+    }
+    return retire_job(id, job);
+}
+
+// once this consumer is out of words, hash batches of the jobs of the others until the
+// last one is retired
+static void help_jobs(CandidateBuffers* buffers, FILE* outfile) {
+    CandidateJob* job;
+    int b;
+    stop_working();
+    while ((job = help_batch(&b)) != NULL) {
+        hash_job_batch(job, b, buffers, outfile);
+        batch_done(job);
+    }
+}
+
+// take the next block with the selected scheduler
+static WordBlock* next_block(int id) {
+    if (OPTIONS.scheduler == SCHED_STEAL) {
+        return steal_block(id);
+    }
+    return get_block();
+}
+
+void* consumer(void* arg) {
+    struct consumerData* con_arg = (struct consumerData*)arg;
+    FILE* outfile = con_arg->outputFile;
+    CandidateBuffers buffers;
+    CandidateJob job;
+    WordView word;
+    WordBlock* block;
+    // a slow hash type turns every block into a job shared with idle consumers
+    int slow = HASH.saltedBatch != NULL && MASK.length == 0;
+
+    // pin first, so the buffers this consumer allocates are local to it
+    pin_thread(ROLE_CONSUMER, con_arg->id);
+    metrics_register(ROLE_CONSUMER, con_arg->id);
+    init_candidate_buffers(&buffers);
+    job_init(&job);
+
+    // consume blocks until the buffer is drained or every target is cracked
+    while ((block = next_block(con_arg->id)) != NULL) {
+        int offset = 0;
+        int i = 0;
+        job_clear(&job);
+        for (; i < block->count && !isFound; i++) {
+            block_word(block, i, &offset, &word);
+            if (slow) {
+                queue_word(&buffers, &job, word.ptr, word.len, outfile);
+            }
+            else {
+                process_word(&buffers, word.ptr, word.len, outfile);
+            }
+            con_arg->numWords++;
+            metrics_add(METRIC_WORDS, 1);
+        }
+        // the words of a job are only processed once all of its batches are hashed, and
+        // the staged candidates of the others once they are flushed
+        int hashed = slow ? run_job(con_arg->id, &job, &buffers, outfile) : 1;
+        if (!slow) {
+            flush_candidates(&buffers, outfile);
+        }
+        // only a block whose every word was processed moves the checkpoint watermark
+        if (i == block->count && hashed) {
+            checkpoint_block_done(block);
+        }
+        // recycle the block for the producers
+        release_block(block);
+        // with --adaptive this consumer may be parked between two blocks
+        balance_park(ROLE_CONSUMER);
+    }
+    balance_exit(ROLE_CONSUMER);
+    if (slow) {
+        help_jobs(&buffers, outfile);
+    }
+    con_arg->numHashes = buffers.numHashes;
+    job_free(&job);
+    free_candidate_buffers(&buffers);
+    pthread_exit(NULL);
+}
+
+void* fused_worker(void* arg) {
+    struct consumerData* con_arg = (struct consumerData*)arg;
+    FILE* outfile = con_arg->outputFile;
+    DictRange range = con_arg->range;
+    ProgressRange* progress = &CHECKPOINT.ranges[con_arg->id];
+    CandidateBuffers buffers;
+    CandidateJob job;
+    WordView word;
+
+    pin_thread(ROLE_CONSUMER, con_arg->id);
+    metrics_register(ROLE_CONSUMER, con_arg->id);
+    init_candidate_buffers(&buffers);
+    job_init(&job);
+    if (HASH.saltedBatch != NULL && MASK.length == 0) {
+        // a slow hash type reads the slice a block's worth of words at a time, each a job
+        // shared with the idle workers
+        while (!isFound) {
+            int n = 0;
+            job_clear(&job);
+            while (n < MAX_LOCAL_BUFFER_SIZE && !isFound && next_word(&range, &word)) {
+                queue_word(&buffers, &job, word.ptr, word.len, outfile);
+                con_arg->numWords++;
+                metrics_add(METRIC_WORDS, 1);
+                n++;
+            }
+            if (n == 0) {
+                break;
+            }
+            // the watermark follows the cursor once every word before it is hashed
+            if (run_job(con_arg->id, &job, &buffers, outfile)) {
+                atomic_store_explicit(&progress->watermark, range.cursor - CHECKPOINT.base, memory_order_release);
+            }
+        }
+        help_jobs(&buffers, outfile);
+    }
+    else {
+        // read and hash this worker's own slice in place, the only shared state is the stop flag
+        int staged = 0;
+        while (!isFound && next_word(&range, &word)) {
+            process_word(&buffers, word.ptr, word.len, outfile);
+            con_arg->numWords++;
+            metrics_add(METRIC_WORDS, 1);
+            // the staged candidates are flushed every block's worth of words, and words are
+            // processed in order, so the watermark then simply follows the cursor
+            if (++staged == MAX_LOCAL_BUFFER_SIZE) {
+                flush_candidates(&buffers, outfile);
+                atomic_store_explicit(&progress->watermark, range.cursor - CHECKPOINT.base, memory_order_release);
+                staged = 0;
+            }
+        }
+        flush_candidates(&buffers, outfile);
+    }
+    // skipped lines at the end of the range are done as well
+    if (!isFound) {
+        atomic_store_explicit(&progress->watermark, range.end - CHECKPOINT.base, memory_order_release);
+    }
+    con_arg->numHashes = buffers.numHashes;
+    job_free(&job);
+    free_candidate_buffers(&buffers);
+    pthread_exit(NULL);
+}
@@ -1,115 +1,201 @@
-/** consumer.h - Ethan Perry - Dec 6, 2024
- * This file contains the implementation of functions used by consumer threads in the 
- * password cracking program. The consumer threads retrieve words from the global buffer,
- * process them to generate variants and compute hashes, and compare the hashes to a 
- * target hash. If a match is found, the correct password is written to an output file.
- * The file also includes utility functions for managing the global buffer and processing words.
- *
- * The main components of this file include:
- * - get_word(): Retrieves a word from the global buffer in a thread-safe manner.
- * - get_variants(): Generates variants of a given word with character substitutions 
- *   and trailing digits.
- * - process_word(): Processes a word by generating its variants and checking each
- *   variant against a target hash.
- * - output_to_file(): Writes a word to an output file.
- * - consumer(): Consumer thread function that processes words from the global buffer
- *   and writes the found password to a file.
- *
- * The functions in this file ensure thread-safe access to the global buffer and handle 
- * synchronization of producer and consumer threads using mutexes and condition variables.
- */
-
-#ifndef __CONSUMER__
-#define __CONSUMER__
-#include "global.h"
-
-/** consumerData
- * This structure contains the information needed by each consumer thread,
- * specifically the name of the output file where the found password will be written.
- */
-struct consumerData {
-    char* outputFileName;
-};
-
-/** get_word()
- * This function locks the global buffer mutex and retrieves a word from the buffer.
- * If the buffer is empty, the function waits until a word is available. If a consumer
- * has found the password (`isFound` flag is set) or all producers are done and the buffer
- * is empty (`isDone` flag is set), the function returns `NULL`. Once a word is retrieved,
- * the function signals producers that space is available in the buffer and unlocks the mutex.
- *
- * @return char* Pointer to the retrieved word. Returns `NULL` if the password is found or 
- * all producers are done and the buffer is empty.
- */
-char* get_word();
-
-/** get_variants()
- * This function generates 88 variants of a given word by performing character substitutions
- * (e.g., 'i' to '!', 'l' to '1', 'o' to '0') and adding trailing digits (0-9) to the word.
- * The variants are stored in the provided 2D array `variants`.
- *
- * @param word The input word for which variants are to be generated.
- * @param variants A 2D array to store the generated variants. The array should have
- * dimensions [88][MAX_WORD_LENGTH].
- *
- * The function follows these steps:
- * - Initializes the first 8 variants with the base word.
- * - Performs character substitutions to generate 8 base permutations.
- * - Appends trailing digits (0-9) to each base permutation to generate the final 88 variants.
- */
-void get_variants(char*, char[88][MAX_WORD_LENGTH]);
-
-/** process_word()  
- * This function generates 88 variants of the input word using the `get_variants` function,
- * hashes each variant, and compares the hash to a global target hash (`TARGET`). If a variant's
- * hash matches the target hash, the function sets a flag (`isFound`), signals all waiting consumers,
- * and returns the correct password. If no variant matches, the function returns `NULL`.
- *
- * @param word The input word to be processed.
- * @return char* Pointer to the correct password if found, or `NULL` if no match is found.
- *
- * The function follows these steps:
- * - Generates variants of the input word.
- * - Hashes each variant and compares the hash to the target hash.
- * - If a match is found, sets the `isFound` flag, stores the correct password, signals consumers,
- *   and returns the password.
- * - If no match is found, returns `NULL`.
- */
-char* process_word(char*);
-
-/** output_to_file()
- * This function opens the specified output file, writes the given word to it, and
- * then closes the file. If the file cannot be opened, the function prints an error
- * message and exits the program.
- *
- * @param outfile The path to the output file.
- * @param word The word to be written to the output file.
- *
- * The function follows these steps:
- * - Opens the specified output file in write mode.
- * - Checks if the file was successfully opened; if not, prints an error message and exits.
- * - Writes the word to the file.
- * - Closes the file.
- */
-void output_to_file(char*, char*);
-
-/** consumer()
- * This function is executed by consumer threads. Each thread retrieves words from the 
- * global buffer using the `get_word` function, processes the words to find the correct 
- * password, and writes the found password to the specified output file. The function 
- * ensures thread-safe access to the global buffer and handles synchronization using 
- * mutexes and condition variables.
- *
- * @param arg Pointer to a `consumerData` structure containing the output file name.
- * @return void* Always returns NULL.
- *
- * The function follows these steps:
- * - Retrieves words from the global buffer.
- * - Thread exits if the buffer is empty or an ending condition is met (isFound` or isDone)
- * - Processes each word using the `process_word` function.
- * - If the password is found, writes the password to the output file and exits the thread.
- * - Continues processing until an ending condition is met.
- */
-void* consumer(void*);
-
+/** consumer.h - Ethan Perry - Dec 6, 2024
+ * This file contains the implementation of functions used by consumer threads in the
+ * password cracking program. The consumer threads retrieve words from the global buffer,
+ * process them to generate variants and compute hashes, and compare the hashes to a set
+ * of target hashes. Every match is written to an output file as hash:password. The file
+ * also includes utility functions for managing the global buffer and processing words.
+ *
+ * The main components of this file include:
+ * - get_block(): Retrieves a block of words from the global buffer in a thread-safe manner.
+ * - process_word(): Processes a word by running the mangling rules on it (see rules.h)
+ *   and checking each candidate against a target hash.
+ * - consumer(): Consumer thread function that processes words from the global buffer
+ *   and writes every cracked password to a file.
+ * - fused_worker(): Thread function of `--fused` mode, which reads its own slice of the
+ *   dictionary and hashes it without any producer or buffer.
+ *
+ * The functions in this file ensure thread-safe access to the global buffer and handle 
+ * synchronization of producer and consumer threads using mutexes and condition variables.
+ */
+
+#ifndef __CONSUMER__
+#define __CONSUMER__
+#include <stdio.h>
+#include "sha-256.h"
+#include "dictionary.h"
+#include "block.h"
+#include "rules.h"
+#include "global.h"
+
+/** Candidate
+ * One distinct candidate generated from the current word: the output of a rule stem
+ * followed by one of its suffixes.
+ */
+typedef struct {
+    int stem;                         // Index of the stem, whose output is in `stems`
+    int stemLen;                      // Length of the stem output
+    const char* suffix;               // Suffix added to the stem output
+    int suffixLen;                    // Length of the suffix
+    int shared;                       // Flag set if it finishes the stem's shared prefix
+} Candidate;
+
+/** CandidateBuffers
+ * Per-thread scratch space used to turn a word into candidates: the output of every rule
+ * stem, the shared SHA-256 prefix of each stem (with `--hash-type sha256`), the set of
+ * candidates already generated for the word and the list of those candidates, which is
+ * hashed once per salt. It also stages the whole candidates of consecutive words by
+ * message length, one batch per length up to `HASH.maxSingleBlock` and one for longer
+ * messages, so every batch reaches the kernel full and with a single padding layout.
+ * It is allocated once per thread, so no memory is allocated per word.
+ */
+typedef struct {
+    char (*stems)[MAX_WORD_LENGTH];   // Output of each stem for the current word
+    struct sha_256_prefix* prefixes;  // Shared prefix of each stem for the current word
+    Candidate* candidates;            // Distinct candidates of the current word
+    CandidateSet seen;                // Candidates already generated for the current word
+    CandidateSet stemsSeen;           // Stem outputs and suffix lists seen for the current word
+    long numHashes;                   // Number of candidates hashed by the thread
+    struct CandidateBatch* staged;    // Whole candidates waiting for a full batch, by length
+    int numStaged;                    // Number of staging batches
+} CandidateBuffers;
+
+/** consumerData
+ * This structure contains the information needed by each consumer thread,
+ * specifically its index and the output file where cracked passwords will be written.
+ */
+struct consumerData {
+    // index of this consumer thread, which is also the index of its deque
+    int id;
+    FILE* outputFile;
+    // number of dictionary words and of candidates this thread has processed
+    long numWords;
+    long numHashes;
+    // slice of the dictionary read by a fused worker (unused by pipeline consumers)
+    DictRange range;
+};
+
+/** get_block()
+ * This function locks the global buffer mutex and dequeues a whole block of words from
+ * the buffer, so one lock round-trip yields up to MAX_LOCAL_BUFFER_SIZE words (up to
+ * MAX_BLOCK_WORDS with `--adaptive`). If the buffer is empty, the function waits until a
+ * block is available. If every target has been cracked (`isFound` flag is set) or all
+ * producers are done and the buffer is empty (`isDone` flag is set), the function returns
+ * `NULL`. Once a block is retrieved, the function signals producers that space is
+ * available in the buffer and unlocks the mutex. The caller must return the block to the
+ * pool with `release_block` when done with it. The time spent waiting for and holding the
+ * mutex is counted in the caller's metrics (see metrics.h).
+ *
+ * @return WordBlock* The retrieved block. Returns `NULL` if every target is cracked
+ * or all producers are done and the buffer is empty.
+ */
+WordBlock* get_block();
+
+/** init_candidate_buffers()
+ * This function allocates a thread's scratch space for the candidates of a word, sized
+ * for the compiled rules in `RULES`. It must be called after `load_rules`.
+ *
+ * @param buffers The scratch space to allocate.
+ */
+void init_candidate_buffers(CandidateBuffers*);
+
+/** free_candidate_buffers()
+ * This function releases a thread's scratch space.
+ *
+ * @param buffers The scratch space to free.
+ */
+void free_candidate_buffers(CandidateBuffers*);
+
+/** process_word()
+ * This function turns the input word into candidates by running every compiled rule on it
+ * (see rules.h), hashes the candidates in lane-sized batches with the batch kernel of the
+ * selected algorithm (`HASH.batch`, see hash.h), and looks each raw digest up in the
+ * global target set (`TARGETS`). Each rule stem is run once and its suffixes are added to
+ * its output; with SHA-256, when the output is at least MIN_SHARED_PREFIX_LENGTH
+ * characters and has several suffixes, it is precomputed once as a shared SHA-256 prefix,
+ * so each suffixed candidate only finishes the rounds that depend on its suffix. A
+ * candidate already generated for the word by another rule is skipped, so it is never
+ * hashed twice, and a stem whose output and suffixes repeat an earlier stem's is skipped
+ * as a whole. In a hybrid attack (`--mask` with a dictionary) every candidate is instead
+ * joined to the whole mask and hashed with `hash_mask_range` (see mask.h). The candidates
+ * of the word are generated once into a list, which is then hashed with every salt of the
+ * hash file whose targets are not all cracked, salt by salt: the list is small and stays
+ * in cache while each salt is read once per word. A prepended salt with SHA-256 starts
+ * from the state precomputed for it (see targets.h) instead of a stem's prefix. An
+ * unsalted hash file has a single, empty salt. Every candidate whose hash matches a
+ * target that has not been cracked yet is marked as cracked and queued for the output
+ * file (see sink.h). When the last target is cracked, the `isFound` flag is set and all
+ * waiting threads are signaled.
+ *
+ * @param buffers The calling thread's scratch space, whose hash count is updated.
+ * @param word The characters of the input word, not necessarily terminated.
+ * @param len The length of the word.
+ * @param outfile The output file where cracked passwords are written.
+ * @return int Number of targets newly cracked by this word.
+ *
+ * The function follows these steps:
+ * - Runs each rule stem on the word and lists each of its new suffixed candidates.
+ * - For every salt, stages each candidate joined to the salt in the batch of whole
+ *   candidates of its length, or adds it to the word's batch of shared-prefix candidates.
+ * - Hashes each batch once it holds `HASH.lanes` candidates; the remainder of the
+ *   shared-prefix batch at the end of the word, and the staged remainders when the
+ *   thread calls flush_candidates().
+ * - Looks each digest up in the target set.
+ * - For each new match, marks the target as cracked and reports it as hash:password.
+ */
+int process_word(CandidateBuffers*, const char*, int, FILE*);
+
+/** flush_candidates()
+ * This function hashes the whole candidates that process_word() staged and that are still
+ * waiting for a full batch, one partial batch per length. A thread calls it at the end of
+ * every block (or block's worth of words), so staged candidates never wait longer than a
+ * block and are hashed before the block counts as done for the checkpoint. Once every
+ * target is cracked, the staged candidates are dropped instead.
+ *
+ * @param buffers The calling thread's scratch space.
+ * @param outfile The output file where cracked passwords are written.
+ * @return int Number of targets newly cracked.
+ */
+int flush_candidates(CandidateBuffers*, FILE*);
+
+/** consumer()
+ * This function is executed by consumer threads. Each thread retrieves blocks of words
+ * from the global buffer using the `get_block` function (or from its own deque with
+ * `steal_block` under `--scheduler steal`) and processes the words to crack as many
+ * target hashes as possible, writing every hit to the specified output file. The function
+ * ensures thread-safe access to the global buffer and handles synchronization using
+ * mutexes and condition variables.
+ *
+ * @param arg Pointer to a `consumerData` structure containing the index and output file.
+ * @return void* Always returns NULL.
+ *
+ * The function follows these steps:
+ * - Retrieves a block of words from the global buffer.
+ * - Thread exits if an ending condition is met (`isFound` or `isDone` with an empty
+ *   buffer).
+ * - Processes each word of the block using the `process_word` function, then recycles it.
+ * - Continues processing until an ending condition is met.
+ *
+ * With a slow hash type (`HASH.saltedBatch`, e.g. PBKDF2) outside a hybrid attack, the
+ * candidates of every word of the block are listed into a job instead, which the consumer
+ * publishes and hashes batch by batch with any idle consumer's help (see jobs.h). Once it
+ * is out of blocks, the consumer helps hash the jobs of the others until the last one is
+ * retired.
+ */
+void* consumer(void*);
+
+/** fused_worker()
+ * This function is executed by the worker threads of `--fused` mode, which replaces the
+ * producer/consumer pipeline for fast storage. Each worker scans its own byte range of
+ * the memory-mapped dictionary and processes every word as soon as it is read, so there
+ * is no global buffer, no block hand-off and no copy beyond terminating the word. The
+ * only state shared between workers is the `isFound` flag and the target set, whose
+ * targets are marked cracked without a lock. With a slow hash type the worker gathers a
+ * block's worth of words into a job and shares it as consumer() does.
+ *
+ * @param arg Pointer to a `consumerData` structure containing the index, output file
+ * and dictionary range.
+ * @return void* Always returns NULL.
+ */
+void* fused_worker(void*);
+
 #endif
\ No newline at end of file
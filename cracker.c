@@ -1,154 +1,327 @@
-/** main.c - Ethan Perry - Dec 6, 2024
- * The main function initializes global structures, creates producer and consumer threads,
- * and coordinates their execution to perform the password cracking task. The program reads
- * command-line arguments to set up the number of producer and consumer threads, processes
- * input files to read the dictionary and target hash, and handles synchronization between
- * threads using mutexes and condition variables. The program ensures proper resource 
- * management by dynamically allocating and freeing memory for buffers, thread data 
- * structures, and thread IDs. It also manages the lifetime of the global buffer and 
- * ensures that all threads complete their tasks before exiting.
- *
- * Usage:
- * ./password_cracker <dictionary_file> <target_file> <out_file> <num_prods> <num_cons>
- */
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <pthread.h>
-#include <stdint.h>
-#include "sha-256.h"
-#include "cracker_cmd.h"
-#include "producer.h"
-#include "consumer.h"
-#include "global.h"
-
-// global variables 
-// (see global.h for comments)
-GlobalBuffer BUFFER;
-char TARGET[65];
-int isFound = 0;
-int numProdsDone = 0;
-int isDone = 0;
-
-/** main(argv, argc)
- * This function initializes global variables, sets up synchronization primitives,
- * creates and starts producer and consumer threads, and waits for all threads to complete.
- * It parses command-line arguments to get the names of input and output files, and the number
- * of producer and consumer threads to create. It ensures proper initialization of the global
- * buffer and associated synchronization primitives, and handles resource cleanup upon completion.
- *
- * @param argv Number of command-line arguments.
- * @param argc Array of command-line arguments.
- *             argc[1]: Dictionary file path
- *             argc[2]: Target file path
- *             argc[3]: Output file path
- *             argc[4]: Number of producer threads
- *             argc[5]: Number of consumer threads
- * @return int Returns 0 on successful completion.
- *
- * @note The function exits with an error message if the number of command-line arguments 
- * is incorrect, or if there are invalid thread number inputs.
- */
-int main (int argv, char** argc) {
-    // for formatting
-    printf("\n");
-    // error check amount of input
-    if (argv != 6) {
-        printf("Error: incorrect number of input parameters\n");
-        exit(1);
-    }
-
-    // store and check values
-    int nProds = atoi(argc[4]);
-    int nCons = atoi(argc[5]);
-    // check if they are greater than 0
-    if (nProds < 1 || nCons < 1) {
-        printf("Invalid thread number input\n");
-        exit(1);
-    }
-
-    // declare outfile name
-    char* outputFile = argc[3];
-
-    // parse command line and check files
-    FILE* dict = parse_cmd(argc);
-
-    // initialize all data related to the global BUFFER
-    BUFFER.start = BUFFER.end = BUFFER.count = 0;
-    
-    pthread_mutex_init(&BUFFER.mutex, NULL);
-    pthread_cond_init(&BUFFER.notEmpty, NULL);
-    pthread_cond_init(&BUFFER.notFull, NULL);
-
-    // dynamically allocate BUFFER's buffer
-    BUFFER.buffer = malloc(MAX_GLOBAL_BUFFER_SIZE * sizeof(char*));
-    for(int i = 0; i < MAX_GLOBAL_BUFFER_SIZE; i++) {
-        BUFFER.buffer[i] = malloc(MAX_WORD_LENGTH * sizeof(char));
-    }
-
-    /********************* create thread data arrays ********************************/
-    // generate producers and send them to the thread produce function
-    struct producerData* prod_data = malloc(nProds * sizeof(struct producerData));
-    for(int i = 0; i < nProds; i++) {
-        prod_data[i].numProducers = nProds;
-        prod_data[i].dictPointer = dict;
-    }
-    // generate consumers and send them to the thread consume function
-    struct consumerData* con_data = malloc(nCons * sizeof(struct consumerData));
-    for(int i = 0; i < nCons; i++) {
-        con_data[i].outputFileName = outputFile;
-    }
-
-    /********************* create threads and store the ids *************************/
-    // loop through all of the thread data structs and create threads for each
-    // for producers
-    pthread_t* producer_ids = malloc(nProds * sizeof(pthread_t));
-    for (int i = 0; i < nProds; i++) {
-        pthread_create(&producer_ids[i], NULL, producer, &prod_data[i]);
-    }
-    // for consumers
-    pthread_t* consumer_ids = malloc(nCons * sizeof(pthread_t));
-    for (int i = 0; i < nCons; i++) {
-        pthread_create(&consumer_ids[i], NULL, consumer, &con_data[i]);
-    }
-    
-    /************************* join all thread **************************************/
-    // join all producer threads
-    for (int i = 0; i < nProds; i++) {
-        pthread_join(producer_ids[i], NULL);
-    }    
-    // join all consumer threads
-    for (int i = 0; i < nCons; i++) {
-        pthread_join(consumer_ids[i], NULL);
-    }
-
-    if(!isFound) {
-        printf("No password match found\n");
-    }
-    else {
-        printf("outfile:  %s\n", outputFile);
-    }
-    printf("\n");
-
-    // destroy and deallocate data
-    pthread_mutex_destroy(&BUFFER.mutex);
-    pthread_cond_destroy(&BUFFER.notEmpty);
-    pthread_cond_destroy(&BUFFER.notFull);
-    fclose(dict);
-    
-    // deallocate BUFFER's buffer
-    for(int i = 0; i < MAX_GLOBAL_BUFFER_SIZE; i++) {
-        free(BUFFER.buffer[i]);
-    }
-    free(BUFFER.buffer);
-
-    // free prod/con array for storing input structs
-    free(prod_data);
-    free(con_data);
-
-    // free producer and consumer ID arrays
-    free(producer_ids);
-    free(consumer_ids);
-
-    return 0;
+/** main.c - Ethan Perry - Dec 6, 2024
+ * The main function initializes global structures, creates producer and consumer threads,
+ * and coordinates their execution to perform the password cracking task. The program reads
+ * command-line arguments to set up the number of producer and consumer threads, processes
+ * input files to read the dictionary and target hashes, and handles synchronization between
+ * threads using mutexes and condition variables. The program ensures proper resource 
+ * management by dynamically allocating and freeing memory for buffers, thread data 
+ * structures, and thread IDs. It also manages the lifetime of the global buffer and 
+ * ensures that all threads complete their tasks before exiting.
+ *
+ * Usage:
+ * ./password_cracker [options] <dictionary_file> <target_file> <out_file> <num_prods> <num_cons>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include "hash.h"
+#include "cracker_cmd.h"
+#include "producer.h"
+#include "consumer.h"
+#include "shard.h"
+#include "bench.h"
+#include "potfile.h"
+#include "sink.h"
+#include "wordlist.h"
+#include "topology.h"
+#include "balance.h"
+#include "stream.h"
+#include "block.h"
+#include "checkpoint.h"
+#include "dictionary.h"
+#include "jobs.h"
+#include "mask.h"
+#include "metrics.h"
+#include "rules.h"
+#include "steal.h"
+#include "targets.h"
+#include "global.h"
+
+// global variables 
+// (see global.h for comments)
+CrackerOptions OPTIONS;
+HashAlgorithm HASH;
+GlobalBuffer BUFFER;
+WorkQueues QUEUES;
+JobBoard JOBS;
+TargetSet TARGETS;
+RuleSet RULES;
+MaskAttack MASK;
+Checkpoint CHECKPOINT;
+Metrics METRICS;
+int isFound = 0;
+int numProdsDone = 0;
+int isDone = 0;
+
+/** run_dictionary_attack()
+ * This function runs a dictionary attack: it splits the dictionary, creates the producer
+ * and consumer threads (or the fused workers) and waits for all of them to finish.
+ *
+ * @param dict The mapped dictionary.
+ * @param outfile The output file where cracked passwords are written.
+ * @param numWords Receives the number of dictionary words processed.
+ * @param numHashes Receives the number of candidates hashed.
+ */
+static void run_dictionary_attack(Dictionary* dict, FILE* outfile, long* numWords, long* numHashes) {
+    // fused workers read the dictionary themselves, there are no producers
+    int nProds = OPTIONS.fused ? 0 : OPTIONS.numProducers;
+    int nCons = OPTIONS.numConsumers;
+
+    // consumers of a slow hash type share the hashing of their blocks (see jobs.h)
+    init_jobs(nCons);
+
+    /********************* create thread data arrays ********************************/
+    // every reading thread, a producer or in fused mode a worker, scans what is left of
+    // its own newline-aligned range of the dictionary (see checkpoint.h)
+    int nReaders = OPTIONS.fused ? nCons : nProds;
+    DictRange* ranges = malloc(nReaders * sizeof(DictRange));
+    for (int i = 0; i < nReaders; i++) {
+        ranges[i] = checkpoint_range(i);
+    }
+    // generate producers and send them to the thread produce function
+    struct producerData* prod_data = malloc(nProds * sizeof(struct producerData));
+    for(int i = 0; i < nProds; i++) {
+        prod_data[i].id = i;
+        prod_data[i].numProducers = nProds;
+        prod_data[i].range = ranges[i];
+    }
+    // generate consumers and send them to the thread consume function
+    struct consumerData* con_data = malloc(nCons * sizeof(struct consumerData));
+    for(int i = 0; i < nCons; i++) {
+        con_data[i].id = i;
+        con_data[i].outputFile = outfile;
+        con_data[i].numWords = 0;
+        con_data[i].numHashes = 0;
+        if (OPTIONS.fused) {
+            con_data[i].range = ranges[i];
+        }
+    }
+
+    // with --adaptive, a controller parks and wakes threads of the pool and sizes the blocks
+    start_balance(nProds, nCons);
+    // a streamed dictionary is read by its own thread and handed to the producers in chunks
+    if (OPTIONS.stream) {
+        start_stream();
+    }
+
+    /********************* create threads and store the ids *************************/
+    // loop through all of the thread data structs and create threads for each
+    // for producers
+    pthread_t* producer_ids = malloc(nProds * sizeof(pthread_t));
+    for (int i = 0; i < nProds; i++) {
+        pthread_create(&producer_ids[i], NULL, producer, &prod_data[i]);
+    }
+    // for consumers, or fused workers that read and hash their own slice
+    pthread_t* consumer_ids = malloc(nCons * sizeof(pthread_t));
+    for (int i = 0; i < nCons; i++) {
+        pthread_create(&consumer_ids[i], NULL, OPTIONS.fused ? fused_worker : consumer, &con_data[i]);
+    }
+    
+    /************************* join all thread **************************************/
+    // join all producer threads
+    for (int i = 0; i < nProds; i++) {
+        pthread_join(producer_ids[i], NULL);
+    }    
+    // join all consumer threads
+    for (int i = 0; i < nCons; i++) {
+        pthread_join(consumer_ids[i], NULL);
+    }
+
+    finish_balance();
+    if (OPTIONS.stream) {
+        finish_stream();
+    }
+
+    // total the work of every consumer
+    *numWords = *numHashes = 0;
+    for (int i = 0; i < nCons; i++) {
+        *numWords += con_data[i].numWords;
+        *numHashes += con_data[i].numHashes;
+    }
+
+    // free the job board, the ranges, prod/con array for storing input structs and the ID arrays
+    free_jobs();
+    free(ranges);
+    free(prod_data);
+    free(con_data);
+    free(producer_ids);
+    free(consumer_ids);
+}
+
+/** main(argv, argc)
+ * This function initializes global variables, sets up synchronization primitives,
+ * creates and starts producer and consumer threads, and waits for all threads to complete.
+ * It parses command-line arguments (see cracker_cmd.h) to get the names of input and output
+ * files, the number of producer and consumer threads to create, and the options. It ensures proper initialization of the global
+ * buffer and associated synchronization primitives, and handles resource cleanup upon completion.
+ *
+ * @param argv Number of command-line arguments.
+ * @param argc Array of command-line arguments, options first or anywhere, then in order:
+ *             Dictionary file path
+ *             Target file path
+ *             Output file path
+ *             Number of producer threads
+ *             Number of consumer threads
+ * @return int Returns 0 on successful completion.
+ *
+ * @note The function exits with an error message if the number of command-line arguments 
+ * is incorrect, or if there are invalid thread number inputs.
+ */
+int main (int argv, char** argc) {
+    // for formatting
+    printf("\n");
+    // combining the outputs of a sharded job does not crack anything
+    if (argv > 1 && strcmp(argc[1], "--merge") == 0) {
+        return merge_shards(argv - 2, argc + 2);
+    }
+    // nor does compiling a dictionary for later runs
+    if (argv > 1 && strcmp(argc[1], "--compile-dict") == 0) {
+        return compile_wordlist(argv - 2, argc + 2);
+    }
+    // read the options and positional arguments, exits on invalid input
+    parse_options(argv, argc);
+    if (OPTIONS.benchmark) {
+        return run_benchmark();
+    }
+    // declare outfile name
+    char* outputFile = OPTIONS.outputFile;
+
+    // parse command line, check files and map the dictionary
+    Dictionary dict;
+    parse_cmd(&dict);
+
+    // pick the fastest kernel of the hash algorithm for this CPU before any thread starts hashing
+    hash_engine_init();
+    printf("hash engine: %s %s (%d %s)\n", HASH.name, HASH.engine, HASH.lanes, HASH.lanes == 1 ? "lane" : "lanes");
+    if (HASH.saltedBatch != NULL) {
+        printf("iterations:  %u\n", OPTIONS.iterations);
+    }
+    if (TARGETS.salted && HASH.saltedBatch != NULL) {
+        printf("salts:       %d distinct, derived with each candidate\n", TARGETS.numSalts);
+    }
+    else if (TARGETS.salted) {
+        printf("salts:       %d distinct, %s each candidate\n", TARGETS.numSalts,
+            OPTIONS.saltSide == SALT_PREPEND ? "before" : "after");
+    }
+    if (dict.compiled != NULL) {
+        printf("wordlist:    compiled, %llu distinct words\n", (unsigned long long)dict.compiled->numWords);
+    }
+    // resolve auto thread counts from the CPU topology, probing with the selected kernel
+    plan_threads(&dict);
+    if (OPTIONS.dictFile != NULL) {
+        printf("rules:       %d read, %d unique in %d stems\n", RULES.numRules, RULES.numCandidates, RULES.numStems);
+    }
+
+    // open the output file once, every cracked hash is appended to it; a fresh run starts
+    // it over and a resumed run keeps the hits of the interrupted one, the hits of earlier
+    // runs are the potfile's to keep
+    FILE* outfile = fopen(outputFile, OPTIONS.resume ? "a" : "w");
+    if (outfile == NULL) {
+        printf("Failed to open file\n");
+        exit(1);
+    }
+
+    // initialize all data related to the global BUFFER, the blocks themselves come
+    // from the pool as producers need them
+    init_global_buffer();
+    // split the work into ranges, or read them back from the state file, which may
+    // change the number of reading threads
+    init_checkpoint(&dict);
+    // targets cracked by earlier runs are skipped before any hashing starts
+    if (OPTIONS.potfile != NULL) {
+        int numLoaded = load_potfile(OPTIONS.potfile, outfile);
+        printf("potfile:     %s, %d of %d target hashes already cracked\n", OPTIONS.potfile, numLoaded,
+            TARGETS.numTargets);
+    }
+    // the work-stealing scheduler queues blocks in one deque per consumer instead
+    if (OPTIONS.dictFile != NULL && !OPTIONS.fused && OPTIONS.scheduler == SCHED_STEAL) {
+        init_work_queues(OPTIONS.numConsumers, OPTIONS.numProducers);
+    }
+    if (OPTIONS.dictFile == NULL) {
+        printf("mask:        %s (%d workers)\n", OPTIONS.mask, OPTIONS.numConsumers);
+    }
+    else {
+        // a hybrid attack combines every word with the whole mask
+        if (OPTIONS.mask != NULL) {
+            printf("mask:        %s %s each word, %llu candidates per word\n", OPTIONS.mask,
+                OPTIONS.maskSide == MASK_PREPEND ? "before" : "after", (unsigned long long)MASK.keyspace);
+        }
+        if (OPTIONS.stream) {
+            printf("input:       streamed from %s, %d chunks of %d KiB\n",
+                strcmp(OPTIONS.dictFile, "-") == 0 ? "standard input" : OPTIONS.dictFile, STREAM_CHUNKS,
+                STREAM_CHUNK_SIZE / 1024);
+        }
+        if (OPTIONS.fused) {
+            printf("pipeline:    fused (%d workers)\n", OPTIONS.numConsumers);
+        }
+        else {
+            printf("scheduler:   %s\n", OPTIONS.scheduler == SCHED_STEAL ? "steal" : "global");
+        }
+    }
+    // a resumed run keeps the thread counts of the state file
+    print_layout();
+    // the ranges of this process cover its whole slice, in order
+    if (OPTIONS.numShards > 1) {
+        printf("shard:       %d of %d, %s %llu to %llu\n", OPTIONS.shardIndex + 1, OPTIONS.numShards,
+            OPTIONS.dictFile == NULL ? "candidates" : "bytes", (unsigned long long)CHECKPOINT.ranges[0].start,
+            (unsigned long long)CHECKPOINT.ranges[CHECKPOINT.numRanges - 1].end);
+    }
+
+    /********************* run the attack *****************************************/
+    // time the cracking itself, from thread creation to the last hit written
+    struct timeval startTime, endTime;
+    gettimeofday(&startTime, NULL);
+    start_checkpoints();
+    // hits are written by their own thread, which must not take the signals either
+    start_sink();
+    // one metrics slot per thread, producers only in the producer/consumer pipeline
+    start_metrics(OPTIONS.dictFile != NULL && !OPTIONS.fused ? OPTIONS.numProducers : 0, OPTIONS.numConsumers);
+    long numWords, numHashes;
+    if (OPTIONS.dictFile == NULL) {
+        // every candidate of the mask is a "word" of its own
+        numWords = numHashes = (long)run_mask_attack(OPTIONS.numConsumers, outfile);
+    }
+    else {
+        run_dictionary_attack(&dict, outfile, &numWords, &numHashes);
+    }
+    // the writer records the last hits for the checkpoint, stop it first
+    finish_sink();
+    gettimeofday(&endTime, NULL);
+    // the reporter reads the checkpoint ranges, stop it first
+    finish_metrics();
+    finish_checkpoints();
+    double elapsed = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_usec - startTime.tv_usec) / 1e6;
+
+    if(TARGETS.numCracked == 0) {
+        printf("No password match found\n");
+    }
+    else {
+        printf("cracked:  %d of %d target hashes\n", TARGETS.numCracked, TARGETS.numTargets);
+        printf("outfile:  %s\n", outputFile);
+    }
+    if (OPTIONS.metricsFile != NULL) {
+        printf("metrics:  %s\n", OPTIONS.metricsFile);
+    }
+    // throughput, comparable across schedulers and thread counts on the same workload
+    printf("elapsed:  %.3f s, %ld words, %.0f words/s, %.0f hashes/s\n", elapsed, numWords,
+        elapsed > 0 ? numWords / elapsed : 0, elapsed > 0 ? numHashes / elapsed : 0);
+    printf("\n");
+
+    // recycle the blocks left queued by an early finish, then free the pool
+    if (OPTIONS.dictFile != NULL && !OPTIONS.fused && OPTIONS.scheduler == SCHED_STEAL) {
+        free_work_queues();
+    }
+    free_global_buffer();
+
+    // destroy and deallocate data
+    close_dictionary(&dict);
+    fclose(outfile);
+    close_potfile();
+    free_targets();
+    free_rules();
+
+    return 0;
 }
\ No newline at end of file
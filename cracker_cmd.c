@@ -1,40 +1,372 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include "global.h"
-#include "cracker_cmd.h"
-
-FILE* parse_cmd(char** argc) {    
-    // open file to read
-    FILE* pDict = fopen(argc[1], "r");
-    // check if file pointer is null (indicating invalid file)
-    if (pDict == NULL) {
-        printf("error: '%s' is an invalid file\n", argc[1]);
-        printf("ensure file exists and entered correctly\n\n");
-        exit(1);
-    }
-    
-    // open file to validate
-    FILE* pTarget = fopen(argc[2], "r");
-    // check if file pointer is null (indicating invalid file)
-    if (pTarget == NULL) {
-        printf("error: '%s' is an invalid file\n", argc[2]);
-        printf("ensure file exists and entered correctly\n\n");
-        fclose(pDict);
-        fclose(pTarget); 
-        exit(1);
-    }
-    // Read the 64-character hash value and error check in same step
-    if (fscanf(pTarget, "%64s", TARGET) != 1) { 
-        printf("Failed to read hash value\n"); 
-        fclose(pDict);
-        fclose(pTarget); 
-        exit(1); 
-    }
-
-    // close file pointer
-    fclose(pTarget); 
-
-    // return file pointer to be used by program
-    return pDict;
-}
\ No newline at end of file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cracker_cmd.h"
+#include "stream.h"
+#include "checkpoint.h"
+#include "dictionary.h"
+#include "hash.h"
+#include "mask.h"
+#include "rules.h"
+#include "targets.h"
+#include "global.h"
+
+// print how to run the program and exit
+static void usage(char* program) {
+    printf("usage: %s [options] <dictionary_file> <hash_file> <output_file> <num_producers> <num_consumers>\n",
+        program);
+    printf("       %s --mask MASK [options] <hash_file> <output_file> <num_producers> <num_consumers>\n",
+        program);
+    printf("       %s --merge <merged_file> <shard_output_file>...\n", program);
+    printf("       %s --compile-dict <dictionary_file> <compiled_file>\n", program);
+    printf("       %s --benchmark [--bench-words N] [--bench-lengths 6-12] [--bench-grid 1x1,2x4] [options]\n",
+        program);
+    printf("options:\n");
+    printf("  --hash-type TYPE           algorithm of the hashes: md5, sha1, ntlm, sha256 (default),\n");
+    printf("                             sha512 or pbkdf2-sha256\n");
+    printf("  --iterations N             iterations of pbkdf2-sha256 (default: 1000)\n");
+    printf("  --scheduler global|steal   shared global buffer (default) or per-consumer work stealing\n");
+    printf("  --rules FILE               mangling rules applied to every word (default: built-in classic rules)\n");
+    printf("  --mask MASK                brute-force every candidate of MASK, e.g. ?u?l?l?d?d, or with a\n");
+    printf("                             dictionary, combine every word with every candidate of MASK\n");
+    printf("  --mask-side append|prepend put the mask after (default) or before each word\n");
+    printf("  --salt-side append|prepend put the salt of hash:salt targets after (default) or before each candidate\n");
+    printf("  --charset1-4 CHARS         custom charsets used in a mask as ?1-?4\n");
+    printf("  --shard i/N                run the i-th of N disjoint slices of the job (i from 1)\n");
+    printf("  --status-timer SECONDS     seconds between status reports, 0 for none (default: 5)\n");
+    printf("  --metrics FILE             write a JSON summary of the metrics of the run to FILE\n");
+    printf("  --checkpoint FILE          state file written every %d s (default: <output_file>.state)\n",
+        CHECKPOINT_INTERVAL);
+    printf("  --resume                   continue the interrupted run recorded in the state file\n");
+    printf("  --potfile FILE             skip the hashes cracked in FILE by earlier runs, and add every hit to it\n");
+    printf("  --sync flush|fsync|none    flush the output file after every batch of hits (default), also\n");
+    printf("                             fsync it, or only at checkpoints and at the end\n");
+    printf("  --quiet                    do not echo the hits on standard output\n");
+    printf("  --benchmark                measure the hash kernels, rules, buffer and whole runs on a synthetic\n");
+    printf("                             dictionary of --bench-words words of --bench-lengths characters, with\n");
+    printf("                             the producer x consumer counts of --bench-grid\n");
+    printf("  --fused                    num_consumers workers read and hash their own dictionary slice,\n");
+    printf("                             no producers or buffer (num_producers is ignored)\n");
+    printf("  --adaptive                 park and wake producers and consumers and resize the blocks while\n");
+    printf("                             running, from the buffer occupancy and wait times (global scheduler)\n");
+    printf("either thread count may be auto: picked from the CPU topology, with every thread pinned\n");
+    printf("the dictionary may be - to stream it from standard input, or a FIFO\n\n");
+    exit(1);
+}
+
+// read a thread count, it must be greater than 0 or auto (see topology.h)
+static int thread_count(const char* arg) {
+    if (strcmp(arg, "auto") == 0) {
+        return THREADS_AUTO;
+    }
+    int count = atoi(arg);
+    if (count < 1) {
+        printf("Invalid thread number input\n");
+        exit(1);
+    }
+    return count;
+}
+
+// returns 1 if the option is a flag, which takes no value
+static int is_flag(char* name) {
+    return strcmp(name, "fused") == 0 || strcmp(name, "resume") == 0 || strcmp(name, "benchmark") == 0
+        || strcmp(name, "adaptive") == 0 || strcmp(name, "quiet") == 0;
+}
+
+// store the value of a single option, returns 0 if the option or its value is invalid
+static int set_option(char* name, char* value) {
+    if (is_flag(name)) {
+        if (value != NULL) {
+            printf("error: option '--%s' takes no value\n", name);
+            return 0;
+        }
+        if (strcmp(name, "fused") == 0) {
+            OPTIONS.fused = 1;
+        }
+        else if (strcmp(name, "benchmark") == 0) {
+            OPTIONS.benchmark = 1;
+        }
+        else if (strcmp(name, "adaptive") == 0) {
+            OPTIONS.adaptive = 1;
+        }
+        else if (strcmp(name, "quiet") == 0) {
+            OPTIONS.quiet = 1;
+        }
+        else {
+            OPTIONS.resume = 1;
+        }
+        return 1;
+    }
+    if (value == NULL) {
+        printf("error: option '--%s' needs a value\n", name);
+        return 0;
+    }
+    if (strcmp(name, "rules") == 0) {
+        OPTIONS.ruleFile = value;
+        return 1;
+    }
+    if (strcmp(name, "hash-type") == 0) {
+        if (!select_hash(value)) {
+            printf("error: unknown hash type '%s'\n", value);
+            return 0;
+        }
+        return 1;
+    }
+    if (strcmp(name, "iterations") == 0) {
+        char* end;
+        long iterations = strtol(value, &end, 10);
+        if (*end != '\0' || iterations < 1 || iterations > 100000000) {
+            printf("error: invalid number of iterations '%s'\n", value);
+            return 0;
+        }
+        OPTIONS.iterations = (uint32_t)iterations;
+        return 1;
+    }
+    if (strcmp(name, "shard") == 0) {
+        // shards are numbered from 1 on the command line
+        int index, count;
+        char extra;
+        if (sscanf(value, "%d/%d%c", &index, &count, &extra) != 2 || count < 1 || index < 1 || index > count) {
+            printf("error: invalid shard '%s', expected i/N with 1 <= i <= N\n", value);
+            return 0;
+        }
+        OPTIONS.shardIndex = index - 1;
+        OPTIONS.numShards = count;
+        return 1;
+    }
+    if (strcmp(name, "status-timer") == 0) {
+        char* end;
+        long seconds = strtol(value, &end, 10);
+        if (*end != '\0' || seconds < 0 || seconds > 86400) {
+            printf("error: invalid status timer '%s', expected seconds\n", value);
+            return 0;
+        }
+        OPTIONS.statusTimer = (int)seconds;
+        return 1;
+    }
+    if (strcmp(name, "bench-words") == 0) {
+        char* end;
+        OPTIONS.benchWords = strtol(value, &end, 10);
+        if (*end != '\0' || OPTIONS.benchWords < 1 || OPTIONS.benchWords > 100000000) {
+            printf("error: invalid number of benchmark words '%s'\n", value);
+            return 0;
+        }
+        return 1;
+    }
+    if (strcmp(name, "bench-lengths") == 0) {
+        OPTIONS.benchLengths = value;
+        return 1;
+    }
+    if (strcmp(name, "bench-grid") == 0) {
+        OPTIONS.benchGrid = value;
+        return 1;
+    }
+    if (strcmp(name, "metrics") == 0) {
+        OPTIONS.metricsFile = value;
+        return 1;
+    }
+    if (strcmp(name, "potfile") == 0) {
+        OPTIONS.potfile = value;
+        return 1;
+    }
+    if (strcmp(name, "checkpoint") == 0) {
+        OPTIONS.stateFile = value;
+        return 1;
+    }
+    if (strcmp(name, "mask") == 0) {
+        OPTIONS.mask = value;
+        return 1;
+    }
+    if (strcmp(name, "mask-side") == 0) {
+        if (strcmp(value, "append") == 0) {
+            OPTIONS.maskSide = MASK_APPEND;
+            return 1;
+        }
+        if (strcmp(value, "prepend") == 0) {
+            OPTIONS.maskSide = MASK_PREPEND;
+            return 1;
+        }
+        return 0;
+    }
+    if (strcmp(name, "salt-side") == 0) {
+        if (strcmp(value, "append") == 0) {
+            OPTIONS.saltSide = SALT_APPEND;
+            return 1;
+        }
+        if (strcmp(value, "prepend") == 0) {
+            OPTIONS.saltSide = SALT_PREPEND;
+            return 1;
+        }
+        return 0;
+    }
+    if (strncmp(name, "charset", 7) == 0 && name[7] >= '1' && name[7] <= '4' && name[8] == '\0') {
+        OPTIONS.charsets[name[7] - '1'] = value;
+        return 1;
+    }
+    if (strcmp(name, "sync") == 0) {
+        if (strcmp(value, "flush") == 0) {
+            OPTIONS.sync = SYNC_FLUSH;
+        }
+        else if (strcmp(value, "fsync") == 0) {
+            OPTIONS.sync = SYNC_FSYNC;
+        }
+        else if (strcmp(value, "none") == 0) {
+            OPTIONS.sync = SYNC_NONE;
+        }
+        else {
+            printf("error: unknown sync policy '%s'\n", value);
+            return 0;
+        }
+        return 1;
+    }
+    if (strcmp(name, "scheduler") == 0) {
+        if (strcmp(value, "global") == 0) {
+            OPTIONS.scheduler = SCHED_GLOBAL;
+        }
+        else if (strcmp(value, "steal") == 0) {
+            OPTIONS.scheduler = SCHED_STEAL;
+        }
+        else {
+            printf("error: unknown scheduler '%s'\n", value);
+            return 0;
+        }
+        return 1;
+    }
+    printf("error: unknown option '--%s'\n", name);
+    return 0;
+}
+
+void parse_options(int argv, char** argc) {
+    char* positional[5];
+    int numPositional = 0;
+
+    // defaults
+    select_hash("sha256");
+    OPTIONS.scheduler = SCHED_GLOBAL;
+    OPTIONS.stream = 0;
+    OPTIONS.fused = 0;
+    OPTIONS.adaptive = 0;
+    OPTIONS.ruleFile = NULL;
+    OPTIONS.mask = NULL;
+    OPTIONS.maskSide = MASK_APPEND;
+    OPTIONS.saltSide = SALT_APPEND;
+    OPTIONS.iterations = 1000;
+    OPTIONS.stateFile = NULL;
+    OPTIONS.potfile = NULL;
+    OPTIONS.sync = SYNC_FLUSH;
+    OPTIONS.quiet = 0;
+    OPTIONS.resume = 0;
+    OPTIONS.shardIndex = 0;
+    OPTIONS.numShards = 1;
+    OPTIONS.statusTimer = 5;
+    OPTIONS.metricsFile = NULL;
+    OPTIONS.benchmark = 0;
+    OPTIONS.benchWords = 100000;
+    OPTIONS.benchLengths = "6-12";
+    OPTIONS.benchGrid = "1x1,1x2,2x2,2x4";
+    for (int i = 0; i < 4; i++) {
+        OPTIONS.charsets[i] = NULL;
+    }
+
+    for (int i = 1; i < argv; i++) {
+        // anything that is not an option is positional
+        if (strncmp(argc[i], "--", 2) != 0) {
+            if (numPositional == 5) {
+                printf("Error: incorrect number of input parameters\n");
+                usage(argc[0]);
+            }
+            positional[numPositional++] = argc[i];
+            continue;
+        }
+
+        // split --name=value, or take the value from the next argument unless it is a flag
+        char name[64];
+        char* value = NULL;
+        char* equals = strchr(argc[i] + 2, '=');
+        if (equals != NULL) {
+            snprintf(name, sizeof(name), "%.*s", (int)(equals - argc[i] - 2), argc[i] + 2);
+            value = equals + 1;
+        }
+        else {
+            snprintf(name, sizeof(name), "%s", argc[i] + 2);
+            if (!is_flag(name)) {
+                if (i + 1 == argv) {
+                    printf("error: option '--%s' needs a value\n", name);
+                    usage(argc[0]);
+                }
+                value = argc[++i];
+            }
+        }
+        if (!set_option(name, value)) {
+            usage(argc[0]);
+        }
+    }
+
+    // the benchmark generates its own input
+    if (OPTIONS.benchmark) {
+        if (numPositional != 0) {
+            printf("error: --benchmark takes no positional arguments\n");
+            usage(argc[0]);
+        }
+        OPTIONS.dictFile = NULL;
+        return;
+    }
+
+    // error check amount of input, a plain mask attack has no dictionary and a
+    // hybrid attack combines a dictionary with a mask
+    int expected = (OPTIONS.mask != NULL && numPositional == 4) ? 4 : 5;
+    if (numPositional != expected) {
+        printf("Error: incorrect number of input parameters\n");
+        usage(argc[0]);
+    }
+    OPTIONS.dictFile = (expected == 5) ? positional[0] : NULL;
+
+    // rules mangle dictionary words, a plain mask already spells out every candidate
+    if (OPTIONS.dictFile == NULL && OPTIONS.ruleFile != NULL) {
+        printf("error: --rules needs a dictionary\n");
+        usage(argc[0]);
+    }
+    // the controller rebalances the producers and consumers sharing the global buffer
+    if (OPTIONS.adaptive && (OPTIONS.dictFile == NULL || OPTIONS.fused || OPTIONS.scheduler != SCHED_GLOBAL)) {
+        printf("error: --adaptive needs a dictionary and the global scheduler, without --fused\n");
+        usage(argc[0]);
+    }
+    // a streamed dictionary is read once, front to back, by the producers
+    OPTIONS.stream = OPTIONS.dictFile != NULL && is_stream(OPTIONS.dictFile);
+    if (OPTIONS.stream && (OPTIONS.fused || OPTIONS.resume || OPTIONS.numShards > 1)) {
+        printf("error: a streamed dictionary cannot be used with --fused, --resume or --shard\n");
+        usage(argc[0]);
+    }
+    OPTIONS.targetFile = positional[expected - 4];
+    OPTIONS.outputFile = positional[expected - 3];
+
+    // store and check thread counts
+    OPTIONS.numProducers = thread_count(positional[expected - 2]);
+    OPTIONS.numConsumers = thread_count(positional[expected - 1]);
+}
+
+void parse_cmd(Dictionary* dict) {    
+    // map the dictionary file, or open the pipe it is streamed from, exits if it is invalid
+    if (OPTIONS.dictFile != NULL && !OPTIONS.stream) {
+        open_dictionary(OPTIONS.dictFile, dict);
+    }
+    else {
+        if (OPTIONS.stream) {
+            open_stream(OPTIONS.dictFile);
+        }
+        dict->data = dict->map = NULL;
+        dict->size = dict->mapSize = 0;
+        dict->compiled = NULL;
+    }
+    
+    // load every target hash of the selected algorithm, and its salt, into the global TARGETS set
+    load_targets(OPTIONS.targetFile);
+
+    // compile the mangling rules into the global RULES set, and parse the mask
+    if (OPTIONS.dictFile != NULL) {
+        load_rules(OPTIONS.ruleFile);
+    }
+    if (OPTIONS.mask != NULL) {
+        load_mask(OPTIONS.mask, OPTIONS.charsets);
+    }
+}
@@ -1,29 +1,98 @@
-/** cracker_cmd - Ethan Perry - Dec 6, 2024
- * The primary function in this file is `parse_cmd`, which opens and validates the
- * dictionary and target files provided as command-line arguments, reads a 64-character
- * hash value from the target file, and returns a pointer to the opened dictionary file.
- * If any file operations fail, the function prints an error message and exits the program.
- * The function in this file is essential for ensuring that the input files are correctly
- * opened and read, and they handle error conditions gracefully by informing the user and
- * terminating the program if necessary.
- */
-
-#ifndef __CRACKER_CMD__
-#define __CRACKER_CMD__
-
-/** parse_cmd()
- * This function opens the dictionary file for reading and validates that it
- * exists. It also opens the target file, validates it, and reads a 64-character
- * hash value from it, storing it in the global `TARGET` variable. If any file
- * operations fail, the function prints an error message and exits the program.
- *
- * @param argc: Array of command-line arguments. The first element is assumed to be 
- * the dictionary file path, and the second element is assumed to be the target file path.
- * The other arguments are validated elsewhere and do not get used here.
- * @return FILE*: Pointer to the opened dictionary file to be used by the program. 
- * If any error occurs, the program will exit, so the return value is only 
- * meaningful if the function completes successfully.
- */
-FILE* parse_cmd(char** argc);
-
-#endif
\ No newline at end of file
+/** cracker_cmd - Ethan Perry - Dec 6, 2024
+ * The functions in this file read the command line. `parse_options` separates the
+ * `--name value` options from the five positional arguments and stores both in the global
+ * `OPTIONS` structure, and `parse_cmd` opens and validates the dictionary and target
+ * files named there, loads every hash value of the `--hash-type` algorithm, and its salt,
+ * from the target file, compiles the mangling rules, and maps the dictionary file into
+ * memory. If any argument is invalid or any file operation fails, the functions print an
+ * error message and exit the program. The functions in this file are essential for
+ * ensuring that the input files are correctly opened and read, and they handle error
+ * conditions gracefully by informing the user and terminating the program if necessary.
+ */
+
+#ifndef __CRACKER_CMD__
+#define __CRACKER_CMD__
+#include "dictionary.h"
+
+/** parse_options()
+ * This function reads the command line into the global `OPTIONS` structure. Options start
+ * with `--` and may appear anywhere, either as `--name value` or `--name=value`, or just
+ * `--name` for flags; every other argument is positional. Exactly five positional
+ * arguments are required: the dictionary file, the target file, the output file, the
+ * number of producer threads and the number of consumer threads; with `--mask` the
+ * dictionary file may be left out for a plain mask attack, so only the last four are
+ * given. Either thread count may be `auto`, to pick it from the CPU topology and pin
+ * every thread (see topology.h). The dictionary file may also be a compiled wordlist,
+ * written beforehand with `cracker --compile-dict <dictionary_file> <compiled_file>` (see
+ * wordlist.h), or `-` or a FIFO, to stream the words from a generator (see stream.h),
+ * which rules out `--fused`, `--resume` and `--shard`. If an option is unknown, a value
+ * is invalid or the number of positional arguments is wrong, the function prints the
+ * usage and exits.
+ *
+ * Options:
+ * --hash-type TYPE           Algorithm of the target hashes (see hash.h): md5, sha1,
+ *                            ntlm, sha256 (default), sha512 or pbkdf2-sha256.
+ * --iterations N             Iterations of pbkdf2-sha256 (see pbkdf2.h); default 1000.
+ * --scheduler global|steal   How blocks reach consumers: the shared global buffer
+ *                            (default) or per-consumer deques with work stealing.
+ * --rules FILE               Compile the mangling rules in FILE (see rules.h) instead
+ *                            of the built-in classic rules.
+ * --mask MASK                Run a mask attack instead of a dictionary attack (see
+ *                            mask.h); num_consumers workers split the keyspace. With a
+ *                            dictionary, run a hybrid attack of every word and the mask.
+ * --mask-side append|prepend Put the mask after (default) or before each word.
+ * --salt-side append|prepend Put the salt of `hash:salt` targets after (default) or
+ *                            before each candidate (see targets.h).
+ * --charset1-4 CHARS         Custom charsets referenced in the mask as ?1-?4.
+ * --shard i/N                Run only the i-th of N disjoint slices of the job, i from
+ *                            1 (see shard.h); `cracker --merge <merged_file> <files>...`
+ *                            combines the output files of the shards.
+ * --status-timer SECONDS     Seconds between two status reports of the rates, progress
+ *                            and pipeline health (see metrics.h), 0 for none; default 5.
+ * --metrics FILE             Write a JSON summary of the metrics of the run to FILE.
+ * --checkpoint FILE          State file of the checkpoints (see checkpoint.h), by
+ *                            default <output_file>.state.
+ * --resume                   Continue the interrupted run recorded in the state file.
+ * --potfile FILE             Mark the targets cracked in FILE by earlier runs before
+ *                            hashing starts, and append every hit to FILE (see potfile.h).
+ * --sync flush|fsync|none    When the writer of the hits flushes the output file (see
+ *                            sink.h): after every batch (default), after every batch
+ *                            and to disk, or only at checkpoints and at the end. The
+ *                            file is truncated by a fresh run, appended to on resume.
+ * --quiet                    Write the hits to the output file only, not to standard
+ *                            output.
+ * --benchmark                Measure the hash kernels, the rules, the global buffer and
+ *                            whole runs on a synthetic dictionary instead of cracking
+ *                            (see bench.h); takes no positional arguments.
+ * --bench-words N            Number of words of the synthetic dictionary; default 100000.
+ * --bench-lengths SPEC       Length distribution of the synthetic words, e.g. 8, 6-12
+ *                            (default) or 6-8:3,12:1 for weighted lengths.
+ * --bench-grid PxC,...       Producer and consumer counts of the buffer and whole-run
+ *                            measurements; default 1x1,1x2,2x2,2x4.
+ * --fused                    Run num_consumers fused workers that each read their own
+ *                            slice of the dictionary and hash it directly, with no
+ *                            producers and no shared buffer; num_producers is ignored.
+ * --adaptive                 Rebalance the pipeline while it runs (see balance.h):
+ *                            park and wake producers and consumers of the pool and
+ *                            resize the blocks. Needs the global scheduler.
+ *
+ * @param argv: Number of command-line arguments.
+ * @param argc: Array of command-line arguments.
+ */
+void parse_options(int argv, char** argc);
+
+/** parse_cmd()
+ * This function maps the dictionary file named in `OPTIONS` into memory and validates
+ * that it exists (see dictionary.h), or opens it for streaming (see stream.h); without a
+ * dictionary to map `dict` is left empty. It also loads the target file, decoding every
+ * hash value of the selected algorithm into the global `TARGETS` set (see targets.h), and
+ * compiles the mangling rules into the global `RULES` set (see rules.h) when there is a
+ * dictionary, and parses the mask into `MASK` (see mask.h) when one is given. If any file
+ * operations fail, the function prints an error message and exits the program.
+ *
+ * @param dict: The dictionary to map. If any error occurs, the program will exit, 
+ * so it is only meaningful if the function completes successfully.
+ */
+void parse_cmd(Dictionary* dict);
+
+#endif
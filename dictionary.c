@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dictionary.h"
+#include "wordlist.h"
+#include "global.h"
+
+void open_dictionary(char* path, Dictionary* dict) {
+    // open file to read
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    // check if file descriptor is invalid (indicating invalid file)
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        printf("error: '%s' is an invalid file\n", path);
+        printf("ensure file exists and entered correctly\n\n");
+        exit(1);
+    }
+
+    dict->size = dict->mapSize = (size_t)info.st_size;
+    dict->data = dict->map = NULL;
+    dict->compiled = NULL;
+    // an empty file cannot be mapped, it simply has no words
+    if (dict->size > 0) {
+        void* data = mmap(NULL, dict->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            printf("error: failed to map '%s' into memory\n", path);
+            close(fd);
+            exit(1);
+        }
+        // every producer reads its own range front to back
+        madvise(data, dict->size, MADV_SEQUENTIAL);
+        dict->data = dict->map = data;
+        // the words of a compiled wordlist follow its header
+        dict->compiled = wordlist_header(dict->map, dict->mapSize, path);
+        if (dict->compiled != NULL) {
+            dict->data = dict->map + dict->compiled->wordsOffset;
+            dict->size = dict->compiled->wordsSize;
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+void split_dictionary(const Dictionary* dict, int n, DictRange* ranges) {
+    const char* end = dict->data + dict->size;
+    const char* start = dict->data;
+
+    for (int i = 0; i < n; i++) {
+        // nominal boundary, moved forward to just after the next newline
+        const char* stop = (i == n - 1) ? end : dict->data + dict->size / n * (i + 1);
+        if (stop < start) {
+            stop = start;
+        }
+        if (stop > dict->data && stop < end && stop[-1] != '\n') {
+            // every word of a compiled bucket has the same length, no need to scan
+            if (dict->compiled != NULL) {
+                stop = wordlist_boundary(dict->compiled, stop);
+            }
+            else {
+                const char* newline = memchr(stop, '\n', end - stop);
+                stop = (newline == NULL) ? end : newline + 1;
+            }
+            if (stop > end) {
+                stop = end;
+            }
+        }
+        ranges[i].cursor = start;
+        ranges[i].end = stop;
+        start = stop;
+    }
+}
+
+int next_word(DictRange* range, WordView* word) {
+    while (range->cursor < range->end) {
+        // find the end of the current line
+        const char* line = range->cursor;
+        const char* newline = memchr(line, '\n', range->end - line);
+        const char* stop = (newline == NULL) ? range->end : newline;
+        range->cursor = (newline == NULL) ? range->end : newline + 1;
+
+        // strip a Windows line ending
+        if (stop > line && stop[-1] == '\r') {
+            stop--;
+        }
+        // skip empty lines and words too long for their variants
+        int len = (int)(stop - line);
+        if (len == 0 || len > MAX_WORD_LENGTH - 2) {
+            continue;
+        }
+        word->ptr = line;
+        word->len = len;
+        return 1;
+    }
+    return 0;
+}
+
+void close_dictionary(Dictionary* dict) {
+    if (dict->map != NULL) {
+        munmap((void*)dict->map, dict->mapSize);
+    }
+    dict->data = dict->map = NULL;
+    dict->size = dict->mapSize = 0;
+    dict->compiled = NULL;
+}
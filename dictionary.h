@@ -0,0 +1,96 @@
+/** dictionary.h
+ * This file contains the declarations of the data structures and functions used to read
+ * the password dictionary. The dictionary file is memory-mapped once by main, split into
+ * one newline-aligned byte range per producer thread, and each producer scans its own
+ * range with `memchr`, handing out pointer + length views into the mapping instead of
+ * copying every word through stdio. The words only live in the page cache, so startup
+ * memory no longer grows with the size of the dictionary.
+ *
+ * The main components of this file include:
+ * - The `Dictionary` structure, which holds the mapping of the dictionary file, a text file
+ *   or a compiled wordlist (see wordlist.h).
+ * - The `DictRange` structure, a byte range of the mapping scanned by one producer.
+ * - The `WordView` structure, a word referenced in place inside the mapping.
+ * - open_dictionary(): Maps the dictionary file into memory.
+ * - split_dictionary(): Splits the mapping into newline-aligned ranges.
+ * - next_word(): Returns the next word of a range.
+ * - close_dictionary(): Unmaps the dictionary file.
+ */
+
+#ifndef __DICTIONARY__
+#define __DICTIONARY__
+#include <stddef.h>
+#include "wordlist.h"
+
+/** Dictionary
+ * This structure holds the read-only mapping of the dictionary file. The words of a
+ * compiled wordlist (see wordlist.h) are newline-separated like a text file's, so
+ * `data` and `size` cover them alone and the rest of the program reads both alike.
+ */
+typedef struct {
+    const char* data;            // Start of the words in the mapping
+    size_t size;                 // Size of the words in bytes
+    const char* map;             // Start of the mapping, the whole file
+    size_t mapSize;              // Size of the file in bytes
+    const WordlistHeader* compiled; // Header of a compiled wordlist, NULL for a text file
+} Dictionary;
+
+/** DictRange
+ * A byte range of the dictionary. Every range starts at the beginning of a line and
+ * ends just after a newline (or at the end of the file), so no word straddles two ranges.
+ */
+typedef struct {
+    const char* cursor;          // Next byte to scan
+    const char* end;             // One past the last byte of the range
+} DictRange;
+
+/** WordView
+ * A word referenced in place; it is not NUL terminated.
+ */
+typedef struct {
+    const char* ptr;             // First character of the word
+    int len;                     // Number of characters in the word
+} WordView;
+
+/** open_dictionary()
+ * This function opens the dictionary file and maps it read-only into memory, recognizing
+ * a compiled wordlist by its header. If the file cannot be opened or mapped, or is an
+ * invalid compiled wordlist, the function prints an error message and exits the program.
+ *
+ * @param path Path to the dictionary file.
+ * @param dict The dictionary to fill in.
+ */
+void open_dictionary(char*, Dictionary*);
+
+/** split_dictionary()
+ * This function splits the dictionary into `n` contiguous ranges of roughly equal size.
+ * Each boundary is moved forward to the start of the next line, found from the bucket
+ * table in a compiled wordlist, so a range may be empty when the dictionary has fewer
+ * lines than ranges.
+ *
+ * @param dict The mapped dictionary.
+ * @param n Number of ranges, one per producer thread.
+ * @param ranges Array of `n` ranges to fill in.
+ */
+void split_dictionary(const Dictionary*, int, DictRange*);
+
+/** next_word()
+ * This function returns a view of the next word in a range and advances the range past
+ * it. Words are whole lines with any trailing carriage return removed. Empty lines are
+ * skipped, as are lines longer than MAX_WORD_LENGTH - 2 characters, which would not leave
+ * room for a trailing digit variant and the terminator.
+ *
+ * @param range The range to scan.
+ * @param word Receives the view of the word.
+ * @return int 1 if a word was returned, 0 if the range is exhausted.
+ */
+int next_word(DictRange*, WordView*);
+
+/** close_dictionary()
+ * This function unmaps the dictionary file.
+ *
+ * @param dict The mapped dictionary.
+ */
+void close_dictionary(Dictionary*);
+
+#endif
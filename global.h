@@ -1,46 +1,120 @@
-/** global.h - Ethan Perry - Dec 6, 2024
- * This header file contains the definitions and declarations of global variables,
- * structures, and constants used throughout the password cracking program. It provides
- * the necessary includes, defines, and external declarations to ensure proper data 
- * sharing and synchronization between different parts of the program.
- *
- * The main components of this file include:
- * - Macro definitions for maximum word length, local buffer size, and global buffer size.
- * - The `GlobalBuffer` structure, which holds the global buffer for inter-thread 
- *   communication, along withsynchronization primitives like mutexes and condition variables.
- * - External declarations of global variables such as the buffer instance (BUFFER), target hash
- *   (TARGET), and flags to indicate the state of the program (isFound, numProdsDone, and isDone).
- */
-
-#ifndef __GLOBAL__
-#define __GLOBAL__
-#include <pthread.h>
-
-// global constants setting maximum value for respective items below
-#define MAX_WORD_LENGTH 100
-#define MAX_LOCAL_BUFFER_SIZE 100   
-#define MAX_GLOBAL_BUFFER_SIZE 10000
-
-/** GlobalBuffer
- * This structure contains the global buffer used for inter-thread communication,
- * as well as the necessary mutex and condition variables for synchronization.
- */
-typedef struct {
-    char** buffer;               // Pointer to the array of strings in the buffer
-    int start;                   // Index of the start of the buffer (used for circular buffer)
-    int end;                     // Index of the end of the buffer (used for circular buffer)
-    int count;                   // Current count of items in the buffer
-    pthread_mutex_t mutex;       // Mutex for synchronizing access to the buffer
-    pthread_cond_t notEmpty;     // Condition variable to signal that the buffer is not empty
-    pthread_cond_t notFull;      // Condition variable to signal that the buffer is not full
-} GlobalBuffer;
-
-/* Global variables */
-extern GlobalBuffer BUFFER;      // Global buffer instance used for inter-thread communication
-extern char TARGET[65];          // Target hash value to be matched
-extern int isFound;              // Flag to indicate if the correct password has been found
-extern int numProdsDone;         // Count of the number of producer threads that have finished
-extern int isDone;               // Flag to indicate if all producer threads are done
-
-
+/** global.h - Ethan Perry - Dec 6, 2024
+ * This header file contains the definitions and declarations of global variables,
+ * structures, and constants used throughout the password cracking program. It provides
+ * the necessary includes, defines, and external declarations to ensure proper data 
+ * sharing and synchronization between different parts of the program.
+ *
+ * The main components of this file include:
+ * - Macro definitions for maximum word length, local buffer size, and global buffer size.
+ * - The `GlobalBuffer` structure, which holds the global buffer for inter-thread
+ *   communication, along with synchronization primitives like mutexes and condition
+ *   variables. The buffer is a queue of packed word blocks (see block.h) recycled through
+ *   a free-list pool.
+ * - The `CrackerOptions` structure, which holds the parsed command line.
+ * - External declarations of global variables such as the options (OPTIONS), the buffer
+ *   instance (BUFFER), and flags to indicate the state of the program (isFound,
+ *   numProdsDone, and isDone). The state of each module (HASH, TARGETS, RULES, ...) is
+ *   declared in the module's own header.
+ */
+
+#ifndef __GLOBAL__
+#define __GLOBAL__
+#include <pthread.h>
+#include <stdint.h>
+
+// the word blocks queued by the global buffer (see block.h)
+struct WordBlock;
+
+// global constants setting maximum value for respective items below
+#define MAX_WORD_LENGTH 100
+#define MAX_LOCAL_BUFFER_SIZE 100   
+#define MAX_GLOBAL_BUFFER_SIZE 10000
+// the global buffer queues whole blocks of MAX_LOCAL_BUFFER_SIZE words
+#define MAX_GLOBAL_BLOCKS (MAX_GLOBAL_BUFFER_SIZE / MAX_LOCAL_BUFFER_SIZE)
+// shortest base word worth precomputing as a shared SHA-256 prefix; shorter words fix
+// too few rounds to pay for it (the `prefix:` line of `make bench`: 4 bytes ~0.8-1.0x,
+// 8 bytes and up ~1.2-1.5x on the AVX-512 and SHA-NI kernels)
+#define MIN_SHARED_PREFIX_LENGTH 8
+
+// thread count given as `auto`, resolved from the CPU topology (see topology.h)
+#define THREADS_AUTO 0
+
+// ways of handing word blocks from producers to consumers (see --scheduler)
+#define SCHED_GLOBAL 0              // one shared queue, the GlobalBuffer below
+#define SCHED_STEAL 1               // per-consumer deques with work stealing (see steal.h)
+
+// where a hybrid attack puts the mask relative to each word (see --mask-side)
+#define MASK_APPEND 0               // word followed by the mask
+#define MASK_PREPEND 1              // mask followed by the word
+
+// where the salt of a `hash:salt` target goes relative to each candidate (see --salt-side)
+#define SALT_APPEND 0               // candidate followed by the salt
+#define SALT_PREPEND 1              // salt followed by the candidate
+
+// when the writer of the hits flushes the output file (see --sync and sink.h)
+#define SYNC_FLUSH 0                // to the kernel after every batch of hits
+#define SYNC_FSYNC 1                // to the disk after every batch of hits
+#define SYNC_NONE 2                 // at checkpoints and at the end of the run
+
+/** CrackerOptions
+ * This structure holds the command line: the five positional arguments and every
+ * `--name value` option (see cracker_cmd.h).
+ */
+typedef struct {
+    char* dictFile;              // Path of the password dictionary
+    int stream;                  // Flag set if the dictionary is streamed from a pipe (see stream.h)
+    char* targetFile;            // Path of the file of target hashes
+    char* outputFile;            // Path of the file cracked passwords are written to
+    int numProducers;            // Number of producer threads, THREADS_AUTO until planned
+    int numConsumers;            // Number of consumer threads, THREADS_AUTO until planned
+    int scheduler;               // SCHED_GLOBAL or SCHED_STEAL
+    int fused;                   // Flag to run fused reader/hasher workers instead of the pipeline
+    int adaptive;                // Flag to rebalance the pipeline while it runs (see balance.h)
+    char* ruleFile;              // Path of the mangling rule file, NULL for the built-in rules
+    char* mask;                  // Mask of the mask or hybrid attack, NULL for a dictionary attack
+    char* charsets[4];           // Custom charsets ?1-?4 of the mask, NULL if unset
+    int maskSide;                // MASK_APPEND or MASK_PREPEND, for a hybrid attack
+    int saltSide;                // SALT_APPEND or SALT_PREPEND, for salted targets
+    uint32_t iterations;         // Number of iterations of a key-derivation hash type
+    char* stateFile;             // Path of the checkpoint state file, NULL for <output_file>.state
+    char* potfile;               // Path of the potfile of every hash ever cracked, NULL for none
+    int sync;                    // SYNC_FLUSH, SYNC_FSYNC or SYNC_NONE
+    int quiet;                   // Flag to write hits to the output file only, not standard output
+    int resume;                  // Flag to continue the run recorded in the state file
+    int shardIndex;              // Shard of the job run by this process, from 0
+    int numShards;               // Number of shards the job is split into, 1 if not sharded
+    int statusTimer;             // Seconds between two status reports, 0 for none
+    char* metricsFile;           // Path of the JSON summary of the metrics, NULL for none
+    int benchmark;               // Flag to run the benchmark instead of a crack
+    long benchWords;             // Number of words of the benchmark's synthetic dictionary
+    char* benchLengths;          // Length distribution of the synthetic words
+    char* benchGrid;             // Producer x consumer counts the benchmark runs
+} CrackerOptions;
+
+/** GlobalBuffer
+ * This structure contains the global buffer used for inter-thread communication,
+ * as well as the necessary mutex and condition variables for synchronization, and
+ * the pool of empty blocks, which has its own mutex so recycling never contends
+ * with the queue.
+ */
+typedef struct {
+    struct WordBlock** buffer;   // Pointer to the circular array of queued word blocks
+    int start;                   // Index of the start of the buffer (used for circular buffer)
+    int end;                     // Index of the end of the buffer (used for circular buffer)
+    int count;                   // Current count of blocks in the buffer
+    pthread_mutex_t mutex;       // Mutex for synchronizing access to the buffer
+    pthread_cond_t notEmpty;     // Condition variable to signal that the buffer is not empty
+    pthread_cond_t notFull;      // Condition variable to signal that the buffer is not full
+    struct WordBlock* freeBlocks; // Free-list pool of empty blocks
+    pthread_mutex_t poolMutex;   // Mutex for synchronizing access to the pool
+} GlobalBuffer;
+
+/* Global variables */
+extern CrackerOptions OPTIONS;   // Parsed command line
+extern GlobalBuffer BUFFER;      // Global buffer instance used for inter-thread communication
+extern int isFound;              // Flag to indicate if every target hash has been cracked
+extern int numProdsDone;         // Count of the number of producer threads that have finished
+extern int isDone;               // Flag to indicate if all producer threads are done
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sha-256.h"
+#include "sha-256-simd.h"
+#include "sha-512.h"
+#include "md.h"
+#include "pbkdf2.h"
+#include "hash.h"
+#include "global.h"
+
+// the SHA-256 batch API writes its digests as rows of eight words, which is the same layout
+static void sha_256_digests(const char* const* msgs, const size_t* lens, int n, uint32_t* digests) {
+    sha_256_batch(msgs, lens, n, (uint32_t (*)[8])digests);
+}
+
+// PBKDF2 takes every salt apart from its password, and the number of iterations of the run
+static void pbkdf2_digests_salted(const char* const* msgs, const size_t* lens, const char* const* salts,
+        const size_t* saltLens, int n, uint32_t* digests) {
+    pbkdf2_sha_256_batch(msgs, lens, salts, saltLens, n, OPTIONS.iterations, (uint32_t (*)[8])digests);
+}
+
+// an unsalted PBKDF2 target has the empty salt
+static void pbkdf2_digests(const char* const* msgs, const size_t* lens, int n, uint32_t* digests) {
+    const char* salts[HASH_MAX_LANES];
+    size_t saltLens[HASH_MAX_LANES];
+    for (int i = 0; i < n; i++) {
+        salts[i] = "";
+        saltLens[i] = 0;
+    }
+    pbkdf2_digests_salted(msgs, lens, salts, saltLens, n, digests);
+}
+
+// the MD engine measures the kernel of the algorithm in use
+static void md5_init() {
+    md_engine_init(MD_MD5);
+}
+
+static void sha_1_init() {
+    md_engine_init(MD_SHA1);
+}
+
+static void ntlm_init() {
+    md_engine_init(MD_NTLM);
+}
+
+// every algorithm of --hash-type
+static const HashAlgorithm ALGORITHMS[] = {
+    {HASH_MD5, "md5", 4, 32, MD_MAX_SINGLE_BLOCK, md5_batch, NULL, md5_init, md_engine_name, md_engine_lanes,
+        NULL, 1},
+    {HASH_SHA1, "sha1", 5, 40, MD_MAX_SINGLE_BLOCK, sha_1_batch, NULL, sha_1_init, md_engine_name,
+        md_engine_lanes, NULL, 1},
+    {HASH_NTLM, "ntlm", 4, 32, NTLM_MAX_SINGLE_BLOCK, ntlm_batch, NULL, ntlm_init, md_engine_name,
+        md_engine_lanes, NULL, 1},
+    {HASH_SHA256, "sha256", 8, 64, SHA_256_MAX_SINGLE_BLOCK, sha_256_digests, NULL, sha_256_engine_init,
+        sha_256_engine_name, sha_256_engine_lanes, NULL, 1},
+    {HASH_SHA512, "sha512", 16, 128, SHA_512_MAX_SINGLE_BLOCK, sha_512_batch, NULL, sha_512_engine_init,
+        sha_512_engine_name, sha_512_engine_lanes, NULL, 1},
+    // the password is the HMAC key, hashed first when longer than a block, so any length works
+    {HASH_PBKDF2_SHA256, "pbkdf2-sha256", 8, 64, MAX_WORD_LENGTH, pbkdf2_digests, pbkdf2_digests_salted,
+        sha_256_engine_init, sha_256_engine_name, sha_256_engine_lanes, NULL, 1},
+};
+#define NUM_ALGORITHMS (int)(sizeof(ALGORITHMS) / sizeof(ALGORITHMS[0]))
+
+int select_hash(const char* name) {
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        if (strcmp(ALGORITHMS[i].name, name) == 0) {
+            HASH = ALGORITHMS[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void hash_engine_init() {
+    HASH.init();
+    HASH.engine = HASH.engineName();
+    HASH.lanes = HASH.engineLanes();
+}
+
+int is_hash_length(int length) {
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        if (ALGORITHMS[i].hexLength == length) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// decode a single hexadecimal character, returns -1 if it is not a hex digit
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int hash_decode_hex(const char* hex, uint32_t* digest) {
+    for (int i = 0; i < HASH.digestWords; i++) {
+        uint32_t word = 0;
+        for (int j = 0; j < 8; j++) {
+            int v = hex_value(hex[i * 8 + j]);
+            if (v < 0) {
+                return 0;
+            }
+            word = (word << 4) | (uint32_t)v;
+        }
+        digest[i] = word;
+    }
+    return 1;
+}
+
+void hash_encode_hex(const uint32_t* digest, char* hex) {
+    for (int i = 0; i < HASH.digestWords; i++) {
+        sprintf(hex + i * 8, "%08x", digest[i]);
+    }
+}
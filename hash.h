@@ -0,0 +1,126 @@
+/** hash.h
+ * This file contains the declarations of the hash-algorithm interface, which lets the
+ * consumers, the mask workers and the target set work with any algorithm of
+ * `--hash-type`: md5, sha1, ntlm, sha256 (default), sha512 or pbkdf2-sha256. Every
+ * algorithm gives its digest size, the longest candidate its single-block fast path
+ * handles and a batch kernel, and its engine picks the fastest kernel for the CPU at
+ * startup, as the SHA-256 engine does (see sha-256-simd.h, md.h and sha-512.h).
+ *
+ * The algorithm is chosen once, before any thread starts, and copied into the global
+ * `HASH`, so the hot loops never select it again: they call `HASH.batch` once per batch
+ * of up to HASH_MAX_LANES candidates, which reaches the selected kernel directly. SHA-256
+ * keeps its shared-prefix and midstate paths (see consumer.h and mask.h), which the other
+ * algorithms do not have.
+ *
+ * PBKDF2-HMAC-SHA256 (see pbkdf2.h) is a key-derivation function rather than a hash of
+ * the candidate: its salt is a separate input, so it also gives a salted batch kernel,
+ * `HASH.saltedBatch`, which the consumers call with the salt of every candidate instead
+ * of joining the salt to it, and runs `--iterations` iterations. Each of its candidates
+ * costs thousands of compressions, so the consumers share the hashing of their word
+ * blocks batch by batch (see jobs.h).
+ *
+ * Every digest is handled as 32-bit words in the byte order of the digest, so hex hashes
+ * are decoded into the same words the kernels return and compared word by word.
+ *
+ * The main components of this file include:
+ * - The `HashAlgorithm` structure, the description and kernel of one algorithm.
+ * - select_hash(): Selects the algorithm of `--hash-type` by name.
+ * - hash_engine_init(): Selects the fastest kernel of that algorithm for the CPU.
+ * - hash_decode_hex()/hash_encode_hex(): Convert digests from and to hexadecimal.
+ */
+
+#ifndef __HASH__
+#define __HASH__
+#include <stdint.h>
+#include <stddef.h>
+
+// algorithms of --hash-type
+#define HASH_MD5 0
+#define HASH_SHA1 1
+#define HASH_NTLM 2
+#define HASH_SHA256 3
+#define HASH_SHA512 4
+#define HASH_PBKDF2_SHA256 5
+
+// 32-bit words of the longest digest, SHA-512's 512 bits
+#define HASH_MAX_WORDS 16
+// hexadecimal characters of the longest digest
+#define HASH_MAX_HEX (HASH_MAX_WORDS * 8)
+// most candidates hashed by one call of a batch kernel
+#define HASH_MAX_LANES 16
+
+/** HashBatch
+ * A batch kernel: hashes `n` (at most HASH_MAX_LANES) messages and writes their digests
+ * one after the other, `digestWords` words each.
+ */
+typedef void (*HashBatch)(const char* const*, const size_t*, int, uint32_t*);
+
+/** HashSaltedBatch
+ * A batch kernel that takes the salt of every message apart from it: hashes `n` (at most
+ * HASH_MAX_LANES) messages, each with its own salt, and writes their digests one after
+ * the other, `digestWords` words each.
+ */
+typedef void (*HashSaltedBatch)(const char* const*, const size_t*, const char* const*, const size_t*, int,
+    uint32_t*);
+
+/** HashAlgorithm
+ * One algorithm of `--hash-type`. The engine fields are only set by hash_engine_init().
+ */
+typedef struct {
+    int type;                    // HASH_MD5, HASH_SHA1, HASH_NTLM, HASH_SHA256, HASH_SHA512 or HASH_PBKDF2_SHA256
+    const char* name;            // Name given to --hash-type
+    int digestWords;             // Size of a digest in 32-bit words
+    int hexLength;               // Size of a digest in hexadecimal characters
+    int maxSingleBlock;          // Longest candidate hashed in a single block
+    HashBatch batch;             // Batch kernel of the selected engine
+    HashSaltedBatch saltedBatch; // Kernel taking salts apart, NULL if salts join the message
+    void (*init)();              // Selects the fastest kernel for the CPU
+    const char* (*engineName)(); // Name of the selected kernel
+    int (*engineLanes)();        // Candidates hashed per pass of the selected kernel
+    const char* engine;          // Name of the selected kernel, once initialized
+    int lanes;                   // Candidates hashed per pass, once initialized
+} HashAlgorithm;
+
+// algorithm of --hash-type and its selected kernel
+extern HashAlgorithm HASH;
+
+/** select_hash()
+ * This function copies the algorithm called `name` into the global `HASH`. It must be
+ * called before the target file is loaded, which needs the size of the digests.
+ *
+ * @param name Name of the algorithm, e.g. "md5".
+ * @return int 1 on success, 0 if there is no such algorithm.
+ */
+int select_hash(const char*);
+
+/** hash_engine_init()
+ * This function measures the kernels of the selected algorithm and keeps the fastest
+ * (see sha-256-simd.h). It must be called once by main before any thread is created.
+ */
+void hash_engine_init();
+
+/** is_hash_length()
+ * @param length Number of hexadecimal characters.
+ * @return int 1 if some algorithm has digests of that many hex characters, 0 otherwise.
+ */
+int is_hash_length(int);
+
+/** hash_decode_hex()
+ * This function decodes a digest of the selected algorithm from hexadecimal, in either
+ * case, into 32-bit words in the byte order of the digest.
+ *
+ * @param hex The hash, at least `HASH.hexLength` characters.
+ * @param digest Receives `HASH.digestWords` words.
+ * @return int 1 on success, 0 if a character is not a hex digit.
+ */
+int hash_decode_hex(const char*, uint32_t*);
+
+/** hash_encode_hex()
+ * This function formats a digest of the selected algorithm as lowercase hexadecimal.
+ *
+ * @param digest The digest, `HASH.digestWords` words.
+ * @param hex Output buffer of at least `HASH.hexLength + 1` characters.
+ */
+void hash_encode_hex(const uint32_t*, char*);
+
+#endif
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "jobs.h"
+#include "targets.h"
+#include "global.h"
+
+void init_jobs(int numConsumers) {
+    JOBS.jobs = calloc(numConsumers, sizeof(CandidateJob*));
+    JOBS.numConsumers = numConsumers;
+    JOBS.numWorking = numConsumers;
+    JOBS.next = 0;
+    pthread_mutex_init(&JOBS.mutex, NULL);
+    pthread_cond_init(&JOBS.changed, NULL);
+}
+
+void free_jobs() {
+    free(JOBS.jobs);
+    JOBS.jobs = NULL;
+    pthread_mutex_destroy(&JOBS.mutex);
+    pthread_cond_destroy(&JOBS.changed);
+}
+
+void job_init(CandidateJob* job) {
+    job->textCapacity = 4096;
+    job->text = malloc(job->textCapacity);
+    job->capacity = 256;
+    job->offsets = malloc(job->capacity * sizeof(int));
+    job->lens = malloc(job->capacity * sizeof(int));
+    job_clear(job);
+}
+
+void job_free(CandidateJob* job) {
+    free(job->text);
+    free(job->offsets);
+    free(job->lens);
+}
+
+void job_clear(CandidateJob* job) {
+    job->textSize = 0;
+    job->numCandidates = 0;
+    job->numBatches = 0;
+    job->nextBatch = 0;
+    job->doneBatches = 0;
+    job->retiring = 0;
+}
+
+void job_add(CandidateJob* job, const char* text, int len) {
+    // the arena and the index grow with the largest block seen, then stay allocated
+    if (job->numCandidates == job->capacity) {
+        job->capacity *= 2;
+        job->offsets = realloc(job->offsets, job->capacity * sizeof(int));
+        job->lens = realloc(job->lens, job->capacity * sizeof(int));
+    }
+    while (job->textSize + len > job->textCapacity) {
+        job->textCapacity *= 2;
+        job->text = realloc(job->text, job->textCapacity);
+    }
+    memcpy(job->text + job->textSize, text, len);
+    job->offsets[job->numCandidates] = job->textSize;
+    job->lens[job->numCandidates] = len;
+    job->textSize += len;
+    job->numCandidates++;
+}
+
+void publish_job(int id, CandidateJob* job, int lanes) {
+    pthread_mutex_lock(&JOBS.mutex);
+    job->lanes = lanes;
+    job->batchesPerSalt = (job->numCandidates + lanes - 1) / lanes;
+    job->numBatches = job->batchesPerSalt * TARGETS.numSalts;
+    job->nextBatch = 0;
+    job->doneBatches = 0;
+    job->retiring = 0;
+    JOBS.jobs[id] = job;
+    // wake the helpers waiting for work
+    pthread_cond_broadcast(&JOBS.changed);
+    pthread_mutex_unlock(&JOBS.mutex);
+}
+
+int take_batch(CandidateJob* job) {
+    int batch = -1;
+    pthread_mutex_lock(&JOBS.mutex);
+    if (!isFound && job->nextBatch < job->numBatches) {
+        batch = job->nextBatch++;
+    }
+    pthread_mutex_unlock(&JOBS.mutex);
+    return batch;
+}
+
+CandidateJob* help_batch(int* batch) {
+    pthread_mutex_lock(&JOBS.mutex);
+    while (!isFound) {
+        // look at the consumers in turn, so helpers spread over the jobs
+        for (int k = 0; k < JOBS.numConsumers; k++) {
+            int id = (JOBS.next + k) % JOBS.numConsumers;
+            CandidateJob* job = JOBS.jobs[id];
+            if (job != NULL && job->nextBatch < job->numBatches) {
+                *batch = job->nextBatch++;
+                JOBS.next = (id + 1) % JOBS.numConsumers;
+                pthread_mutex_unlock(&JOBS.mutex);
+                return job;
+            }
+        }
+        // every job has been taken and no consumer will publish another
+        if (JOBS.numWorking == 0) {
+            break;
+        }
+        pthread_cond_wait(&JOBS.changed, &JOBS.mutex);
+    }
+    pthread_mutex_unlock(&JOBS.mutex);
+    return NULL;
+}
+
+int job_batch(const CandidateJob* job, int batch, int* salt, int* first) {
+    *salt = batch / job->batchesPerSalt;
+    *first = (batch % job->batchesPerSalt) * job->lanes;
+    int count = job->numCandidates - *first;
+    return count < job->lanes ? count : job->lanes;
+}
+
+void batch_done(CandidateJob* job) {
+    pthread_mutex_lock(&JOBS.mutex);
+    job->doneBatches++;
+    // the owner waits for the last batch a helper took
+    if (job->retiring && job->doneBatches == job->nextBatch) {
+        pthread_cond_broadcast(&JOBS.changed);
+    }
+    pthread_mutex_unlock(&JOBS.mutex);
+}
+
+int retire_job(int id, CandidateJob* job) {
+    pthread_mutex_lock(&JOBS.mutex);
+    JOBS.jobs[id] = NULL;
+    // no batch is taken from now on, wait for the ones already taken
+    int complete = job->nextBatch == job->numBatches;
+    job->numBatches = job->nextBatch;
+    job->retiring = 1;
+    while (job->doneBatches < job->nextBatch) {
+        pthread_cond_wait(&JOBS.changed, &JOBS.mutex);
+    }
+    pthread_mutex_unlock(&JOBS.mutex);
+    return complete;
+}
+
+void stop_working() {
+    pthread_mutex_lock(&JOBS.mutex);
+    JOBS.numWorking--;
+    // helpers waiting for a job may now be done
+    pthread_cond_broadcast(&JOBS.changed);
+    pthread_mutex_unlock(&JOBS.mutex);
+}
@@ -0,0 +1,175 @@
+/** jobs.h
+ * This file contains the declarations of the candidate jobs, which spread the hashing of
+ * slow hashes (`HASH.saltedBatch`, e.g. PBKDF2, see hash.h) over the consumers at the
+ * granularity of candidates instead of words. With thousands of iterations per candidate,
+ * the candidates of a single word take seconds, so the consumer that happens to hold the
+ * last block of the dictionary would otherwise finish it alone while the others sit idle.
+ *
+ * A consumer turns its whole block into a job: the list of every candidate of its words,
+ * generated once, to be hashed with every salt. The job is split into lane-sized batches,
+ * numbered salt by salt, and published on the global job board (`JOBS`). The owner hashes
+ * batch after batch, and so does any consumer that has run out of blocks, so the last
+ * jobs of a run are shared by every consumer. The owner retires its job once every batch
+ * has been taken and waits for the helpers to finish theirs, so the block is only marked
+ * done and recycled when all of its candidates have been hashed.
+ *
+ * Batches are taken under the board's mutex. A batch is at least a whole pass of the hash
+ * kernel over thousands of iterations, so the lock is negligible next to it.
+ *
+ * The main components of this file include:
+ * - The `CandidateJob` structure, the candidates of one block and its batch counters.
+ * - The `JobBoard` structure, the published job of every consumer.
+ * - job_add(): Adds a candidate to a job being built.
+ * - publish_job()/take_batch()/retire_job(): The owner's side of a job.
+ * - help_batch()/batch_done(): Any consumer's side of a job.
+ */
+
+#ifndef __JOBS__
+#define __JOBS__
+#include <stddef.h>
+#include <pthread.h>
+
+/** CandidateJob
+ * The candidates of one block of words, stored one after the other in a growable arena,
+ * and the batches they are hashed in. Batch `b` hashes up to `lanes` candidates, starting
+ * at candidate (b % batchesPerSalt) * lanes, with salt b / batchesPerSalt. The batch
+ * counters are only accessed while holding `JOBS.mutex`.
+ */
+typedef struct {
+    char* text;                  // Candidates of the job, one after the other
+    size_t textSize;             // Number of characters used in `text`
+    size_t textCapacity;         // Allocated size of `text`
+    int* offsets;                // Offset of each candidate in `text`
+    int* lens;                   // Length of each candidate
+    int numCandidates;           // Number of candidates of the job
+    int capacity;                // Allocated entries of `offsets` and `lens`
+    int lanes;                   // Candidates per batch
+    int batchesPerSalt;          // Number of batches of each salt
+    int numBatches;              // Number of batches of the job
+    int nextBatch;               // Next batch to take
+    int doneBatches;             // Number of batches taken and hashed
+    int retiring;                // Flag set while the owner waits for the helpers
+} CandidateJob;
+
+/** JobBoard
+ * The job published by every consumer, and the consumers that may still publish one.
+ */
+typedef struct {
+    CandidateJob** jobs;         // Published job of each consumer, NULL if none
+    int numConsumers;            // Number of consumers
+    int numWorking;              // Number of consumers still reading blocks
+    int next;                    // Consumer whose job a helper looks at first
+    pthread_mutex_t mutex;       // Mutex protecting the board and the batch counters
+    pthread_cond_t changed;      // Signaled when a job is published or a helper finishes
+} JobBoard;
+
+// candidate jobs shared by the consumers of a slow hash type
+extern JobBoard JOBS;
+
+/** init_jobs()
+ * This function sets up an empty job board for the consumers.
+ *
+ * @param numConsumers Number of consumer threads, all initially working.
+ */
+void init_jobs(int);
+
+/** free_jobs()
+ * This function releases the job board.
+ */
+void free_jobs();
+
+/** job_init()
+ * This function allocates an empty job.
+ *
+ * @param job The job to allocate.
+ */
+void job_init(CandidateJob*);
+
+/** job_free()
+ * This function releases a job's memory.
+ *
+ * @param job The job to free.
+ */
+void job_free(CandidateJob*);
+
+/** job_clear()
+ * This function empties an unpublished job so it can be filled again.
+ *
+ * @param job The job to empty.
+ */
+void job_clear(CandidateJob*);
+
+/** job_add()
+ * This function adds a candidate to an unpublished job.
+ *
+ * @param job The job being built.
+ * @param text The characters of the candidate, not necessarily terminated.
+ * @param len The length of the candidate.
+ */
+void job_add(CandidateJob*, const char*, int);
+
+/** publish_job()
+ * This function splits a job into batches of `lanes` candidates for every salt of the
+ * target set and publishes it as the job of consumer `id`.
+ *
+ * @param id Index of the owning consumer.
+ * @param job The job, which must not be modified until it is retired.
+ * @param lanes Number of candidates per batch, at most HASH_MAX_LANES.
+ */
+void publish_job(int, CandidateJob*, int);
+
+/** take_batch()
+ * This function takes the next batch of the caller's own job, unless every target has
+ * been cracked. The batch must be handed back with batch_done() once it is hashed.
+ *
+ * @param job The caller's published job.
+ * @return int Index of the batch, or -1 if there are none left.
+ */
+int take_batch(CandidateJob*);
+
+/** help_batch()
+ * This function is called by a consumer with no block left: it takes a batch of any
+ * published job, waiting for one while other consumers are still reading blocks.
+ *
+ * @param batch Receives the index of the batch.
+ * @return CandidateJob* The job of the batch, or NULL once no consumer reads blocks
+ * anymore and every job has been taken, or every target has been cracked.
+ */
+CandidateJob* help_batch(int*);
+
+/** job_batch()
+ * This function gives the salt and candidates of a batch.
+ *
+ * @param job The job.
+ * @param batch Index of the batch.
+ * @param salt Receives the index of the salt of the batch.
+ * @param first Receives the index of the first candidate of the batch.
+ * @return int Number of candidates of the batch.
+ */
+int job_batch(const CandidateJob*, int, int*, int*);
+
+/** batch_done()
+ * This function records that a batch taken with take_batch() or help_batch() has been
+ * hashed. The caller must not touch the job afterwards unless it owns it.
+ *
+ * @param job The job of the batch.
+ */
+void batch_done(CandidateJob*);
+
+/** retire_job()
+ * This function withdraws the job of consumer `id` from the board, so no further batch
+ * is taken, and waits until every batch taken by a helper has been hashed.
+ *
+ * @param id Index of the owning consumer.
+ * @param job The job.
+ * @return int 1 if every batch of the job was taken, 0 if it stopped early because every
+ * target was cracked.
+ */
+int retire_job(int, CandidateJob*);
+
+/** stop_working()
+ * This function records that a consumer has no block left and only helps from now on.
+ */
+void stop_working();
+
+#endif
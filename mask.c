@@ -0,0 +1,389 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "sha-256.h"
+#include "sha-256-simd.h"
+#include "mask.h"
+#include "sink.h"
+#include "topology.h"
+#include "checkpoint.h"
+#include "hash.h"
+#include "metrics.h"
+#include "targets.h"
+#include "global.h"
+
+// built-in charsets, referenced as ?<name>
+static const char* LOWER = "abcdefghijklmnopqrstuvwxyz";
+static const char* UPPER = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static const char* DIGITS = "0123456789";
+static const char* SYMBOLS = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+static const char* HEX_LOWER = "0123456789abcdef";
+static const char* HEX_UPPER = "0123456789ABCDEF";
+
+// append the characters of a placeholder to a charset, returns 0 if it is undefined
+static int add_placeholder(char name, char** custom, int depth, char* set, int* size, int* seen);
+
+// append every character of `text` to a charset, expanding placeholders and skipping
+// repeated characters, returns 0 if the text references an undefined charset
+static int add_charset(const char* text, char** custom, int depth, char* set, int* size, int* seen) {
+    for (const char* p = text; *p != '\0'; p++) {
+        if (*p == '?' && p[1] != '\0') {
+            if (!add_placeholder(*++p, custom, depth, set, size, seen)) {
+                return 0;
+            }
+        }
+        else if (!seen[(unsigned char)*p]) {
+            seen[(unsigned char)*p] = 1;
+            set[(*size)++] = *p;
+        }
+    }
+    return 1;
+}
+
+static int add_placeholder(char name, char** custom, int depth, char* set, int* size, int* seen) {
+    switch (name) {
+        case 'l': return add_charset(LOWER, custom, depth, set, size, seen);
+        case 'u': return add_charset(UPPER, custom, depth, set, size, seen);
+        case 'd': return add_charset(DIGITS, custom, depth, set, size, seen);
+        case 'h': return add_charset(HEX_LOWER, custom, depth, set, size, seen);
+        case 'H': return add_charset(HEX_UPPER, custom, depth, set, size, seen);
+        case 's':
+            // symbols contain a literal '?', which must not start a placeholder
+            for (const char* p = SYMBOLS; *p != '\0'; p++) {
+                if (!seen[(unsigned char)*p]) {
+                    seen[(unsigned char)*p] = 1;
+                    set[(*size)++] = *p;
+                }
+            }
+            return 1;
+        case 'a':
+            return add_placeholder('l', custom, depth, set, size, seen)
+                && add_placeholder('u', custom, depth, set, size, seen)
+                && add_placeholder('d', custom, depth, set, size, seen)
+                && add_placeholder('s', custom, depth, set, size, seen);
+        case '?':
+            if (!seen['?']) {
+                seen['?'] = 1;
+                set[(*size)++] = '?';
+            }
+            return 1;
+        case '1': case '2': case '3': case '4':
+            // custom charsets may use the built-in placeholders, but not each other
+            if (depth > 0 || custom[name - '1'] == NULL) {
+                return 0;
+            }
+            return add_charset(custom[name - '1'], custom, depth + 1, set, size, seen);
+    }
+    return 0;
+}
+
+void load_mask(const char* mask, char** custom) {
+    MASK.length = 0;
+    MASK.keyspace = 1;
+
+    for (const char* p = mask; *p != '\0'; p++) {
+        if (MASK.length == MAX_MASK_LENGTH) {
+            printf("error: mask is longer than %d positions\n", MAX_MASK_LENGTH);
+            exit(1);
+        }
+        int seen[256] = {0};
+        int size = 0;
+        char* set = MASK.charsets[MASK.length];
+        if (*p == '?') {
+            if (p[1] == '\0' || !add_placeholder(*++p, custom, 0, set, &size, seen)) {
+                printf("error: invalid placeholder in mask '%s'\n", mask);
+                exit(1);
+            }
+        }
+        else {
+            set[size++] = *p;
+        }
+        if (size == 0) {
+            printf("error: empty charset in mask '%s'\n", mask);
+            exit(1);
+        }
+        // the keyspace is indexed with 64-bit integers
+        if (MASK.keyspace > UINT64_MAX / (uint64_t)size) {
+            printf("error: keyspace of mask '%s' does not fit in 64 bits\n", mask);
+            exit(1);
+        }
+        MASK.keyspace *= size;
+        MASK.sizes[MASK.length++] = size;
+    }
+    if (MASK.length == 0) {
+        printf("error: empty mask\n");
+        exit(1);
+    }
+}
+
+void mask_candidate(uint64_t index, char* word) {
+    // the last position is the least significant digit of the index
+    for (int p = MASK.length - 1; p >= 0; p--) {
+        word[p] = MASK.charsets[p][index % MASK.sizes[p]];
+        index /= MASK.sizes[p];
+    }
+    word[MASK.length] = '\0';
+}
+
+// set character `pos` of a padded single block
+static void set_block_char(uint32_t block[16], int pos, char c) {
+    int shift = 24 - 8 * (pos & 3);
+    block[pos >> 2] = (block[pos >> 2] & ~(0xffu << shift)) | ((uint32_t)(unsigned char)c << shift);
+}
+
+// step the odometer to the next candidate, returns the first position that changed
+static int advance(int* digits, char* word) {
+    int p = MASK.length - 1;
+    while (p >= 0) {
+        if (++digits[p] < MASK.sizes[p]) {
+            word[p] = MASK.charsets[p][digits[p]];
+            return p;
+        }
+        // wrap this position around and carry into the previous one
+        digits[p] = 0;
+        word[p] = MASK.charsets[p][0];
+        p--;
+    }
+    return 0;
+}
+
+// look a digest hashed with a salt up and report it if it is a new hit, returns 1 if it was
+static int check_candidate(const uint32_t* digest, int salt, const char* word, int len, FILE* outfile) {
+    int index = find_target(digest, salt);
+    if (index < 0) {
+        return 0;
+    }
+    int isNew = mark_cracked(index);
+    if (isNew) {
+        char password[MAX_WORD_LENGTH];
+        memcpy(password, word, len);
+        password[len] = '\0';
+        output_to_file(outfile, index, password);
+    }
+    return isNew;
+}
+
+// hash_mask_range() for the algorithms without a shared-prefix kernel and for salted
+// targets: every batch of candidates is stepped by the odometer, then hashed with every
+// salt, and the batch kernel pads each message into its own block (or, for a salted
+// kernel, takes the salt of every lane apart)
+static int hash_mask_batches(const char* word, int len, uint64_t start, uint64_t end, FILE* outfile,
+        atomic_ullong* progress) {
+    int length = MASK.length;
+    int total = len + length;
+    int prepend = OPTIONS.maskSide == MASK_PREPEND;
+    int at = prepend ? 0 : len;
+    int lanes = HASH.lanes;
+    int cracked = 0;
+    int digits[MAX_MASK_LENGTH];
+    char text[MAX_WORD_LENGTH];
+    char words[HASH_MAX_LANES][MAX_WORD_LENGTH];
+    // every candidate joined to the current salt, unless the salt is empty or a prefix
+    char salted[HASH_MAX_LANES][MAX_WORD_LENGTH + MAX_SALT_LENGTH];
+    const char* msgs[HASH_MAX_LANES];
+    size_t lens[HASH_MAX_LANES];
+    const struct sha_256_prefix* prefixes[HASH_MAX_LANES];
+    const char* saltTexts[HASH_MAX_LANES];
+    size_t saltLens[HASH_MAX_LANES];
+    uint32_t digests[HASH_MAX_LANES * HASH_MAX_WORDS];
+    int saltPrefixes = HASH.type == HASH_SHA256 && OPTIONS.saltSide == SALT_PREPEND;
+    int saltAt = OPTIONS.saltSide == SALT_PREPEND ? 0 : total;
+
+    if (total > MAX_WORD_LENGTH - 1) {
+        return 0;
+    }
+    memcpy(text + (prepend ? length : 0), word, len);
+    uint64_t rest = start;
+    for (int p = length - 1; p >= 0; p--) {
+        digits[p] = rest % MASK.sizes[p];
+        rest /= MASK.sizes[p];
+        text[at + p] = MASK.charsets[p][digits[p]];
+    }
+
+    uint64_t index = start;
+    while (index < end && !isFound) {
+        int count = end - index < (uint64_t)lanes ? (int)(end - index) : lanes;
+        for (int i = 0; i < count; i++) {
+            memcpy(words[i], text, total);
+            advance(digits, text + at);
+        }
+        // the batch stays in cache while it is hashed with every salt in turn
+        for (int t = 0; t < TARGETS.numSalts && !isFound; t++) {
+            const Salt* salt = &TARGETS.salts[t];
+            // every target of this salt has been cracked
+            if (atomic_load_explicit(&salt->numLeft, memory_order_relaxed) == 0) {
+                continue;
+            }
+            for (int i = 0; i < count; i++) {
+                if (salt->len == 0 || saltPrefixes || HASH.saltedBatch != NULL) {
+                    msgs[i] = words[i];
+                    lens[i] = total;
+                    prefixes[i] = &salt->prefix;
+                    saltTexts[i] = salt->text;
+                    saltLens[i] = salt->len;
+                    continue;
+                }
+                // the candidate keeps its place, the salt goes before or after it
+                memcpy(salted[i] + (OPTIONS.saltSide == SALT_PREPEND ? salt->len : 0), words[i], total);
+                memcpy(salted[i] + saltAt, salt->text, salt->len);
+                msgs[i] = salted[i];
+                lens[i] = total + salt->len;
+            }
+            // a key-derivation hash takes the salt apart from the candidate
+            if (HASH.saltedBatch != NULL) {
+                HASH.saltedBatch(msgs, lens, saltTexts, saltLens, count, digests);
+            }
+            // a prepended salt resumes from its precomputed SHA-256 state
+            else if (saltPrefixes && salt->len > 0) {
+                sha_256_prefix_batch(prefixes, msgs, lens, count, (uint32_t (*)[8])digests);
+            }
+            else {
+                HASH.batch(msgs, lens, count, digests);
+            }
+            for (int i = 0; i < count; i++) {
+                cracked += check_candidate(digests + i * HASH.digestWords, t, words[i], total, outfile);
+            }
+            metrics_add(METRIC_HASHES, count);
+        }
+        index += count;
+        atomic_store_explicit(progress, index, memory_order_release);
+    }
+    return cracked;
+}
+
+int hash_mask_range(const char* word, int len, uint64_t start, uint64_t end, FILE* outfile,
+        atomic_ullong* progress) {
+    if (HASH.type != HASH_SHA256 || TARGETS.salted) {
+        return hash_mask_batches(word, len, start, end, outfile, progress);
+    }
+    int length = MASK.length;
+    int total = len + length;
+    int prepend = OPTIONS.maskSide == MASK_PREPEND;
+    int lanes = HASH.lanes;
+    int cracked = 0;
+    // odometer digits, and the whole candidate with the mask at `at`
+    int digits[MAX_MASK_LENGTH];
+    char text[MAX_WORD_LENGTH];
+    int at = prepend ? 0 : len;
+    // candidate text, last block and hash state of every lane of a batch
+    char words[SHA_256_MAX_LANES][MAX_WORD_LENGTH];
+    uint32_t blocks[SHA_256_MAX_LANES][16];
+    uint32_t state[SHA_256_MAX_LANES][8];
+    const char* tails[SHA_256_MAX_LANES];
+    size_t tailLens[SHA_256_MAX_LANES];
+    const struct sha_256_prefix* prefixes[SHA_256_MAX_LANES];
+    // the fixed head of every candidate (an appended-to word) is hashed once, and its
+    // last block, mask included, is kept ready-padded when it fits
+    struct sha_256_prefix prefix;
+    uint32_t current[16];
+    int head = prepend ? 0 : len;
+
+    if (total > MAX_WORD_LENGTH - 1) {
+        return 0;
+    }
+    if (prepend) {
+        memcpy(text + length, word, len);
+    }
+    else {
+        memcpy(text, word, len);
+    }
+
+    // decode the start of the range once, every later candidate is an odometer step
+    uint64_t rest = start;
+    for (int p = length - 1; p >= 0; p--) {
+        digits[p] = rest % MASK.sizes[p];
+        rest /= MASK.sizes[p];
+        text[at + p] = MASK.charsets[p][digits[p]];
+    }
+    sha_256_prefix_init(&prefix, text, head);
+    int single = sha_256_prefix_block(&prefix, current, text + head, total - head);
+    // byte of the last block holding the first mask position
+    int maskByte = (int)prefix.partial + at - head;
+    // every lane resumes after the rounds the fixed head already ran
+    uint32_t work[SHA_256_MAX_LANES][8];
+    for (int i = 0; i < lanes; i++) {
+        memcpy(work[i], prefix.work, sizeof(work[i]));
+    }
+
+    uint64_t index = start;
+    while (index < end && !isFound) {
+        int count = end - index < (uint64_t)lanes ? (int)(end - index) : lanes;
+        for (int i = 0; i < count; i++) {
+            memcpy(words[i], text, total);
+            if (single) {
+                memcpy(blocks[i], current, sizeof(current));
+                memcpy(state[i], prefix.h, sizeof(state[i]));
+            }
+            else {
+                prefixes[i] = &prefix;
+                tails[i] = words[i] + head;
+                tailLens[i] = total - head;
+            }
+            // rewrite only the trailing mask characters that changed
+            int changed = advance(digits, text + at);
+            if (single) {
+                for (int p = changed; p < length; p++) {
+                    set_block_char(current, maskByte + p, text[at + p]);
+                }
+            }
+        }
+
+        if (single) {
+            sha_256_compress_from_batch(state, (const uint32_t (*)[8])work, (const uint32_t (*)[16])blocks,
+                prefix.rounds, count);
+        }
+        else {
+            sha_256_prefix_batch(prefixes, tails, tailLens, count, state);
+        }
+        for (int i = 0; i < count; i++) {
+            cracked += check_candidate(state[i], 0, words[i], total, outfile);
+        }
+        index += count;
+        atomic_store_explicit(progress, index, memory_order_release);
+        metrics_add(METRIC_HASHES, count);
+    }
+    return cracked;
+}
+
+void* mask_worker(void* arg) {
+    struct maskData* data = (struct maskData*)arg;
+    pin_thread(ROLE_CONSUMER, data->id);
+    metrics_register(ROLE_CONSUMER, data->id);
+    // a plain mask attack is a hybrid attack on the empty word
+    hash_mask_range("", 0, data->start, data->end, data->outputFile, &data->range->watermark);
+    pthread_exit(NULL);
+}
+
+uint64_t run_mask_attack(int numWorkers, FILE* outfile) {
+    struct maskData* data = malloc(numWorkers * sizeof(struct maskData));
+    pthread_t* ids = malloc(numWorkers * sizeof(pthread_t));
+
+    printf("keyspace:    %llu candidates of length %d\n", (unsigned long long)MASK.keyspace, MASK.length);
+
+    // one contiguous range of the keyspace per worker (see checkpoint.h), continued
+    // from its watermark when the run is resumed
+    for (int i = 0; i < numWorkers; i++) {
+        data[i].id = i;
+        data[i].range = &CHECKPOINT.ranges[i];
+        data[i].start = data[i].range->resume;
+        data[i].end = data[i].range->end;
+        data[i].outputFile = outfile;
+        pthread_create(&ids[i], NULL, mask_worker, &data[i]);
+    }
+
+    // the reporter thread prints the progress meanwhile (see metrics.h)
+    for (int i = 0; i < numWorkers; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    // count the candidates hashed by this run only
+    uint64_t done = 0;
+    for (int i = 0; i < numWorkers; i++) {
+        done += atomic_load(&data[i].range->watermark) - data[i].start;
+    }
+    free(data);
+    free(ids);
+    return done;
+}
@@ -0,0 +1,139 @@
+/** mask.h
+ * This file contains the declarations of the mask (brute-force) attack, selected with
+ * `--mask` when no dictionary is given, and of the hybrid attack, which combines every
+ * candidate of a dictionary and its rules with every candidate of a mask. A mask such as
+ * `?u?l?l?l?d?d?d?d` gives the set of characters tried at each position:
+ *   ?l  abcdefghijklmnopqrstuvwxyz      ?u  ABCDEFGHIJKLMNOPQRSTUVWXYZ
+ *   ?d  0123456789                      ?s  the printable ASCII symbols and space
+ *   ?a  ?l?u?d?s                        ?h  0123456789abcdef
+ *   ?H  0123456789ABCDEF                ?1-?4  the custom charsets of --charset1-4
+ *   ??  a literal '?'                   any other character stands for itself
+ *
+ * Every candidate is numbered by its index in the keyspace, with the last position
+ * changing fastest. The keyspace is split into one contiguous range per worker thread,
+ * so there is no queue at all: each worker decodes the start of its range once and then
+ * steps through it like an odometer, rewriting only the trailing characters that changed
+ * directly in the padded SHA-256 block of the previous candidate.
+ *
+ * In a hybrid attack the word is the fixed part of thousands of candidates, so the work
+ * that only depends on it is done once per word: when the mask is appended, the word is
+ * hashed as a shared prefix (see sha-256.h), which covers its complete blocks and the
+ * rounds its complete words fix in the last one, and every candidate only finishes the
+ * rounds that depend on the mask.
+ *
+ * The main components of this file include:
+ * - The `MaskAttack` structure, the parsed mask.
+ * - The `maskData` structure, which holds the range of one worker thread.
+ * - load_mask(): Parses the mask into the global `MASK`.
+ * - mask_candidate(): Decodes a keyspace index into its candidate.
+ * - hash_mask_range(): Hashes a range of the mask joined to a fixed word.
+ * - mask_worker(): Thread function that hashes one range of the keyspace.
+ * - run_mask_attack(): Runs the workers until they finish.
+ */
+
+#ifndef __MASK__
+#define __MASK__
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "checkpoint.h"
+#include "global.h"
+
+// longest mask, which leaves room for the terminator of a candidate
+#define MAX_MASK_LENGTH (MAX_WORD_LENGTH - 1)
+
+/** MaskAttack
+ * The parsed mask, shared by the workers of a mask or hybrid attack.
+ */
+typedef struct {
+    int length;                              // Number of positions, the candidate length
+    char charsets[MAX_MASK_LENGTH][256];     // Characters tried at each position
+    int sizes[MAX_MASK_LENGTH];              // Number of characters at each position
+    uint64_t keyspace;                       // Number of candidates, the product of the sizes
+} MaskAttack;
+
+// parsed mask of the mask attack
+extern MaskAttack MASK;
+
+/** maskData
+ * This structure contains the information needed by each mask worker thread: its range
+ * of the keyspace, the output file and its checkpoint range, whose watermark records its
+ * progress while it runs.
+ */
+struct maskData {
+    int id;
+    uint64_t start;              // First keyspace index hashed by this run
+    uint64_t end;                // One past the last keyspace index of the range
+    FILE* outputFile;
+    ProgressRange* range;        // Checkpoint range of the worker
+};
+
+/** load_mask()
+ * This function parses a mask and the custom charsets it may reference into the global
+ * `MASK` and computes its keyspace. Custom charsets may themselves use the built-in
+ * placeholders (e.g. `?l?d`), and repeated characters are only tried once. If the mask
+ * is empty, too long, references an undefined charset or its keyspace does not fit in
+ * 64 bits, the function prints an error and exits.
+ *
+ * @param mask The mask.
+ * @param custom Array of 4 custom charsets, `custom[i]` is `?{i + 1}`, NULL if unset.
+ */
+void load_mask(const char*, char**);
+
+/** mask_candidate()
+ * This function decodes a keyspace index into its candidate.
+ *
+ * @param index The keyspace index, less than `MASK.keyspace`.
+ * @param word Array of at least MASK.length + 1 characters that receives the
+ * terminated candidate.
+ */
+void mask_candidate(uint64_t, char*);
+
+/** hash_mask_range()
+ * This function hashes the candidates of a range of the keyspace joined to a fixed word,
+ * which comes before the mask or, with `--mask-side prepend`, after it. Candidates are
+ * hashed in batches of `HASH.lanes`, each generated from the previous by an odometer step
+ * that only rewrites the mask characters that changed. With SHA-256, the prefix before
+ * the mask is hashed once; when the rest of the candidate fits in its last block, that
+ * block is kept ready-padded and each batch resumes after the rounds the prefix fixed,
+ * otherwise candidates go through `sha_256_prefix_batch`. The other algorithms hash every
+ * batch with `HASH.batch` (see hash.h), as does a salted hash file, whose batches are
+ * hashed with every salt in turn (a prepended SHA-256 salt resuming from its precomputed
+ * state). Every hit is marked as cracked and written to the output file, and the function
+ * stops early once every target is cracked (`isFound` flag is set). Words too long to be
+ * joined to the mask are skipped.
+ *
+ * @param word The characters of the fixed word, not necessarily terminated.
+ * @param len The length of the word, 0 for a plain mask attack.
+ * @param start First keyspace index of the range.
+ * @param end One past the last keyspace index of the range.
+ * @param outfile The output file where cracked passwords are written.
+ * @param progress Receives the keyspace index below which every candidate of the range
+ * has been hashed.
+ * @return int Number of targets newly cracked.
+ */
+int hash_mask_range(const char*, int, uint64_t, uint64_t, FILE*, atomic_ullong*);
+
+/** mask_worker()
+ * This function is executed by the worker threads of a mask attack. Each worker hashes
+ * the candidates of its own range of the keyspace with `hash_mask_range`, joined to the
+ * empty word.
+ *
+ * @param arg Pointer to a `maskData` structure containing the range and output file.
+ * @return void* Always returns NULL.
+ */
+void* mask_worker(void*);
+
+/** run_mask_attack()
+ * This function runs one worker per contiguous range of the keyspace (see checkpoint.h)
+ * until they have all finished or every target is cracked. The reporter thread prints
+ * the progress meanwhile (see metrics.h).
+ *
+ * @param numWorkers Number of worker threads.
+ * @param outfile The output file where cracked passwords are written.
+ * @return uint64_t Number of candidates hashed.
+ */
+uint64_t run_mask_attack(int, FILE*);
+
+#endif
@@ -0,0 +1,429 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "sha-256.h"
+#include "md.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MD_X86 1
+#endif
+
+/*
+ * A kernel compresses n independent (state, block) pairs in place. States are five words
+ * wide, MD5 and MD4 only use the first four.
+ */
+typedef void (*md_fn)(uint32_t (*state)[5], const uint32_t (*block)[16], int n);
+
+/* MD5 additive constants, the integer part of 2^32 * |sin(i + 1)|. */
+static const uint32_t md5_k[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+/* Initial hash values of every algorithm; MD4 starts from the same values as MD5. */
+static const uint32_t md_h0[3][5] = {
+	{ 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0 },
+	{ 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0 },
+	{ 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 },
+};
+
+/*
+ * Scalar: the template with a single lane of plain 32-bit words, also used for the
+ * blocks of long messages.
+ */
+#define MD5_FN md5_scalar
+#define MD4_FN md4_scalar
+#define SHA_1_FN sha_1_scalar
+#define LANES_ATTR
+#define LANES 1
+#define VEC uint32_t
+#define V_ADD(a, b) ((a) + (b))
+#define V_XOR(a, b) ((a) ^ (b))
+#define V_XOR3(a, b, c) ((a) ^ (b) ^ (c))
+#define V_ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define V_CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define V_MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define V_MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+#define V_SET1(x) ((uint32_t) (x))
+#define V_LOAD(p) (*(p))
+#define V_STORE(p, x) (*(p) = (x))
+#include "md-lanes.inc"
+#undef MD5_FN
+#undef MD4_FN
+#undef SHA_1_FN
+#undef LANES_ATTR
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR
+#undef V_XOR3
+#undef V_ROL
+#undef V_CH
+#undef V_MAJ
+#undef V_MD5_I
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+#ifdef MD_X86
+
+/*
+ * SSE4.1, 4 lanes.
+ */
+#define MD5_FN md5_sse41
+#define MD4_FN md4_sse41
+#define SHA_1_FN sha_1_sse41
+#define LANES_ATTR __attribute__((target("sse4.1")))
+#define LANES 4
+#define VEC __m128i
+#define V_ADD(a, b) _mm_add_epi32(a, b)
+#define V_XOR(a, b) _mm_xor_si128(a, b)
+#define V_XOR3(a, b, c) _mm_xor_si128(_mm_xor_si128(a, b), c)
+#define V_ROL(x, n) _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - (n)))
+#define V_CH(x, y, z) _mm_xor_si128(_mm_and_si128(x, y), _mm_andnot_si128(x, z))
+#define V_MAJ(x, y, z) _mm_or_si128(_mm_and_si128(x, y), _mm_and_si128(z, _mm_or_si128(x, y)))
+#define V_MD5_I(x, y, z) _mm_xor_si128(y, _mm_or_si128(x, _mm_xor_si128(z, _mm_set1_epi32(-1))))
+#define V_SET1(x) _mm_set1_epi32((int) (x))
+#define V_LOAD(p) _mm_load_si128((const __m128i *) (p))
+#define V_STORE(p, x) _mm_store_si128((__m128i *) (p), x)
+#include "md-lanes.inc"
+#undef MD5_FN
+#undef MD4_FN
+#undef SHA_1_FN
+#undef LANES_ATTR
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR
+#undef V_XOR3
+#undef V_ROL
+#undef V_CH
+#undef V_MAJ
+#undef V_MD5_I
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+/*
+ * AVX2, 8 lanes.
+ */
+#define MD5_FN md5_avx2
+#define MD4_FN md4_avx2
+#define SHA_1_FN sha_1_avx2
+#define LANES_ATTR __attribute__((target("avx2")))
+#define LANES 8
+#define VEC __m256i
+#define V_ADD(a, b) _mm256_add_epi32(a, b)
+#define V_XOR(a, b) _mm256_xor_si256(a, b)
+#define V_XOR3(a, b, c) _mm256_xor_si256(_mm256_xor_si256(a, b), c)
+#define V_ROL(x, n) _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+#define V_CH(x, y, z) _mm256_xor_si256(_mm256_and_si256(x, y), _mm256_andnot_si256(x, z))
+#define V_MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#define V_MD5_I(x, y, z) _mm256_xor_si256(y, _mm256_or_si256(x, _mm256_xor_si256(z, _mm256_set1_epi32(-1))))
+#define V_SET1(x) _mm256_set1_epi32((int) (x))
+#define V_LOAD(p) _mm256_load_si256((const __m256i *) (p))
+#define V_STORE(p, x) _mm256_store_si256((__m256i *) (p), x)
+#include "md-lanes.inc"
+#undef MD5_FN
+#undef MD4_FN
+#undef SHA_1_FN
+#undef LANES_ATTR
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR
+#undef V_XOR3
+#undef V_ROL
+#undef V_CH
+#undef V_MAJ
+#undef V_MD5_I
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+/*
+ * AVX-512, 16 lanes. Rotates and every three-input boolean function map to single instructions.
+ */
+#define MD5_FN md5_avx512
+#define MD4_FN md4_avx512
+#define SHA_1_FN sha_1_avx512
+#define LANES_ATTR __attribute__((target("avx512f")))
+#define LANES 16
+#define VEC __m512i
+#define V_ADD(a, b) _mm512_add_epi32(a, b)
+#define V_XOR(a, b) _mm512_xor_si512(a, b)
+#define V_XOR3(a, b, c) _mm512_ternarylogic_epi32(a, b, c, 0x96)
+#define V_ROL(x, n) _mm512_rol_epi32(x, n)
+#define V_CH(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xca)
+#define V_MAJ(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0xe8)
+#define V_MD5_I(x, y, z) _mm512_ternarylogic_epi32(x, y, z, 0x39)
+#define V_SET1(x) _mm512_set1_epi32((int) (x))
+#define V_LOAD(p) _mm512_load_si512((const void *) (p))
+#define V_STORE(p, x) _mm512_store_si512((void *) (p), x)
+#include "md-lanes.inc"
+#undef MD5_FN
+#undef MD4_FN
+#undef SHA_1_FN
+#undef LANES_ATTR
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR
+#undef V_XOR3
+#undef V_ROL
+#undef V_CH
+#undef V_MAJ
+#undef V_MD5_I
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+#endif
+
+/* Candidate kernels, in the order they are measured; one per algorithm of the engine. */
+struct md_engine {
+	const char *name;
+	int lanes;
+	md_fn compress[3];
+};
+
+static struct md_engine selected = { "scalar", 1, { md5_scalar, md4_scalar, sha_1_scalar } };
+
+/* Pad a message of at most MD_MAX_SINGLE_BLOCK bytes into a block of little-endian words. */
+static void md_single_block_le(uint32_t block[16], const char *msg, size_t len)
+{
+	size_t i;
+
+	memset(block, 0, 64);
+	for (i = 0; i < len; i++)
+		block[i >> 2] |= (uint32_t) (uint8_t) msg[i] << (8 * (i & 3));
+	block[len >> 2] |= 0x80u << (8 * (len & 3));
+	block[14] = (uint32_t) (len << 3);
+}
+
+/*
+ * Pad a password of at most NTLM_MAX_SINGLE_BLOCK bytes into a block, widening every byte
+ * to a UTF-16LE character on the way, so each word holds two characters.
+ */
+static void ntlm_single_block(uint32_t block[16], const char *msg, size_t len)
+{
+	size_t i;
+
+	memset(block, 0, 64);
+	for (i = 0; i < len; i++)
+		block[i >> 1] |= (uint32_t) (uint8_t) msg[i] << (16 * (i & 1));
+	block[len >> 1] |= 0x80u << (16 * (len & 1));
+	block[14] = (uint32_t) (len << 4);
+}
+
+/* Read 64 bytes as sixteen words of the given byte order. */
+static void md_load_block(uint32_t block[16], const uint8_t *p, int big_endian)
+{
+	int i;
+
+	for (i = 0; i < 16; i++, p += 4) {
+		if (big_endian)
+			block[i] = (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+		else
+			block[i] = (uint32_t) p[3] << 24 | (uint32_t) p[2] << 16 | (uint32_t) p[1] << 8 | p[0];
+	}
+}
+
+/* Hash a message of any length one block at a time with a scalar kernel. */
+static void md_long(md_fn compress, int big_endian, uint32_t state[5], const uint8_t *msg, size_t len)
+{
+	uint8_t last[128];
+	uint32_t block[16];
+	uint64_t bits = (uint64_t) len * 8;
+	size_t done, rest, size, i;
+
+	for (done = 0; len - done >= 64; done += 64) {
+		md_load_block(block, msg + done, big_endian);
+		compress((uint32_t (*)[5]) state, (const uint32_t (*)[16]) block, 1);
+	}
+
+	/* The padding and the length take one more block, or two if the rest leaves no room. */
+	rest = len - done;
+	size = rest <= MD_MAX_SINGLE_BLOCK ? 64 : 128;
+	memset(last, 0, size);
+	memcpy(last, msg + done, rest);
+	last[rest] = 0x80;
+	for (i = 0; i < 8; i++) {
+		if (big_endian)
+			last[size - 1 - i] = (uint8_t) (bits >> (8 * i));
+		else
+			last[size - 8 + i] = (uint8_t) (bits >> (8 * i));
+	}
+	for (i = 0; i < size; i += 64) {
+		md_load_block(block, last + i, big_endian);
+		compress((uint32_t (*)[5]) state, (const uint32_t (*)[16]) block, 1);
+	}
+}
+
+/* Write a state as digest words, in the byte order of the digest. */
+static void md_digest(int algorithm, const uint32_t state[5], uint32_t *digest)
+{
+	int i;
+
+	if (algorithm == MD_SHA1) {
+		for (i = 0; i < 5; i++)
+			digest[i] = state[i];
+		return;
+	}
+	for (i = 0; i < 4; i++)
+		digest[i] = __builtin_bswap32(state[i]);
+}
+
+/* Hash a message too long for a single block. */
+static void md_hash_long(int algorithm, uint32_t *digest, const char *msg, size_t len)
+{
+	uint32_t state[5];
+
+	memcpy(state, md_h0[algorithm], sizeof state);
+	if (algorithm == MD_MD5) {
+		md_long(md5_scalar, 0, state, (const uint8_t *) msg, len);
+	} else if (algorithm == MD_SHA1) {
+		md_long(sha_1_scalar, 1, state, (const uint8_t *) msg, len);
+	} else {
+		uint8_t *wide = calloc(2 * len, 1);
+		size_t i;
+
+		for (i = 0; i < len; i++)
+			wide[2 * i] = (uint8_t) msg[i];
+		md_long(md4_scalar, 0, state, wide, 2 * len);
+		free(wide);
+	}
+	md_digest(algorithm, state, digest);
+}
+
+/*
+ * Pad every short message into its own block and compress them together, hash long ones
+ * directly. Inlined into each public batch function, so `algorithm` is a constant there.
+ */
+static inline void md_batch(int algorithm, const char *const *msgs, const size_t *lens, int n, uint32_t *digests)
+{
+	uint32_t blocks[MD_MAX_LANES][16];
+	uint32_t states[MD_MAX_LANES][5];
+	int index[MD_MAX_LANES];
+	size_t max = algorithm == MD_NTLM ? NTLM_MAX_SINGLE_BLOCK : MD_MAX_SINGLE_BLOCK;
+	int words = algorithm == MD_SHA1 ? 5 : 4;
+	int count = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (lens[i] > max) {
+			md_hash_long(algorithm, digests + i * words, msgs[i], lens[i]);
+			continue;
+		}
+		if (algorithm == MD_MD5)
+			md_single_block_le(blocks[count], msgs[i], lens[i]);
+		else if (algorithm == MD_NTLM)
+			ntlm_single_block(blocks[count], msgs[i], lens[i]);
+		else
+			sha_256_single_block_words(blocks[count], msgs[i], lens[i]);
+		memcpy(states[count], md_h0[algorithm], sizeof states[count]);
+		index[count++] = i;
+	}
+	if (count == 0)
+		return;
+
+	selected.compress[algorithm](states, (const uint32_t (*)[16]) blocks, count);
+	for (i = 0; i < count; i++)
+		md_digest(algorithm, states[i], digests + index[i] * words);
+}
+
+void md5_batch(const char *const *msgs, const size_t *lens, int n, uint32_t *digests)
+{
+	md_batch(MD_MD5, msgs, lens, n, digests);
+}
+
+void ntlm_batch(const char *const *msgs, const size_t *lens, int n, uint32_t *digests)
+{
+	md_batch(MD_NTLM, msgs, lens, n, digests);
+}
+
+void sha_1_batch(const char *const *msgs, const size_t *lens, int n, uint32_t *digests)
+{
+	md_batch(MD_SHA1, msgs, lens, n, digests);
+}
+
+/* Seconds spent by the kernel of `algorithm` in engine e compressing a fixed synthetic batch. */
+static double measure(const struct md_engine *e, int algorithm)
+{
+	enum { BLOCKS = 2048, ROUNDS = 4 };
+	static uint32_t states[BLOCKS][5];
+	static uint32_t blocks[BLOCKS][16];
+	struct timespec start, end;
+	int i, j;
+
+	for (i = 0; i < BLOCKS; i++) {
+		for (j = 0; j < 16; j++)
+			blocks[i][j] = (uint32_t) (i * 16 + j) * 2654435761u;
+		memcpy(states[i], md_h0[algorithm], sizeof states[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < ROUNDS; i++)
+		e->compress[algorithm](states, (const uint32_t (*)[16]) blocks, BLOCKS);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void md_engine_init(int algorithm)
+{
+	struct md_engine scalar = { "scalar", 1, { md5_scalar, md4_scalar, sha_1_scalar } };
+	struct md_engine candidates[4];
+	int count = 0;
+	double best, t;
+	int i;
+
+	candidates[count++] = scalar;
+
+#ifdef MD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.1")) {
+		struct md_engine sse41 = { "sse4.1", 4, { md5_sse41, md4_sse41, sha_1_sse41 } };
+		candidates[count++] = sse41;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		struct md_engine avx2 = { "avx2", 8, { md5_avx2, md4_avx2, sha_1_avx2 } };
+		candidates[count++] = avx2;
+	}
+	if (__builtin_cpu_supports("avx512f")) {
+		struct md_engine avx512 = { "avx512", 16, { md5_avx512, md4_avx512, sha_1_avx512 } };
+		candidates[count++] = avx512;
+	}
+#endif
+
+	/* Keep the fastest kernel; the first pass of each also warms up its code and data. */
+	selected = candidates[0];
+	best = measure(&candidates[0], algorithm);
+	for (i = 1; i < count; i++) {
+		measure(&candidates[i], algorithm);
+		t = measure(&candidates[i], algorithm);
+		if (t < best) {
+			best = t;
+			selected = candidates[i];
+		}
+	}
+}
+
+const char *md_engine_name()
+{
+	return selected.name;
+}
+
+int md_engine_lanes()
+{
+	return selected.lanes;
+}
@@ -0,0 +1,94 @@
+/** md.h
+ * This file contains the declarations of the MD5, NTLM and SHA-1 kernels selected with
+ * `--hash-type` (see hash.h). The three share the structure of SHA-256: 64-byte blocks,
+ * 32-bit words and a 64-bit message length in the padding, so they share one multi-lane
+ * engine. Like the SHA-256 engine (see sha-256-simd.h), it pads every short candidate
+ * into a single block and compresses a whole batch of them per call with the widest
+ * kernel the CPU supports:
+ * - AVX-512: 16 lanes of 32-bit words per instruction.
+ * - AVX2: 8 lanes.
+ * - SSE4.1: 4 lanes.
+ * - scalar: one message at a time.
+ * NTLM is MD4 of the password in UTF-16LE, which is built directly into the block, so a
+ * candidate of up to NTLM_MAX_SINGLE_BLOCK characters is still a single block.
+ *
+ * Digests are returned as 32-bit words in the byte order of the digest (big-endian), as
+ * for SHA-256, so the target set compares and prints every algorithm the same way; the
+ * little-endian state words of MD5 and MD4 are swapped once per digest.
+ *
+ * The main components of this file include:
+ * - md_engine_init(): Selects the fastest kernel for one of the algorithms.
+ * - md5_batch(), ntlm_batch(), sha_1_batch(): Hash a batch of candidates.
+ */
+
+#ifndef __MD_H
+#define __MD_H
+#include <stdint.h>
+#include <stddef.h>
+
+/* Longest message that still fits a single padded block (64 - 1 - 8 bytes). */
+#define MD_MAX_SINGLE_BLOCK 55
+/* Longest NTLM password whose two-byte characters fit a single block. */
+#define NTLM_MAX_SINGLE_BLOCK 27
+/* Widest batch any kernel processes in a single pass. */
+#define MD_MAX_LANES 16
+
+/* Algorithms of the engine. */
+#define MD_MD5 0
+#define MD_NTLM 1
+#define MD_SHA1 2
+
+/** md_engine_init()
+ * This function detects the instruction sets supported by the CPU, measures the
+ * throughput of the kernel of `algorithm` for every usable one and selects the fastest.
+ * It must be called once by main before any thread is created.
+ *
+ * @param algorithm MD_MD5, MD_NTLM or MD_SHA1.
+ */
+void md_engine_init(int);
+
+/** md_engine_name()
+ * @return const char* Name of the selected kernel (e.g. "avx2").
+ */
+const char* md_engine_name();
+
+/** md_engine_lanes()
+ * @return int Number of candidates the selected kernel hashes per pass.
+ */
+int md_engine_lanes();
+
+/** md5_batch()
+ * This function hashes `n` independent messages with MD5. Messages of at most
+ * MD_MAX_SINGLE_BLOCK bytes are padded into single blocks and compressed together by the
+ * selected kernel; longer ones are hashed one block at a time.
+ *
+ * @param msgs Array of `n` pointers to the messages.
+ * @param lens Array of `n` message lengths in bytes.
+ * @param n Number of messages, at most MD_MAX_LANES.
+ * @param digests Receives `n` digests of four 32-bit words each, one after the other.
+ */
+void md5_batch(const char* const*, const size_t*, int, uint32_t*);
+
+/** ntlm_batch()
+ * This function hashes `n` independent passwords with NTLM, the MD4 of the password
+ * with every byte widened to a UTF-16LE character. Passwords of at most
+ * NTLM_MAX_SINGLE_BLOCK characters are compressed together by the selected kernel.
+ *
+ * @param msgs Array of `n` pointers to the passwords.
+ * @param lens Array of `n` password lengths in bytes.
+ * @param n Number of passwords, at most MD_MAX_LANES.
+ * @param digests Receives `n` digests of four 32-bit words each, one after the other.
+ */
+void ntlm_batch(const char* const*, const size_t*, int, uint32_t*);
+
+/** sha_1_batch()
+ * This function hashes `n` independent messages with SHA-1, as md5_batch does.
+ *
+ * @param msgs Array of `n` pointers to the messages.
+ * @param lens Array of `n` message lengths in bytes.
+ * @param n Number of messages, at most MD_MAX_LANES.
+ * @param digests Receives `n` digests of five 32-bit words each, one after the other.
+ */
+void sha_1_batch(const char* const*, const size_t*, int, uint32_t*);
+
+#endif
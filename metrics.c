@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "metrics.h"
+#include "checkpoint.h"
+#include "steal.h"
+#include "targets.h"
+#include "global.h"
+
+_Thread_local ThreadMetrics* threadMetrics = NULL;
+
+// names of the metrics in the JSON summary
+static const char* METRIC_NAMES[NUM_METRICS] = {
+    "words", "candidates", "hashes", "full_wait_s", "empty_wait_s", "lock_wait_s", "lock_held_s"
+};
+
+uint64_t metrics_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+void metrics_register(int role, int id) {
+    int slot = role == ROLE_PRODUCER ? id : METRICS.numProducers + id;
+    threadMetrics = METRICS.slots != NULL && slot < METRICS.numSlots ? &METRICS.slots[slot] : NULL;
+}
+
+uint64_t metrics_lock(pthread_mutex_t* mutex) {
+    uint64_t start = metrics_now();
+    pthread_mutex_lock(mutex);
+    uint64_t acquired = metrics_now();
+    metrics_add(METRIC_LOCK_WAIT, acquired - start);
+    return acquired;
+}
+
+uint64_t metrics_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, Metric metric) {
+    uint64_t start = metrics_now();
+    pthread_cond_wait(cond, mutex);
+    uint64_t waited = metrics_now() - start;
+    metrics_add(metric, waited);
+    return waited;
+}
+
+void metrics_unlock(pthread_mutex_t* mutex, uint64_t acquired, uint64_t waited) {
+    uint64_t held = metrics_now() - acquired - waited;
+    pthread_mutex_unlock(mutex);
+    metrics_add(METRIC_LOCK_HELD, held);
+}
+
+void metrics_sum(uint64_t totals[2][NUM_METRICS]) {
+    memset(totals, 0, 2 * NUM_METRICS * sizeof(uint64_t));
+    for (int s = 0; s < METRICS.numSlots; s++) {
+        int role = s < METRICS.numProducers ? ROLE_PRODUCER : ROLE_CONSUMER;
+        for (int m = 0; m < NUM_METRICS; m++) {
+            totals[role][m] += atomic_load_explicit(&METRICS.slots[s].values[m], memory_order_relaxed);
+        }
+    }
+}
+
+// positions of every range processed by this run and left to process, from the
+// checkpoint watermarks, and the share of the whole job done, resumed work included
+static double progress(uint64_t* done, uint64_t* left) {
+    uint64_t finished = 0, size = 0;
+    *done = *left = 0;
+    for (int i = 0; i < CHECKPOINT.numRanges; i++) {
+        ProgressRange* range = &CHECKPOINT.ranges[i];
+        uint64_t watermark = atomic_load_explicit(&range->watermark, memory_order_relaxed);
+        *done += watermark - range->resume;
+        *left += range->end - watermark;
+        finished += watermark - range->start;
+        size += range->end - range->start;
+    }
+    return size > 0 ? (double)finished / size : 1.0;
+}
+
+// blocks waiting in the global buffer or the deques
+static int occupancy() {
+    if (OPTIONS.scheduler == SCHED_STEAL) {
+        return atomic_load(&QUEUES.queued);
+    }
+    pthread_mutex_lock(&BUFFER.mutex);
+    int count = BUFFER.count;
+    pthread_mutex_unlock(&BUFFER.mutex);
+    return count;
+}
+
+// print the rates over the last interval, the progress and the health of the pipeline
+static void report(uint64_t now, uint64_t previous, uint64_t last[2][NUM_METRICS]) {
+    uint64_t totals[2][NUM_METRICS], done, left;
+    metrics_sum(totals);
+    double interval = (now - previous) / 1e9;
+    double elapsed = (now - METRICS.startTime) / 1e9;
+    double share = progress(&done, &left);
+    double hashRate = (totals[ROLE_PRODUCER][METRIC_HASHES] + totals[ROLE_CONSUMER][METRIC_HASHES]
+        - last[ROLE_PRODUCER][METRIC_HASHES] - last[ROLE_CONSUMER][METRIC_HASHES]) / interval;
+
+    // the ETA assumes the rest goes as fast as this run did on average
+    char eta[32] = "unknown";
+    if (done > 0) {
+        long seconds = (long)(left * elapsed / done);
+        snprintf(eta, sizeof(eta), "%ld:%02ld:%02ld", seconds / 3600, seconds / 60 % 60, seconds % 60);
+    }
+    // a streamed dictionary has no size, only its rates are known
+    if (OPTIONS.stream) {
+        double wordRate = (totals[ROLE_CONSUMER][METRIC_WORDS] - last[ROLE_CONSUMER][METRIC_WORDS]) / interval;
+        printf("status:      streaming, %.2f MH/s, %.0f words/s\n", hashRate / 1e6, wordRate);
+    }
+    else if (OPTIONS.dictFile != NULL) {
+        double wordRate = (totals[ROLE_CONSUMER][METRIC_WORDS] - last[ROLE_CONSUMER][METRIC_WORDS]) / interval;
+        printf("status:      %.1f%%, %.2f MH/s, %.0f words/s, ETA %s\n", 100 * share, hashRate / 1e6, wordRate, eta);
+    }
+    else {
+        printf("status:      %.1f%%, %.2f MH/s, ETA %s\n", 100 * share, hashRate / 1e6, eta);
+    }
+
+    // share of the thread time of the interval spent blocked on the buffer
+    if (METRICS.numProducers > 0) {
+        double producerTime = interval * 1e9 * METRICS.numProducers;
+        double consumerTime = interval * 1e9 * (METRICS.numSlots - METRICS.numProducers);
+        double threadTime = producerTime + consumerTime;
+        uint64_t lockWait = 0, lockHeld = 0;
+        for (int role = 0; role < 2; role++) {
+            lockWait += totals[role][METRIC_LOCK_WAIT] - last[role][METRIC_LOCK_WAIT];
+            lockHeld += totals[role][METRIC_LOCK_HELD] - last[role][METRIC_LOCK_HELD];
+        }
+        printf("pipeline:    buffer %d/%d blocks, producers %.0f%% waiting for room, consumers %.0f%% "
+            "waiting for blocks, mutex %.1f%% held, %.1f%% contended\n", occupancy(), MAX_GLOBAL_BLOCKS,
+            100 * (totals[ROLE_PRODUCER][METRIC_FULL_WAIT] - last[ROLE_PRODUCER][METRIC_FULL_WAIT]) / producerTime,
+            100 * (totals[ROLE_CONSUMER][METRIC_EMPTY_WAIT] - last[ROLE_CONSUMER][METRIC_EMPTY_WAIT]) / consumerTime,
+            100 * lockHeld / threadTime, 100 * lockWait / threadTime);
+    }
+    memcpy(last, totals, sizeof(totals));
+}
+
+// report every --status-timer seconds until the run is finished
+static void* reporter(void* arg) {
+    uint64_t last[2][NUM_METRICS] = {{0}};
+    uint64_t previous = METRICS.startTime;
+
+    pthread_mutex_lock(&METRICS.mutex);
+    while (!METRICS.stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += OPTIONS.statusTimer;
+        if (pthread_cond_timedwait(&METRICS.stop, &METRICS.mutex, &deadline) == 0 || METRICS.stopping) {
+            continue;
+        }
+        // print without holding the mutex finish_metrics() stops the reporter under
+        pthread_mutex_unlock(&METRICS.mutex);
+        uint64_t now = metrics_now();
+        report(now, previous, last);
+        previous = now;
+        pthread_mutex_lock(&METRICS.mutex);
+    }
+    pthread_mutex_unlock(&METRICS.mutex);
+    return NULL;
+}
+
+void start_metrics(int numProducers, int numConsumers) {
+    METRICS.numProducers = numProducers;
+    METRICS.numSlots = numProducers + numConsumers;
+    METRICS.slots = aligned_alloc(64, METRICS.numSlots * sizeof(ThreadMetrics));
+    for (int s = 0; s < METRICS.numSlots; s++) {
+        for (int m = 0; m < NUM_METRICS; m++) {
+            atomic_init(&METRICS.slots[s].values[m], 0);
+        }
+    }
+    METRICS.startTime = metrics_now();
+    METRICS.stopping = 0;
+    pthread_mutex_init(&METRICS.mutex, NULL);
+    pthread_cond_init(&METRICS.stop, NULL);
+    if (OPTIONS.statusTimer > 0) {
+        pthread_create(&METRICS.thread, NULL, reporter, NULL);
+    }
+}
+
+// write one counter, times in seconds
+static void write_value(FILE* file, int metric, uint64_t value) {
+    if (metric >= METRIC_FULL_WAIT) {
+        fprintf(file, "\"%s\": %.6f", METRIC_NAMES[metric], value / 1e9);
+    }
+    else {
+        fprintf(file, "\"%s\": %llu", METRIC_NAMES[metric], (unsigned long long)value);
+    }
+}
+
+// write the totals of the run and of every slot as JSON
+static void write_summary(FILE* file, double elapsed) {
+    uint64_t totals[2][NUM_METRICS], done, left;
+    const char* roles[2] = {"producers", "consumers"};
+    metrics_sum(totals);
+    double share = progress(&done, &left);
+    uint64_t hashes = totals[ROLE_PRODUCER][METRIC_HASHES] + totals[ROLE_CONSUMER][METRIC_HASHES];
+
+    fprintf(file, "{\n  \"elapsed_s\": %.6f,\n  \"progress\": %.6f,\n", elapsed, share);
+    fprintf(file, "  \"cracked\": %d,\n  \"targets\": %d,\n", TARGETS.numCracked, TARGETS.numTargets);
+    fprintf(file, "  \"words_per_s\": %.0f,\n  \"hashes_per_s\": %.0f,\n",
+        elapsed > 0 ? totals[ROLE_CONSUMER][METRIC_WORDS] / elapsed : 0, elapsed > 0 ? hashes / elapsed : 0);
+    for (int role = 0; role < 2; role++) {
+        int count = role == ROLE_PRODUCER ? METRICS.numProducers : METRICS.numSlots - METRICS.numProducers;
+        fprintf(file, "  \"%s\": {\"threads\": %d", roles[role], count);
+        for (int m = 0; m < NUM_METRICS; m++) {
+            fprintf(file, ", ");
+            write_value(file, m, totals[role][m]);
+        }
+        fprintf(file, "},\n");
+    }
+    fprintf(file, "  \"threads\": [\n");
+    for (int s = 0; s < METRICS.numSlots; s++) {
+        int producer = s < METRICS.numProducers;
+        fprintf(file, "    {\"role\": \"%s\", \"id\": %d", producer ? "producer" : "consumer",
+            producer ? s : s - METRICS.numProducers);
+        for (int m = 0; m < NUM_METRICS; m++) {
+            fprintf(file, ", ");
+            write_value(file, m, atomic_load(&METRICS.slots[s].values[m]));
+        }
+        fprintf(file, "}%s\n", s + 1 < METRICS.numSlots ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+void finish_metrics() {
+    double elapsed = (metrics_now() - METRICS.startTime) / 1e9;
+    if (OPTIONS.statusTimer > 0) {
+        pthread_mutex_lock(&METRICS.mutex);
+        METRICS.stopping = 1;
+        pthread_cond_signal(&METRICS.stop);
+        pthread_mutex_unlock(&METRICS.mutex);
+        pthread_join(METRICS.thread, NULL);
+    }
+    if (OPTIONS.metricsFile != NULL) {
+        FILE* file = fopen(OPTIONS.metricsFile, "w");
+        if (file == NULL) {
+            printf("warning: failed to write metrics to '%s'\n", OPTIONS.metricsFile);
+        }
+        else {
+            write_summary(file, elapsed);
+            fclose(file);
+        }
+    }
+    pthread_mutex_destroy(&METRICS.mutex);
+    pthread_cond_destroy(&METRICS.stop);
+    free(METRICS.slots);
+    METRICS.slots = NULL;
+    threadMetrics = NULL;
+}
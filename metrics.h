@@ -0,0 +1,161 @@
+/** metrics.h
+ * This file contains the declarations of the live metrics of a run, which tell whether it
+ * is bound by the producers, the global buffer or the hashing. Every thread counts its
+ * own work (words, candidates, hashes) and the time it spends blocked on the buffer's
+ * condition variables or acquiring and holding its mutex, in a slot of its own. A slot
+ * fills a whole cache line and is only written by its thread, with relaxed stores, so
+ * counting costs a few instructions and never moves a cache line between cores; the
+ * clock is only read around the buffer mutex, once per block of words.
+ *
+ * A reporter thread adds up the slots every `--status-timer` seconds and prints the hash
+ * rate, the occupancy of the buffer, the share of time the producers and consumers spent
+ * blocked, and the progress and ETA taken from the checkpoint watermarks (see
+ * checkpoint.h). At the end of the run, `--metrics FILE` writes every total and every
+ * slot as JSON.
+ *
+ * The main components of this file include:
+ * - The `Metric` enumeration, the quantities every thread counts.
+ * - The `ThreadMetrics` structure, the slot of one thread.
+ * - The `Metrics` structure, every slot and the state of the reporter thread.
+ * - metrics_register(): Binds the calling thread to its slot.
+ * - metrics_add(): Adds to a counter of the calling thread.
+ * - metrics_lock()/metrics_wait()/metrics_unlock(): Time the buffer mutex.
+ * - metrics_sum(): Adds up the slots, for the reports and the controller (see balance.h).
+ * - start_metrics()/finish_metrics(): Run and stop the reporter thread.
+ */
+
+#ifndef __METRICS__
+#define __METRICS__
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// roles of the threads, which decide how their time is reported
+#define ROLE_PRODUCER 0             // producer threads
+#define ROLE_CONSUMER 1             // consumers, fused workers and mask workers
+
+/** Metric
+ * The quantities counted by every thread; times are in nanoseconds.
+ */
+typedef enum {
+    METRIC_WORDS,                // Words read by a producer, or processed by a consumer
+    METRIC_CANDIDATES,           // Candidates generated by the rules, repeats included
+    METRIC_HASHES,               // Candidates hashed
+    METRIC_FULL_WAIT,            // Time blocked on `notFull`, waiting for room in the buffer
+    METRIC_EMPTY_WAIT,           // Time blocked on `notEmpty`, waiting for a block
+    METRIC_LOCK_WAIT,            // Time spent acquiring the buffer mutex
+    METRIC_LOCK_HELD,            // Time the buffer mutex was held, waits excluded
+    NUM_METRICS
+} Metric;
+
+/** ThreadMetrics
+ * The counters of one thread, alone on their cache line.
+ */
+typedef struct {
+    atomic_ullong values[NUM_METRICS];   // One counter per metric
+} __attribute__((aligned(64))) ThreadMetrics;
+
+/** Metrics
+ * Every slot of the run and the state of the reporter thread.
+ */
+typedef struct {
+    ThreadMetrics* slots;        // One slot per thread, the producers first
+    int numProducers;            // Number of producer slots
+    int numSlots;                // Number of slots
+    uint64_t startTime;          // Time the run started, in nanoseconds
+    int stopping;                // Flag to stop the reporter thread
+    pthread_mutex_t mutex;       // Mutex protecting `stopping`
+    pthread_cond_t stop;         // Condition variable signaled to stop the reporter thread
+    pthread_t thread;            // Thread printing the reports
+} Metrics;
+
+// per-thread counters of the run and the reporter thread
+extern Metrics METRICS;
+
+// slot of the calling thread, NULL until it registers
+extern _Thread_local ThreadMetrics* threadMetrics;
+
+/** metrics_now()
+ * This function reads the monotonic clock.
+ *
+ * @return uint64_t The time in nanoseconds.
+ */
+uint64_t metrics_now();
+
+/** metrics_register()
+ * This function binds the calling thread to its slot; counts of a thread that never
+ * registers are dropped.
+ *
+ * @param role ROLE_PRODUCER or ROLE_CONSUMER.
+ * @param id Index of the thread among the threads of its role.
+ */
+void metrics_register(int, int);
+
+/** metrics_add()
+ * This function adds to a counter of the calling thread. Only the thread writes its
+ * slot, so a relaxed load and store replace an atomic read-modify-write.
+ *
+ * @param metric The counter.
+ * @param amount The amount to add.
+ */
+static inline void metrics_add(Metric metric, uint64_t amount) {
+    ThreadMetrics* slot = threadMetrics;
+    if (slot != NULL) {
+        atomic_ullong* value = &slot->values[metric];
+        atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + amount,
+            memory_order_relaxed);
+    }
+}
+
+/** metrics_lock()
+ * This function locks a mutex and counts the time spent acquiring it.
+ *
+ * @param mutex The mutex.
+ * @return uint64_t The time it was acquired, for metrics_unlock().
+ */
+uint64_t metrics_lock(pthread_mutex_t*);
+
+/** metrics_wait()
+ * This function waits on a condition variable and counts the time blocked.
+ *
+ * @param cond The condition variable.
+ * @param mutex The mutex, held by the caller.
+ * @param metric METRIC_FULL_WAIT or METRIC_EMPTY_WAIT.
+ * @return uint64_t The time blocked, which the mutex was not held for.
+ */
+uint64_t metrics_wait(pthread_cond_t*, pthread_mutex_t*, Metric);
+
+/** metrics_unlock()
+ * This function unlocks a mutex and counts the time it was held.
+ *
+ * @param mutex The mutex.
+ * @param acquired The time it was acquired, from metrics_lock().
+ * @param waited The time spent in metrics_wait() meanwhile.
+ */
+void metrics_unlock(pthread_mutex_t*, uint64_t, uint64_t);
+
+/** metrics_sum()
+ * This function adds up the slots of the producers and of the other threads.
+ *
+ * @param totals Receives the totals of the producers in totals[ROLE_PRODUCER] and of the
+ *               other threads in totals[ROLE_CONSUMER].
+ */
+void metrics_sum(uint64_t[2][NUM_METRICS]);
+
+/** start_metrics()
+ * This function allocates the slots of the run and starts the reporter thread, unless
+ * `--status-timer` is 0. It must be called after init_checkpoint(), whose ranges give
+ * the progress.
+ *
+ * @param numProducers Number of producer threads, 0 without the pipeline.
+ * @param numConsumers Number of consumer, fused or mask worker threads.
+ */
+void start_metrics(int, int);
+
+/** finish_metrics()
+ * This function stops the reporter thread once every worker has been joined, writes the
+ * JSON summary to the `--metrics` file if one was given, and frees the slots.
+ */
+void finish_metrics();
+
+#endif
@@ -0,0 +1,113 @@
+#include <string.h>
+#include <stdint.h>
+#include "sha-256.h"
+#include "sha-256-simd.h"
+#include "pbkdf2.h"
+
+/* HMAC key block size of SHA-256. */
+#define HMAC_BLOCK 64
+
+/* Write `len` bytes into a zeroed block of big-endian words, starting at byte `at`. */
+static void put_bytes(uint32_t *block, size_t at, const void *input, size_t len)
+{
+	const uint8_t *p = input;
+	size_t i;
+
+	for (i = 0; i < len; i++, at++)
+		block[at >> 2] |= (uint32_t) p[i] << (24 - 8 * (at & 3));
+}
+
+/* Pad a 32-byte HMAC half that follows a pad block: 64 + 32 bytes in total. */
+static void pad_half(uint32_t block[16])
+{
+	block[8] = 0x80000000;
+	memset(block + 9, 0x00, 6 * sizeof(uint32_t));
+	block[15] = (HMAC_BLOCK + 32) * 8;
+}
+
+/*
+ * Compute the states after the inner and outer pads of the password, then
+ * U1 = HMAC(P, salt || INT(1)), whose inner message may take two blocks.
+ */
+static void hmac_first(const char *password, size_t len, const char *salt, size_t salt_len, uint32_t ipad[8],
+	uint32_t opad[8], uint32_t u[8])
+{
+	uint32_t key[16], block[32];
+	uint64_t bits;
+	size_t total;
+	int i, blocks;
+
+	/* A key longer than a block is replaced by its hash. */
+	memset(key, 0x00, sizeof key);
+	if (len > HMAC_BLOCK)
+		sha_256_words(key, password, len);
+	else
+		put_bytes(key, 0, password, len);
+
+	memcpy(ipad, sha_256_h0, 8 * sizeof(uint32_t));
+	memcpy(opad, sha_256_h0, 8 * sizeof(uint32_t));
+	for (i = 0; i < 16; i++)
+		block[i] = key[i] ^ 0x36363636;
+	sha_256_compress(ipad, block);
+	for (i = 0; i < 16; i++)
+		block[i] = key[i] ^ 0x5c5c5c5c;
+	sha_256_compress(opad, block);
+
+	/* Inner hash of salt || INT(1) after the inner pad block. */
+	total = salt_len + 4;
+	blocks = total + 9 <= HMAC_BLOCK ? 1 : 2;
+	memset(block, 0x00, sizeof block);
+	put_bytes(block, 0, salt, salt_len);
+	put_bytes(block, salt_len, "\x00\x00\x00\x01", 4);
+	put_bytes(block, total, "\x80", 1);
+	bits = (uint64_t) (HMAC_BLOCK + total) * 8;
+	block[blocks * 16 - 2] = (uint32_t) (bits >> 32);
+	block[blocks * 16 - 1] = (uint32_t) bits;
+	memcpy(u, ipad, 8 * sizeof(uint32_t));
+	for (i = 0; i < blocks; i++)
+		sha_256_compress(u, block + i * 16);
+
+	/* Outer hash of the inner digest after the outer pad block. */
+	memcpy(block, u, 8 * sizeof(uint32_t));
+	pad_half(block);
+	memcpy(u, opad, 8 * sizeof(uint32_t));
+	sha_256_compress(u, block);
+}
+
+void pbkdf2_sha_256_batch(const char *const *passwords, const size_t *lens, const char *const *salts,
+	const size_t *salt_lens, int n, uint32_t iterations, uint32_t (*digests)[8])
+{
+	uint32_t ipad[PBKDF2_MAX_BATCH][8], opad[PBKDF2_MAX_BATCH][8];
+	uint32_t inner[PBKDF2_MAX_BATCH][8], u[PBKDF2_MAX_BATCH][8];
+	uint32_t block[PBKDF2_MAX_BATCH][16];
+	uint32_t k;
+	int i, j;
+
+	/* The pads and U1 are computed once per candidate. */
+	for (i = 0; i < n; i++) {
+		hmac_first(passwords[i], lens[i], salts[i], salt_lens[i], ipad[i], opad[i], u[i]);
+		memcpy(digests[i], u[i], sizeof u[i]);
+		pad_half(block[i]);
+	}
+
+	/*
+	 * Every further Ui = HMAC(P, Ui-1) resumes from the pads: one compression of the
+	 * padded Ui-1 from the inner pad, one of the inner digest from the outer pad, each
+	 * for the whole batch at once. Only the first eight words of the blocks change.
+	 */
+	for (k = 1; k < iterations; k++) {
+		for (i = 0; i < n; i++) {
+			memcpy(block[i], u[i], sizeof u[i]);
+			memcpy(inner[i], ipad[i], sizeof ipad[i]);
+		}
+		sha_256_compress_batch(inner, (const uint32_t (*)[16])block, n);
+		for (i = 0; i < n; i++) {
+			memcpy(block[i], inner[i], sizeof inner[i]);
+			memcpy(u[i], opad[i], sizeof opad[i]);
+		}
+		sha_256_compress_batch(u, (const uint32_t (*)[16])block, n);
+		for (i = 0; i < n; i++)
+			for (j = 0; j < 8; j++)
+				digests[i][j] ^= u[i][j];
+	}
+}
@@ -0,0 +1,42 @@
+/** pbkdf2.h
+ * This file contains the declaration of the PBKDF2-HMAC-SHA256 kernel selected with
+ * `--hash-type pbkdf2-sha256` (see hash.h). PBKDF2 derives a key from a password and a
+ * salt by chaining thousands of HMAC-SHA256 computations, U1 = HMAC(P, S || 1),
+ * Ui = HMAC(P, Ui-1), and XORing them together, so almost all of its cost lies in the
+ * iterations, which is where this kernel saves work:
+ * - The key of every HMAC is the password, so the states after its inner and outer pads
+ *   are computed once per candidate, and each HMAC resumes from them.
+ * - Each Ui is 32 bytes, so both halves of an HMAC fit a single padded block: an
+ *   iteration costs exactly two compressions.
+ * - The candidates of a batch iterate in lockstep, and each of the two compressions of
+ *   an iteration runs for the whole batch with the multi-lane SHA-256 engine
+ *   (see sha-256-simd.h).
+ *
+ * Only the first 32 bytes of the derived key (its first block) are computed, which is the
+ * length of a PBKDF2-HMAC-SHA256 hash; they are returned as eight big-endian words.
+ */
+
+#ifndef __PBKDF2_H
+#define __PBKDF2_H
+#include <stdint.h>
+#include <stddef.h>
+
+/* Widest batch of candidates derived together, the widest SHA-256 kernel. */
+#define PBKDF2_MAX_BATCH 16
+
+/** pbkdf2_sha_256_batch()
+ * This function derives the first 32 bytes of the PBKDF2-HMAC-SHA256 key of `n`
+ * passwords, each with its own salt, iterating them together.
+ *
+ * @param passwords Array of `n` pointers to the passwords.
+ * @param lens Array of `n` password lengths in bytes.
+ * @param salts Array of `n` pointers to the salts.
+ * @param saltLens Array of `n` salt lengths in bytes, at most 64.
+ * @param n Number of passwords, at most PBKDF2_MAX_BATCH.
+ * @param iterations Number of iterations, at least 1.
+ * @param digests Receives `n` derived keys as eight big-endian 32-bit words each.
+ */
+void pbkdf2_sha_256_batch(const char* const*, const size_t*, const char* const*, const size_t*, int, uint32_t,
+	uint32_t (*)[8]);
+
+#endif
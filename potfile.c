@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "potfile.h"
+#include "checkpoint.h"
+#include "hash.h"
+#include "targets.h"
+#include "global.h"
+
+// descriptor the hits are appended to, -1 without a potfile
+static int potfile = -1;
+
+// look one potfile line up in the target set and mark its target cracked,
+// returns 1 if the line cracked a target that was not cracked yet
+static int load_line(const char* start, size_t len, FILE* outfile) {
+    char line[MAX_TARGET_TEXT + MAX_WORD_LENGTH + 2];
+    // strip a Windows line ending, and skip lines no hit of this run could have written
+    if (len > 0 && start[len - 1] == '\r') {
+        len--;
+    }
+    if (len >= sizeof(line) || len <= (size_t)HASH.hexLength || start[HASH.hexLength] != ':') {
+        return 0;
+    }
+    memcpy(line, start, len);
+    line[len] = '\0';
+
+    // the password follows the hash, and the salt of a salted target
+    const char* rest;
+    int index = find_target_text(line, &rest);
+    if (index < 0 || *rest != ':') {
+        return 0;
+    }
+    const char* password = rest + 1;
+    if (!mark_cracked(index)) {
+        return 0;
+    }
+    // the output file and the checkpoint list every target of the run that is cracked
+    char target[MAX_TARGET_TEXT + 1];
+    target_to_text(index, target);
+    fprintf(outfile, "%s:%s\n", target, password);
+    checkpoint_cracked(target, password);
+    return 1;
+}
+
+int load_potfile(const char* path, FILE* outfile) {
+    potfile = open(path, O_RDWR | O_APPEND | O_CREAT, 0644);
+    struct stat info;
+    if (potfile < 0 || fstat(potfile, &info) != 0) {
+        printf("error: '%s' is an invalid potfile\n", path);
+        exit(1);
+    }
+
+    // an empty potfile cannot be mapped, it simply has no hits
+    int loaded = 0;
+    size_t size = (size_t)info.st_size;
+    if (size == 0) {
+        return 0;
+    }
+    char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, potfile, 0);
+    if (data == MAP_FAILED) {
+        printf("error: failed to map potfile '%s' into memory\n", path);
+        exit(1);
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    const char* cursor = data;
+    const char* end = data + size;
+    // a last line without its newline is still being written by another run
+    const char* newline;
+    while (cursor < end && (newline = memchr(cursor, '\n', end - cursor)) != NULL) {
+        loaded += load_line(cursor, newline - cursor, outfile);
+        cursor = newline + 1;
+    }
+    munmap(data, size);
+    fflush(outfile);
+    return loaded;
+}
+
+void potfile_add(const char* target, const char* word) {
+    if (potfile < 0) {
+        return;
+    }
+    // one write per line, appended atomically whatever other threads and runs write
+    char line[MAX_TARGET_TEXT + MAX_WORD_LENGTH + 2];
+    int len = snprintf(line, sizeof(line), "%s:%s\n", target, word);
+    if (write(potfile, line, len) != len) {
+        printf("warning: failed to write to the potfile\n");
+    }
+}
+
+void close_potfile() {
+    if (potfile >= 0) {
+        close(potfile);
+        potfile = -1;
+    }
+}
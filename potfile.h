@@ -0,0 +1,50 @@
+/** potfile.h
+ * This file contains the declarations of the potfile, an append-only file of every hash
+ * ever cracked, kept across runs with `--potfile FILE`. Each line is a hit as written to
+ * the output file: `hash:password`, or `hash:salt:password` for a target with a salt.
+ *
+ * At startup the potfile is mapped and every line is looked up in the target set (see
+ * targets.h), so the cost of loading is one hashed lookup per line however many entries
+ * accumulate, and the targets it already holds are marked cracked before any hashing
+ * starts. Every new hit is then appended to it. Each line is written with a single
+ * `write` on a descriptor opened with `O_APPEND`, so hits of the consumers of this run,
+ * and of other runs sharing the potfile, never interleave within a line. A line that a
+ * concurrent run has not finished writing (no newline yet) is ignored when loading.
+ *
+ * The main components of this file include:
+ * - load_potfile(): Opens the potfile and marks the targets it holds cracked.
+ * - potfile_add(): Appends a hit.
+ * - close_potfile(): Closes the potfile.
+ */
+
+#ifndef __POTFILE__
+#define __POTFILE__
+#include <stdio.h>
+
+/** load_potfile()
+ * This function opens the potfile at `path` for appending, creating it if needed, and
+ * marks every target of the global `TARGETS` set found in it as cracked. Each target newly
+ * marked is written to the output file and recorded for the checkpoint, as a hit of the
+ * run would be, but not printed. Exits if the potfile cannot be opened.
+ *
+ * @param path Path of the potfile.
+ * @param outfile The output file of the run.
+ * @return int Number of targets marked cracked from the potfile.
+ */
+int load_potfile(const char*, FILE*);
+
+/** potfile_add()
+ * This function appends a hit to the potfile, if one is open. It may be called by any
+ * thread.
+ *
+ * @param target The cracked target, formatted by `target_to_text`.
+ * @param word The password.
+ */
+void potfile_add(const char*, const char*);
+
+/** close_potfile()
+ * This function closes the potfile, if one is open.
+ */
+void close_potfile();
+
+#endif
@@ -1,90 +1,135 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <pthread.h>
-#include "producer.h"
-#include "global.h"
-
-void writeToBuffer(char** words, int offset) {
-    // lock global buffer mutex
-    pthread_mutex_lock(&BUFFER.mutex);
-
-    // while there is not room in the global buffer to add data items
-    while(BUFFER.count + offset > MAX_GLOBAL_BUFFER_SIZE && !isFound) {
-        pthread_cond_wait(&BUFFER.notFull, &BUFFER.mutex);
-    }
-
-    // after conditions are good, did a consumer find the password
-    if (isFound) {
-        pthread_mutex_unlock(&BUFFER.mutex);
-        pthread_exit(NULL);
-    }
-    // else, write to buffer as normal
-    else{
-        // once space frees, add data values
-        for(int i = 0; i < offset; i++) {
-            // put the ith word into the buffer and account for circular buffer
-            strcpy(BUFFER.buffer[BUFFER.end], words[i]);
-            // update BUFFER counters accordingly
-            BUFFER.end = (BUFFER.end + 1) % MAX_GLOBAL_BUFFER_SIZE;
-            BUFFER.count++;
-        }
-    }
-    // check if number of words < number of consumers
-
-    // broadcast all consumers to wake up and start processing
-    pthread_cond_broadcast(&BUFFER.notEmpty);
-
-    // unlock global buffer mutex
-    pthread_mutex_unlock(&BUFFER.mutex);
-}
-
-void* producer(void* arg) {
-    struct producerData* prod_arg = (struct producerData*)arg;
-
-    // declare variables
-    FILE* dict = prod_arg->dictPointer;
-    int nProds = prod_arg->numProducers;
-
-    // define local buffer for producer thread
-    char** localBuffer = malloc(MAX_LOCAL_BUFFER_SIZE * sizeof(char*));
-    for(int i = 0; i < MAX_LOCAL_BUFFER_SIZE; i++) {
-        localBuffer[i] = malloc(MAX_WORD_LENGTH * sizeof(char));
-    }
-
-    // read data from the input dictionary
-    int index = 0;
-    while (fscanf(dict, "%99s", localBuffer[index]) != EOF && !isDone) {
-        index++;
-        if (index == MAX_LOCAL_BUFFER_SIZE) {
-            writeToBuffer(localBuffer, index);
-            index = 0;
-        }
-    }
-
-    // if the local buffer is not full but also not empty
-    if (index > 0) {
-        writeToBuffer(localBuffer, index);
-    }
-
-    // free local, dynamic array
-    for(int i = 0; i < MAX_LOCAL_BUFFER_SIZE; i++) {
-        free(localBuffer[i]);
-    }
-    free(localBuffer);
-
-    // increment number of terminated producers
-    pthread_mutex_lock(&BUFFER.mutex);
-    numProdsDone = numProdsDone + 1;
-    // if all the producers are done, signal and change flag
-    if (numProdsDone == nProds) {
-        isDone = 1;
-        // broadcast all consumers
-        pthread_cond_broadcast(&BUFFER.notEmpty);
-    }
-    pthread_mutex_unlock(&BUFFER.mutex);
-
-    pthread_exit(NULL);
-
-    return NULL;
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "producer.h"
+#include "stream.h"
+#include "topology.h"
+#include "balance.h"
+#include "block.h"
+#include "checkpoint.h"
+#include "dictionary.h"
+#include "metrics.h"
+#include "steal.h"
+#include "global.h"
+
+void writeToBuffer(WordBlock* block) {
+    // lock global buffer mutex, timing the wait and hold for the metrics
+    uint64_t acquired = metrics_lock(&BUFFER.mutex);
+    uint64_t waited = 0;
+
+    // while there is not room in the global buffer to add a block
+    while(BUFFER.count == MAX_GLOBAL_BLOCKS && !isFound) {
+        waited += metrics_wait(&BUFFER.notFull, &BUFFER.mutex, METRIC_FULL_WAIT);
+    }
+
+    // after conditions are good, have consumers cracked every target
+    if (isFound) {
+        metrics_unlock(&BUFFER.mutex, acquired, waited);
+        release_block(block);
+        pthread_exit(NULL);
+    }
+    // else, enqueue the block and account for circular buffer
+    BUFFER.buffer[BUFFER.end] = block;
+    BUFFER.end = (BUFFER.end + 1) % MAX_GLOBAL_BLOCKS;
+    BUFFER.count++;
+
+    // a block feeds exactly one consumer, so wake only one
+    pthread_cond_signal(&BUFFER.notEmpty);
+
+    // unlock global buffer mutex
+    metrics_unlock(&BUFFER.mutex, acquired, waited);
+}
+
+// hand a full block to the consumers with the selected scheduler
+static void hand_off(WordBlock* block, int* nextQueue) {
+    metrics_add(METRIC_WORDS, block->count);
+    if (OPTIONS.scheduler == SCHED_STEAL) {
+        // deal blocks round-robin over the consumers' deques
+        int queue = *nextQueue;
+        *nextQueue = (queue + 1) % QUEUES.numQueues;
+        if (!push_block(block, queue)) {
+            pthread_exit(NULL);
+        }
+    }
+    else {
+        writeToBuffer(block);
+    }
+}
+
+// pack the words of a range into blocks, handing off every full one and starting the next
+static void pack_range(DictRange range, WordBlock** block, int id, int* nextQueue) {
+    WordView word;
+    while (!isDone && next_word(&range, &word)) {
+        // once the block is full, hand it off and start a new one
+        if (!add_word(*block, word.ptr, word.len)) {
+            // the block ends where the word that did not fit starts, a streamed
+            // dictionary has no offsets to resume from
+            checkpoint_block_start(*block, id, OPTIONS.stream ? 0 : word.ptr - CHECKPOINT.base);
+            hand_off(*block, nextQueue);
+            // with --adaptive this producer may be parked between two blocks
+            balance_park(ROLE_PRODUCER);
+            *block = acquire_block();
+            add_word(*block, word.ptr, word.len);
+        }
+    }
+}
+
+void* producer(void* arg) {
+    struct producerData* prod_arg = (struct producerData*)arg;
+
+    // declare variables
+    DictRange range = prod_arg->range;
+    int nProds = prod_arg->numProducers;
+    // producers start dealing at different consumers so they do not move in lockstep
+    int nextQueue = prod_arg->id % OPTIONS.numConsumers;
+
+    // pin first, so the blocks this producer allocates are local to it
+    pin_thread(ROLE_PRODUCER, prod_arg->id);
+    metrics_register(ROLE_PRODUCER, prod_arg->id);
+    // block being filled by this producer thread
+    WordBlock* block = acquire_block();
+
+    // scan words from every chunk of a streamed dictionary this producer takes, scanned
+    // in place like a range, or from this producer's range of the mapped dictionary
+    if (OPTIONS.stream) {
+        StreamChunk* chunk;
+        while (!isDone && (chunk = take_chunk()) != NULL) {
+            DictRange lines = { chunk->data, chunk->data + chunk->size };
+            pack_range(lines, &block, prod_arg->id, &nextQueue);
+            release_chunk(chunk);
+        }
+    }
+    else {
+        pack_range(range, &block, prod_arg->id, &nextQueue);
+    }
+
+    // the last block ends with the range, so the watermark reaches its end even
+    // when the block is empty
+    checkpoint_block_start(block, prod_arg->id, OPTIONS.stream ? 0 : range.end - CHECKPOINT.base);
+    // if the block is not full but also not empty
+    if (block->count > 0) {
+        hand_off(block, &nextQueue);
+    }
+    else {
+        checkpoint_block_done(block);
+        release_block(block);
+    }
+
+    // increment number of terminated producers
+    pthread_mutex_lock(&BUFFER.mutex);
+    numProdsDone = numProdsDone + 1;
+    // if all the producers are done, signal and change flag
+    if (numProdsDone == nProds) {
+        isDone = 1;
+        // broadcast all consumers
+        pthread_cond_broadcast(&BUFFER.notEmpty);
+    }
+    pthread_mutex_unlock(&BUFFER.mutex);
+    // a parked producer may continue in its place, and parked consumers drain the buffer
+    balance_exit(ROLE_PRODUCER);
+
+    pthread_exit(NULL);
+
+    return NULL;
 }
\ No newline at end of file
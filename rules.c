@@ -0,0 +1,697 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "rules.h"
+#include "global.h"
+
+// longest rule line read from a rule file
+#define MAX_RULE_LENGTH 512
+// most functions a single rule may use
+#define MAX_RULE_FUNCTIONS 128
+// longest word fed to the probes used to compare stems, the longest dictionary word, since
+// two stems may only differ on words past a position the rules name (e.g. 'Z and d 'Z)
+#define MAX_PROBE_LENGTH (MAX_WORD_LENGTH - 2)
+
+// bytecode operations, each followed by two argument bytes
+enum {
+    OP_END, OP_LOWER, OP_UPPER, OP_CAPITALIZE, OP_INVERT_CAPITALIZE, OP_TOGGLE_ALL,
+    OP_TOGGLE_AT, OP_REVERSE, OP_DUPLICATE, OP_DUPLICATE_N, OP_REFLECT, OP_DUPLICATE_CHARS,
+    OP_ROTATE_LEFT, OP_ROTATE_RIGHT, OP_APPEND, OP_PREPEND, OP_DELETE_FIRST, OP_DELETE_LAST,
+    OP_DELETE_AT, OP_TRUNCATE, OP_INSERT, OP_OVERWRITE, OP_REPLACE, OP_PURGE
+};
+
+// substitutions of the classic variants, combined with every trailing digit by the built-in rules
+static const char* CLASSIC_SUBSTITUTIONS[8] = {
+    ":", "si!", "sl1", "si! sl1", "so0", "si! so0", "sl1 so0", "si! sl1 so0"
+};
+
+// a rule after parsing, before stems are grouped
+typedef struct {
+    unsigned char* code;         // Bytecode of the stem, terminated by OP_END
+    char suffix[MAX_WORD_LENGTH];// Characters of the trailing appends
+    int suffixLen;               // Number of trailing appends
+    int stem;                    // Index of the stem the rule was grouped into
+} ParsedRule;
+
+// probe words every stem is run on to detect stems with identical output
+static char probes[2 * MAX_PROBE_LENGTH][MAX_PROBE_LENGTH];
+static int probeLens[2 * MAX_PROBE_LENGTH];
+static int numProbes;
+
+static uint64_t fnv_update(uint64_t hash, const char* data, int len) {
+    for (int i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// decode a position argument, 0-9 then A-Z for 10-35, returns -1 if invalid
+static int position_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    return -1;
+}
+
+// compile one rule into bytecode, returns the number of functions or -1 if it is invalid
+static int parse_rule(const char* text, unsigned char* code) {
+    int count = 0;
+    const char* p = text;
+
+    while (*p != '\0') {
+        char c = *p++;
+        // spaces separate functions and the no-op function compiles to nothing
+        if (c == ' ' || c == '\t' || c == ':') {
+            continue;
+        }
+        if (count == MAX_RULE_FUNCTIONS) {
+            return -1;
+        }
+        unsigned char op;
+        int numArgs = 0;     // character arguments
+        int numPositions = 0;// position arguments, which come first
+        switch (c) {
+            case 'l': op = OP_LOWER; break;
+            case 'u': op = OP_UPPER; break;
+            case 'c': op = OP_CAPITALIZE; break;
+            case 'C': op = OP_INVERT_CAPITALIZE; break;
+            case 't': op = OP_TOGGLE_ALL; break;
+            case 'T': op = OP_TOGGLE_AT; numPositions = 1; break;
+            case 'r': op = OP_REVERSE; break;
+            case 'd': op = OP_DUPLICATE; break;
+            case 'p': op = OP_DUPLICATE_N; numPositions = 1; break;
+            case 'f': op = OP_REFLECT; break;
+            case 'q': op = OP_DUPLICATE_CHARS; break;
+            case '{': op = OP_ROTATE_LEFT; break;
+            case '}': op = OP_ROTATE_RIGHT; break;
+            case '$': op = OP_APPEND; numArgs = 1; break;
+            case '^': op = OP_PREPEND; numArgs = 1; break;
+            case '[': op = OP_DELETE_FIRST; break;
+            case ']': op = OP_DELETE_LAST; break;
+            case 'D': op = OP_DELETE_AT; numPositions = 1; break;
+            case '\'': op = OP_TRUNCATE; numPositions = 1; break;
+            case 'i': op = OP_INSERT; numPositions = 1; numArgs = 1; break;
+            case 'o': op = OP_OVERWRITE; numPositions = 1; numArgs = 1; break;
+            case 's': op = OP_REPLACE; numArgs = 2; break;
+            case '@': op = OP_PURGE; numArgs = 1; break;
+            default: return -1;
+        }
+
+        unsigned char args[2] = {0, 0};
+        for (int i = 0; i < numPositions + numArgs; i++) {
+            if (*p == '\0') {
+                return -1;
+            }
+            if (i < numPositions) {
+                int pos = position_value(*p);
+                if (pos < 0) {
+                    return -1;
+                }
+                args[i] = (unsigned char)pos;
+            }
+            else {
+                args[i] = (unsigned char)*p;
+            }
+            p++;
+        }
+        code[count * 3] = op;
+        code[count * 3 + 1] = args[0];
+        code[count * 3 + 2] = args[1];
+        count++;
+    }
+    code[count * 3] = OP_END;
+    return count;
+}
+
+static char toggle_case(char c) {
+    if (c >= 'a' && c <= 'z') return c - 'a' + 'A';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+    return c;
+}
+
+// run bytecode on a word, returns the output length or -1 if the word is rejected
+static int run_code(const unsigned char* code, const char* word, int len, char* out) {
+    const int limit = MAX_WORD_LENGTH - 1;
+    char* w = out;
+    int n = len;
+    memcpy(w, word, len);
+
+    for (; code[0] != OP_END; code += 3) {
+        int a = code[1];
+        char x = (char)code[1];
+        char y = (char)code[2];
+        switch (code[0]) {
+            case OP_LOWER:
+                for (int i = 0; i < n; i++) {
+                    if (w[i] >= 'A' && w[i] <= 'Z') w[i] += 'a' - 'A';
+                }
+                break;
+            case OP_UPPER:
+                for (int i = 0; i < n; i++) {
+                    if (w[i] >= 'a' && w[i] <= 'z') w[i] -= 'a' - 'A';
+                }
+                break;
+            case OP_CAPITALIZE:
+            case OP_INVERT_CAPITALIZE:
+                for (int i = 0; i < n; i++) {
+                    // capitalize: first upper, rest lower; invert: the opposite
+                    int upper = (i == 0) == (code[0] == OP_CAPITALIZE);
+                    if (upper && w[i] >= 'a' && w[i] <= 'z') w[i] -= 'a' - 'A';
+                    if (!upper && w[i] >= 'A' && w[i] <= 'Z') w[i] += 'a' - 'A';
+                }
+                break;
+            case OP_TOGGLE_ALL:
+                for (int i = 0; i < n; i++) {
+                    w[i] = toggle_case(w[i]);
+                }
+                break;
+            case OP_TOGGLE_AT:
+                if (a < n) {
+                    w[a] = toggle_case(w[a]);
+                }
+                break;
+            case OP_REVERSE:
+                for (int i = 0; i < n / 2; i++) {
+                    char t = w[i];
+                    w[i] = w[n - 1 - i];
+                    w[n - 1 - i] = t;
+                }
+                break;
+            case OP_DUPLICATE:
+                if (2 * n > limit) return -1;
+                memcpy(w + n, w, n);
+                n *= 2;
+                break;
+            case OP_DUPLICATE_N:
+                if (n * (a + 1) > limit) return -1;
+                for (int i = 1; i <= a; i++) {
+                    memcpy(w + i * n, w, n);
+                }
+                n *= a + 1;
+                break;
+            case OP_REFLECT:
+                if (2 * n > limit) return -1;
+                for (int i = 0; i < n; i++) {
+                    w[n + i] = w[n - 1 - i];
+                }
+                n *= 2;
+                break;
+            case OP_DUPLICATE_CHARS:
+                if (2 * n > limit) return -1;
+                for (int i = n - 1; i >= 0; i--) {
+                    w[2 * i] = w[2 * i + 1] = w[i];
+                }
+                n *= 2;
+                break;
+            case OP_ROTATE_LEFT:
+                if (n > 1) {
+                    char t = w[0];
+                    memmove(w, w + 1, n - 1);
+                    w[n - 1] = t;
+                }
+                break;
+            case OP_ROTATE_RIGHT:
+                if (n > 1) {
+                    char t = w[n - 1];
+                    memmove(w + 1, w, n - 1);
+                    w[0] = t;
+                }
+                break;
+            case OP_APPEND:
+                if (n + 1 > limit) return -1;
+                w[n++] = x;
+                break;
+            case OP_PREPEND:
+                if (n + 1 > limit) return -1;
+                memmove(w + 1, w, n++);
+                w[0] = x;
+                break;
+            case OP_DELETE_FIRST:
+                if (n > 0) {
+                    memmove(w, w + 1, --n);
+                }
+                break;
+            case OP_DELETE_LAST:
+                if (n > 0) {
+                    n--;
+                }
+                break;
+            case OP_DELETE_AT:
+                if (a < n) {
+                    memmove(w + a, w + a + 1, n - a - 1);
+                    n--;
+                }
+                break;
+            case OP_TRUNCATE:
+                if (a < n) {
+                    n = a;
+                }
+                break;
+            case OP_INSERT:
+                if (a <= n) {
+                    if (n + 1 > limit) return -1;
+                    memmove(w + a + 1, w + a, n - a);
+                    w[a] = y;
+                    n++;
+                }
+                break;
+            case OP_OVERWRITE:
+                if (a < n) {
+                    w[a] = y;
+                }
+                break;
+            case OP_REPLACE:
+                for (int i = 0; i < n; i++) {
+                    if (w[i] == x) w[i] = y;
+                }
+                break;
+            case OP_PURGE: {
+                int kept = 0;
+                for (int i = 0; i < n; i++) {
+                    if (w[i] != x) w[kept++] = w[i];
+                }
+                n = kept;
+                break;
+            }
+        }
+    }
+    return n;
+}
+
+// build the probe words from every character the rules mention plus a fixed alphabet,
+// so that stems which treat any of those characters differently produce different output
+static void build_probes(const ParsedRule* rules, int numRules) {
+    char alphabet[256];
+    int size = 0;
+    int seen[256] = {0};
+    const char* base = "aZ0!bY1@cX9 iIlLoO";
+
+    for (const char* p = base; *p != '\0'; p++) {
+        if (!seen[(unsigned char)*p]) {
+            seen[(unsigned char)*p] = 1;
+            alphabet[size++] = *p;
+        }
+    }
+    for (int r = 0; r < numRules; r++) {
+        for (const unsigned char* code = rules[r].code; code[0] != OP_END; code += 3) {
+            // both argument bytes, and the other case of each, may be matched by the rule
+            for (int i = 1; i <= 2; i++) {
+                char c = (char)code[i];
+                // position arguments are small numbers, not characters
+                if ((unsigned char)c < ' ') {
+                    continue;
+                }
+                char variants[2] = {c, toggle_case(c)};
+                for (int j = 0; j < 2; j++) {
+                    if (!seen[(unsigned char)variants[j]]) {
+                        seen[(unsigned char)variants[j]] = 1;
+                        alphabet[size++] = variants[j];
+                    }
+                }
+            }
+        }
+    }
+
+    // every length up to MAX_PROBE_LENGTH, in two different orders of the alphabet
+    numProbes = 0;
+    for (int family = 0; family < 2; family++) {
+        for (int len = 1; len <= MAX_PROBE_LENGTH; len++) {
+            for (int i = 0; i < len; i++) {
+                int step = family == 0 ? i : i / 2 * 3 + 1;
+                probes[numProbes][i] = alphabet[(step + len) % size];
+            }
+            probeLens[numProbes++] = len;
+        }
+    }
+}
+
+// number of bytes of bytecode, including the terminating OP_END
+static int code_size(const unsigned char* code) {
+    int size = 0;
+    while (code[size] != OP_END) {
+        size += 3;
+    }
+    return size + 1;
+}
+
+// hash the output of a stem on every probe word
+static uint64_t probe_signature(const unsigned char* code) {
+    char out[MAX_WORD_LENGTH];
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < numProbes; i++) {
+        int n = run_code(code, probes[i], probeLens[i], out);
+        hash = fnv_update(hash, (const char*)&n, sizeof(n));
+        if (n > 0) {
+            hash = fnv_update(hash, out, n);
+        }
+    }
+    return hash;
+}
+
+// returns 1 if two stems produce the same output on every probe word
+static int same_output(const unsigned char* a, const unsigned char* b) {
+    char outA[MAX_WORD_LENGTH], outB[MAX_WORD_LENGTH];
+    for (int i = 0; i < numProbes; i++) {
+        int n = run_code(a, probes[i], probeLens[i], outA);
+        if (n != run_code(b, probes[i], probeLens[i], outB) || (n > 0 && memcmp(outA, outB, n) != 0)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// read the rule file, or the built-in rules, into an array of parsed rules
+static ParsedRule* read_rules(char* path, int* numRules) {
+    int capacity = 128;
+    int count = 0;
+    ParsedRule* rules = malloc(capacity * sizeof(ParsedRule));
+    unsigned char code[MAX_RULE_FUNCTIONS * 3 + 1];
+    char line[MAX_RULE_LENGTH];
+    FILE* file = NULL;
+    int lineNum = 0;
+
+    if (path != NULL) {
+        file = fopen(path, "r");
+        if (file == NULL) {
+            printf("error: '%s' is an invalid file\n", path);
+            printf("ensure file exists and entered correctly\n\n");
+            exit(1);
+        }
+    }
+
+    while (1) {
+        // next rule, from the file or from the built-in set
+        if (file != NULL) {
+            if (fgets(line, sizeof(line), file) == NULL) {
+                break;
+            }
+            size_t len = strlen(line);
+            while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+                line[--len] = '\0';
+            }
+        }
+        else {
+            if (lineNum == 8 * 11) {
+                break;
+            }
+            // each classic substitution alone, then with every trailing digit
+            int digit = lineNum % 11 - 1;
+            if (digit < 0) {
+                snprintf(line, sizeof(line), "%s", CLASSIC_SUBSTITUTIONS[lineNum / 11]);
+            }
+            else {
+                snprintf(line, sizeof(line), "%s $%d", CLASSIC_SUBSTITUTIONS[lineNum / 11], digit);
+            }
+        }
+        lineNum++;
+
+        // skip empty lines and comments
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        int numFunctions = parse_rule(line, code);
+        if (numFunctions < 0) {
+            printf("warning: skipping invalid rule on line %d of '%s'\n", lineNum, path);
+            continue;
+        }
+
+        // split off the trailing appends as the rule's suffix
+        int stemLength = numFunctions;
+        while (stemLength > 0 && code[(stemLength - 1) * 3] == OP_APPEND) {
+            stemLength--;
+        }
+        if (numFunctions - stemLength > MAX_WORD_LENGTH - 1) {
+            printf("warning: skipping invalid rule on line %d of '%s'\n", lineNum, path);
+            continue;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            rules = realloc(rules, capacity * sizeof(ParsedRule));
+        }
+        ParsedRule* rule = &rules[count++];
+        rule->suffixLen = numFunctions - stemLength;
+        for (int i = 0; i < rule->suffixLen; i++) {
+            rule->suffix[i] = (char)code[(stemLength + i) * 3 + 1];
+        }
+        rule->code = malloc(stemLength * 3 + 1);
+        memcpy(rule->code, code, stemLength * 3);
+        rule->code[stemLength * 3] = OP_END;
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+    *numRules = count;
+    return rules;
+}
+
+// returns 1 if two stems have the same list of suffixes
+static int same_suffixes(const RuleStem* a, const RuleStem* b) {
+    if (a->numSuffixes != b->numSuffixes) {
+        return 0;
+    }
+    for (int i = 0; i < a->numSuffixes; i++) {
+        int x = a->firstSuffix + i;
+        int y = b->firstSuffix + i;
+        if (RULES.suffixLens[x] != RULES.suffixLens[y] || memcmp(RULES.suffixes + RULES.suffixOffsets[x],
+                RULES.suffixes + RULES.suffixOffsets[y], RULES.suffixLens[x]) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void load_rules(char* path) {
+    int numRules;
+    ParsedRule* rules = read_rules(path, &numRules);
+    if (numRules == 0) {
+        printf("Failed to read a rule\n");
+        free(rules);
+        exit(1);
+    }
+    build_probes(rules, numRules);
+
+    // open addressing table of stems keyed on their probe signature
+    uint32_t size = 16;
+    while (size < (uint32_t)numRules * 2) {
+        size <<= 1;
+    }
+    int* table = malloc(size * sizeof(int));
+    uint64_t* signatures = malloc(size * sizeof(uint64_t));
+    for (uint32_t i = 0; i < size; i++) {
+        table[i] = -1;
+    }
+    // first rule of each stem, which holds the stem's bytecode
+    int* stemRule = malloc(numRules * sizeof(int));
+    int numStems = 0;
+
+    // group the rules by the output of their stem
+    for (int r = 0; r < numRules; r++) {
+        uint64_t signature = probe_signature(rules[r].code);
+        uint32_t pos = (uint32_t)signature & (size - 1);
+        while (table[pos] != -1 && (signatures[pos] != signature
+                || !same_output(rules[stemRule[table[pos]]].code, rules[r].code))) {
+            pos = (pos + 1) & (size - 1);
+        }
+        if (table[pos] == -1) {
+            table[pos] = numStems;
+            signatures[pos] = signature;
+            stemRule[numStems++] = r;
+        }
+        rules[r].stem = table[pos];
+    }
+
+    // copy the bytecode of every stem back to back
+    RULES.stems = malloc(numStems * sizeof(RuleStem));
+    RULES.numStems = numStems;
+    RULES.numRules = numRules;
+    int codeSize = 0;
+    for (int s = 0; s < numStems; s++) {
+        codeSize += code_size(rules[stemRule[s]].code);
+    }
+    RULES.code = malloc(codeSize);
+    codeSize = 0;
+    for (int s = 0; s < numStems; s++) {
+        RULES.stems[s].code = codeSize;
+        RULES.stems[s].numSuffixes = 0;
+        memcpy(RULES.code + codeSize, rules[stemRule[s]].code, code_size(rules[stemRule[s]].code));
+        codeSize += code_size(rules[stemRule[s]].code);
+    }
+
+    // order the rules stem by stem
+    int* order = malloc(numRules * sizeof(int));
+    int* fill = calloc(numStems, sizeof(int));
+    for (int r = 0; r < numRules; r++) {
+        RULES.stems[rules[r].stem].numSuffixes++;
+    }
+    int first = 0;
+    for (int s = 0; s < numStems; s++) {
+        RULES.stems[s].firstSuffix = first;
+        first += RULES.stems[s].numSuffixes;
+    }
+    for (int r = 0; r < numRules; r++) {
+        int s = rules[r].stem;
+        order[RULES.stems[s].firstSuffix + fill[s]++] = r;
+    }
+
+    // copy the suffixes stem by stem, dropping any a stem already has; stems with the
+    // same list of suffixes share one copy of it, which also lets a consumer recognize
+    // stems whose candidates are all repeated
+    int suffixSize = 0;
+    for (int r = 0; r < numRules; r++) {
+        suffixSize += rules[r].suffixLen;
+    }
+    RULES.suffixes = malloc(suffixSize + 1);
+    RULES.suffixOffsets = malloc(numRules * sizeof(int));
+    RULES.suffixLens = malloc(numRules * sizeof(unsigned char));
+    for (uint32_t i = 0; i < size; i++) {
+        table[i] = -1;
+    }
+    CandidateSet seen;
+    candidate_set_init(&seen, numRules);
+    int numSuffixes = 0;
+    int numCandidates = 0;
+    int offset = 0;
+    for (int s = 0; s < numStems; s++) {
+        int start = RULES.stems[s].firstSuffix;
+        int end = start + RULES.stems[s].numSuffixes;
+        int first = numSuffixes;
+        int firstOffset = offset;
+        uint64_t signature = 0xcbf29ce484222325ULL;
+        candidate_set_clear(&seen);
+        for (int i = start; i < end; i++) {
+            ParsedRule* rule = &rules[order[i]];
+            if (!candidate_set_add(&seen, "", 0, rule->suffix, rule->suffixLen)) {
+                continue;
+            }
+            memcpy(RULES.suffixes + offset, rule->suffix, rule->suffixLen);
+            RULES.suffixOffsets[numSuffixes] = offset;
+            RULES.suffixLens[numSuffixes] = (unsigned char)rule->suffixLen;
+            signature = fnv_update(signature, (const char*)&rule->suffixLen, sizeof(int));
+            signature = fnv_update(signature, rule->suffix, rule->suffixLen);
+            offset += rule->suffixLen;
+            numSuffixes++;
+        }
+        RULES.stems[s].firstSuffix = first;
+        RULES.stems[s].numSuffixes = numSuffixes - first;
+        numCandidates += numSuffixes - first;
+
+        // reuse the copy of an earlier stem with the same list
+        uint32_t pos = (uint32_t)signature & (size - 1);
+        while (table[pos] != -1) {
+            const RuleStem* other = &RULES.stems[table[pos]];
+            if (signatures[pos] == signature && same_suffixes(other, &RULES.stems[s])) {
+                RULES.stems[s].firstSuffix = other->firstSuffix;
+                numSuffixes = first;
+                offset = firstOffset;
+                break;
+            }
+            pos = (pos + 1) & (size - 1);
+        }
+        if (table[pos] == -1) {
+            table[pos] = s;
+            signatures[pos] = signature;
+        }
+    }
+    RULES.numSuffixes = numSuffixes;
+    RULES.numCandidates = numCandidates;
+    // fingerprint the compiled rules, a checkpoint is only resumed with the same ones
+    RULES.checksum = fnv_update(0xcbf29ce484222325ULL, (const char*)RULES.code, codeSize);
+    RULES.checksum = fnv_update(RULES.checksum, (const char*)RULES.stems, numStems * sizeof(RuleStem));
+    RULES.checksum = fnv_update(RULES.checksum, RULES.suffixes, offset);
+    RULES.checksum = fnv_update(RULES.checksum, (const char*)RULES.suffixLens, numSuffixes);
+
+    candidate_set_free(&seen);
+    for (int r = 0; r < numRules; r++) {
+        free(rules[r].code);
+    }
+    free(rules);
+    free(table);
+    free(signatures);
+    free(stemRule);
+    free(order);
+    free(fill);
+}
+
+void free_rules() {
+    free(RULES.stems);
+    free(RULES.code);
+    free(RULES.suffixes);
+    free(RULES.suffixOffsets);
+    free(RULES.suffixLens);
+    RULES.stems = NULL;
+    RULES.numStems = RULES.numSuffixes = 0;
+}
+
+int apply_stem(int stem, const char* word, int len, char* out) {
+    return run_code(RULES.code + RULES.stems[stem].code, word, len, out);
+}
+
+void candidate_set_init(CandidateSet* set, int capacity) {
+    // keep the table at most half full so probe chains stay short
+    uint32_t size = 16;
+    while (size < (uint32_t)capacity * 2) {
+        size <<= 1;
+    }
+    set->entries = calloc(size, sizeof(CandidateEntry));
+    set->mask = size - 1;
+    set->generation = 1;
+    set->lastStem = NULL;
+}
+
+void candidate_set_clear(CandidateSet* set) {
+    set->generation++;
+    // the stems of the next word may reuse the same storage
+    set->lastStem = NULL;
+    // the generation wrapped around, entries of an old word could look current
+    if (set->generation == 0) {
+        memset(set->entries, 0, (set->mask + 1) * sizeof(CandidateEntry));
+        set->generation = 1;
+    }
+}
+
+// character `i` of the candidate held by an entry
+static char entry_char(const CandidateEntry* entry, int i) {
+    return i < entry->stemLen ? entry->stem[i] : entry->suffix[i - entry->stemLen];
+}
+
+int candidate_set_add(CandidateSet* set, const char* stem, int stemLen, const char* suffix, int suffixLen) {
+    // hash the stem only once for all of its suffixes
+    if (stem != set->lastStem || stemLen != set->lastStemLen) {
+        set->lastStem = stem;
+        set->lastStemLen = stemLen;
+        set->lastStemHash = fnv_update(0xcbf29ce484222325ULL, stem, stemLen);
+    }
+    uint64_t hash = fnv_update(set->lastStemHash, suffix, suffixLen);
+    CandidateEntry candidate = {hash, set->generation, stemLen + suffixLen, stem, suffix, stemLen};
+    uint32_t pos = (uint32_t)(hash >> 32) & set->mask;
+
+    // linear probing until an empty slot or an equal candidate is found
+    while (set->entries[pos].generation == set->generation) {
+        CandidateEntry* entry = &set->entries[pos];
+        if (entry->hash == hash && entry->len == candidate.len) {
+            // candidates split at the same place compare part by part
+            if (entry->stemLen == stemLen) {
+                if (memcmp(entry->stem, stem, stemLen) == 0 && memcmp(entry->suffix, suffix, suffixLen) == 0) {
+                    return 0;
+                }
+            }
+            else {
+                int i = 0;
+                while (i < candidate.len && entry_char(entry, i) == entry_char(&candidate, i)) {
+                    i++;
+                }
+                if (i == candidate.len) {
+                    return 0;
+                }
+            }
+        }
+        pos = (pos + 1) & set->mask;
+    }
+    set->entries[pos] = candidate;
+    return 1;
+}
+
+void candidate_set_free(CandidateSet* set) {
+    free(set->entries);
+    set->entries = NULL;
+}
@@ -0,0 +1,160 @@
+/** rules.h
+ * This file contains the declarations of the word mangling rule engine. Every dictionary
+ * word is turned into candidates by a list of rules written in a practical subset of the
+ * hashcat/John the Ripper rule language, read from a rule file with `--rules` or taken
+ * from the built-in set, which reproduces the classic variants (every combination of the
+ * substitutions i -> !, l -> 1 and o -> 0, each alone and with a trailing digit 0-9).
+ *
+ * Rules are compiled once at startup into a compact bytecode. Each rule is split into a
+ * stem, the functions before any trailing run of appends, and a suffix, the characters
+ * those appends add. Rules with the same stem are grouped, so a consumer runs each stem
+ * once per word and derives every candidate of the group by adding a suffix, which is
+ * also what lets the hashing work of the stem be shared (see sha-256.h). Stems that
+ * produce identical output on probe words of every length a dictionary word can have are
+ * merged and repeated suffixes are dropped, so equivalent rules are never hashed twice.
+ *
+ * Supported functions (N is a position 0-9 or A-Z for 10-35, X and Y are characters):
+ *   :     do nothing              l     lowercase all          u     uppercase all
+ *   c     capitalize              C     invert capitalize      t     toggle case of all
+ *   TN    toggle case at N        r     reverse                d     duplicate
+ *   pN    append N copies         f     append reversed        q     duplicate every char
+ *   {     rotate left             }     rotate right           $X    append X
+ *   ^X    prepend X               [     delete first           ]     delete last
+ *   DN    delete at N             'N    truncate at N          iNX   insert X at N
+ *   oNX   overwrite at N with X   sXY   replace X with Y       @X    purge X
+ * Spaces between functions are ignored, and empty lines and lines starting with `#` are
+ * skipped. A rule whose output would exceed MAX_WORD_LENGTH - 1 characters is rejected
+ * for that word.
+ *
+ * The main components of this file include:
+ * - The `RuleStem` and `RuleSet` structures, the compiled rules.
+ * - The `CandidateSet` structure, which drops repeated candidates of a single word.
+ * - load_rules(): Compiles a rule file, or the built-in rules, into the global `RULES`.
+ * - apply_stem(): Runs the bytecode of a stem on a word.
+ * - candidate_set_*(): Manage the per-word set of candidates.
+ */
+
+#ifndef __RULES__
+#define __RULES__
+#include <stdint.h>
+
+/** RuleStem
+ * A group of rules sharing the same functions before their trailing appends. The
+ * candidates of the group are the stem's output followed by each of its suffixes;
+ * an empty suffix stands for the stem's output itself.
+ */
+typedef struct {
+    int code;                    // Offset of the stem's bytecode in `RuleSet.code`
+    int firstSuffix;             // Index of the stem's first suffix in `RuleSet`, stems with
+                                 // the same list of suffixes share the same index
+    int numSuffixes;             // Number of suffixes of the stem
+} RuleStem;
+
+/** RuleSet
+ * The compiled rules: the stems, their bytecode and all of their suffixes.
+ */
+typedef struct {
+    RuleStem* stems;             // Array of unique stems
+    int numStems;                // Number of unique stems
+    unsigned char* code;         // Bytecode of every stem, three bytes per function
+    char* suffixes;              // Characters of every suffix, back to back
+    int* suffixOffsets;          // Offset of each suffix in `suffixes`
+    unsigned char* suffixLens;   // Length of each suffix
+    int numSuffixes;             // Number of suffixes stored
+    int numCandidates;           // Number of unique rules, the most candidates of one word
+    int numRules;                // Number of rules read, before deduplication
+    uint64_t checksum;           // Fingerprint of the compiled rules, checked on --resume
+} RuleSet;
+
+// compiled mangling rules applied to every word
+extern RuleSet RULES;
+
+/** CandidateEntry
+ * One slot of a `CandidateSet`, a candidate referenced as stem output plus suffix.
+ */
+typedef struct {
+    uint64_t hash;               // Hash of the candidate's characters
+    unsigned generation;         // Word the entry belongs to, older entries are empty
+    int len;                     // Length of the candidate
+    const char* stem;            // Stem output the candidate starts with
+    const char* suffix;          // Suffix the candidate ends with
+    int stemLen;                 // Length of the stem output
+} CandidateEntry;
+
+/** CandidateSet
+ * An open addressing set of the candidates already generated for the current word.
+ * Clearing it only bumps the generation, so it costs nothing per word.
+ */
+typedef struct {
+    CandidateEntry* entries;     // Power of two sized table
+    uint32_t mask;               // Table size - 1
+    unsigned generation;         // Generation of the current word
+    const char* lastStem;        // Stem of the previous candidate added
+    int lastStemLen;             // Length of that stem
+    uint64_t lastStemHash;       // Hash of that stem, reused by its following suffixes
+} CandidateSet;
+
+/** load_rules()
+ * This function reads a rule file and compiles it into the global `RULES` set. Lines
+ * that are not valid rules are reported and skipped. If `path` is NULL, the built-in
+ * rules are compiled instead. If the file cannot be opened or contains no valid rule,
+ * the function prints an error and exits.
+ *
+ * @param path Path to the rule file, or NULL for the built-in rules.
+ */
+void load_rules(char*);
+
+/** free_rules()
+ * This function releases the memory held by the global `RULES` set.
+ */
+void free_rules();
+
+/** apply_stem()
+ * This function runs the bytecode of a stem on a word.
+ *
+ * @param stem Index of the stem in the global `RULES` set.
+ * @param word The characters of the word, not necessarily terminated.
+ * @param len The length of the word.
+ * @param out Array of at least MAX_WORD_LENGTH characters that receives the output,
+ * which is not terminated.
+ * @return int Length of the output, or -1 if the rule rejects the word.
+ */
+int apply_stem(int, const char*, int, char*);
+
+/** candidate_set_init()
+ * This function allocates an empty set large enough for the candidates of one word.
+ *
+ * @param set The set to initialize.
+ * @param capacity Largest number of candidates added between two clears.
+ */
+void candidate_set_init(CandidateSet*, int);
+
+/** candidate_set_clear()
+ * This function empties the set before the candidates of the next word are added.
+ *
+ * @param set The set to clear.
+ */
+void candidate_set_clear(CandidateSet*);
+
+/** candidate_set_add()
+ * This function adds the candidate stem + suffix to the set. Both parts must stay
+ * valid until the set is cleared. The hash of the stem is reused while consecutive
+ * calls pass the same stem, so adding every suffix of a stem in a row is cheap.
+ *
+ * @param set The set to add to.
+ * @param stem The stem output.
+ * @param stemLen Length of the stem output.
+ * @param suffix The suffix.
+ * @param suffixLen Length of the suffix.
+ * @return int 1 if the candidate is new, 0 if it was already generated for this word.
+ */
+int candidate_set_add(CandidateSet*, const char*, int, const char*, int);
+
+/** candidate_set_free()
+ * This function releases the memory held by a set.
+ *
+ * @param set The set to free.
+ */
+void candidate_set_free(CandidateSet*);
+
+#endif
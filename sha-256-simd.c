@@ -0,0 +1,401 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "sha-256.h"
+#include "sha-256-simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#include <cpuid.h>
+#define SHA_256_X86 1
+#endif
+
+/*
+ * A kernel compresses n independent (state, block) pairs in place. When first is non-zero,
+ * work holds the working variables of each pair after its first `first` rounds; kernels
+ * may resume from there or ignore it and start over from the state.
+ */
+typedef void (*compress_fn)(uint32_t (*state)[8], const uint32_t (*work)[8], const uint32_t (*block)[16],
+	int first, int n);
+
+static void compress_scalar(uint32_t (*state)[8], const uint32_t (*work)[8], const uint32_t (*block)[16],
+	int first, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		sha_256_compress_from(state[i], first > 0 ? work[i] : state[i], block[i], first);
+}
+
+#ifdef SHA_256_X86
+
+/*
+ * SSE4.1, 4 lanes.
+ */
+#define LANES_FN compress_sse41
+#define LANES_TARGET "sse4.1"
+#define LANES 4
+#define VEC __m128i
+#define V_ADD(a, b) _mm_add_epi32(a, b)
+#define V_XOR3(a, b, c) _mm_xor_si128(_mm_xor_si128(a, b), c)
+#define V_SRL(x, n) _mm_srli_epi32(x, n)
+#define V_ROR(x, n) _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - (n)))
+#define V_CH(e, f, g) _mm_xor_si128(_mm_and_si128(e, f), _mm_andnot_si128(e, g))
+#define V_MAJ(a, b, c) _mm_or_si128(_mm_and_si128(a, b), _mm_and_si128(c, _mm_or_si128(a, b)))
+#define V_SET1(x) _mm_set1_epi32((int) (x))
+#define V_LOAD(p) _mm_load_si128((const __m128i *) (p))
+#define V_STORE(p, x) _mm_store_si128((__m128i *) (p), x)
+#include "sha-256-lanes.inc"
+#undef LANES_FN
+#undef LANES_TARGET
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR3
+#undef V_SRL
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+/*
+ * AVX2, 8 lanes.
+ */
+#define LANES_FN compress_avx2
+#define LANES_TARGET "avx2"
+#define LANES 8
+#define VEC __m256i
+#define V_ADD(a, b) _mm256_add_epi32(a, b)
+#define V_XOR3(a, b, c) _mm256_xor_si256(_mm256_xor_si256(a, b), c)
+#define V_SRL(x, n) _mm256_srli_epi32(x, n)
+#define V_ROR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define V_CH(e, f, g) _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g))
+#define V_MAJ(a, b, c) _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)))
+#define V_SET1(x) _mm256_set1_epi32((int) (x))
+#define V_LOAD(p) _mm256_load_si256((const __m256i *) (p))
+#define V_STORE(p, x) _mm256_store_si256((__m256i *) (p), x)
+#include "sha-256-lanes.inc"
+#undef LANES_FN
+#undef LANES_TARGET
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR3
+#undef V_SRL
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+/*
+ * AVX-512, 16 lanes. Rotates and the three-input boolean functions map to single instructions.
+ */
+#define LANES_FN compress_avx512
+#define LANES_TARGET "avx512f"
+#define LANES 16
+#define VEC __m512i
+#define V_ADD(a, b) _mm512_add_epi32(a, b)
+#define V_XOR3(a, b, c) _mm512_ternarylogic_epi32(a, b, c, 0x96)
+#define V_SRL(x, n) _mm512_srli_epi32(x, n)
+#define V_ROR(x, n) _mm512_ror_epi32(x, n)
+#define V_CH(e, f, g) _mm512_ternarylogic_epi32(e, f, g, 0xca)
+#define V_MAJ(a, b, c) _mm512_ternarylogic_epi32(a, b, c, 0xe8)
+#define V_SET1(x) _mm512_set1_epi32((int) (x))
+#define V_LOAD(p) _mm512_load_si512((const void *) (p))
+#define V_STORE(p, x) _mm512_store_si512((void *) (p), x)
+#include "sha-256-lanes.inc"
+#undef LANES_FN
+#undef LANES_TARGET
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR3
+#undef V_SRL
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+/*
+ * SHA-NI: four rounds per pair of sha256rnds2 instructions, with the message schedule
+ * computed by sha256msg1/sha256msg2. The state is kept in the ABEF/CDGH layout the
+ * instructions expect. Blocks are already big-endian words, so no byte shuffle is needed.
+ * Rounds come in fours, so precomputed prefix rounds are ignored and every block is
+ * compressed from its state.
+ */
+__attribute__((target("sha,sse4.1")))
+static void compress_shani(uint32_t (*state)[8], const uint32_t (*work)[8], const uint32_t (*block)[16],
+	int first, int n)
+{
+	__m128i state0, state1, abef, cdgh, msg, tmp;
+	__m128i w[16];
+	int b, i;
+
+	for (b = 0; b < n; b++) {
+		tmp = _mm_loadu_si128((const __m128i *) &state[b][0]);     /* DCBA */
+		state1 = _mm_loadu_si128((const __m128i *) &state[b][4]);  /* HGFE */
+		tmp = _mm_shuffle_epi32(tmp, 0xb1);                         /* CDAB */
+		state1 = _mm_shuffle_epi32(state1, 0x1b);                   /* EFGH */
+		state0 = _mm_alignr_epi8(tmp, state1, 8);                   /* ABEF */
+		state1 = _mm_blend_epi16(state1, tmp, 0xf0);                /* CDGH */
+		abef = state0;
+		cdgh = state1;
+
+		for (i = 0; i < 16; i++) {
+			if (i < 4) {
+				w[i] = _mm_loadu_si128((const __m128i *) &block[b][i * 4]);
+			} else {
+				tmp = _mm_alignr_epi8(w[i - 1], w[i - 2], 4);
+				tmp = _mm_add_epi32(_mm_sha256msg1_epu32(w[i - 4], w[i - 3]), tmp);
+				w[i] = _mm_sha256msg2_epu32(tmp, w[i - 1]);
+			}
+			msg = _mm_add_epi32(w[i], _mm_loadu_si128((const __m128i *) &sha_256_k[i * 4]));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+			msg = _mm_shuffle_epi32(msg, 0x0e);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		}
+
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+
+		tmp = _mm_shuffle_epi32(state0, 0x1b);                      /* FEBA */
+		state1 = _mm_shuffle_epi32(state1, 0xb1);                   /* DCHG */
+		state0 = _mm_blend_epi16(tmp, state1, 0xf0);                /* DCBA */
+		state1 = _mm_alignr_epi8(state1, tmp, 8);                   /* HGFE */
+		_mm_storeu_si128((__m128i *) &state[b][0], state0);
+		_mm_storeu_si128((__m128i *) &state[b][4], state1);
+	}
+}
+
+/* The SHA extensions are reported in cpuid leaf 7, ebx bit 29. */
+static int cpu_has_sha()
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return 0;
+	return (ebx >> 29) & 1;
+}
+
+#endif
+
+/* Candidate kernels, in the order they are measured. */
+struct engine {
+	const char *name;
+	int lanes;
+	compress_fn compress;
+};
+
+static struct engine selected = { "scalar", 1, compress_scalar };
+
+/* Seconds spent by kernel e compressing a fixed synthetic batch. */
+static double measure(const struct engine *e)
+{
+	enum { BLOCKS = 2048, ROUNDS = 4 };
+	static uint32_t states[BLOCKS][8];
+	static uint32_t blocks[BLOCKS][16];
+	struct timespec start, end;
+	int i, j;
+
+	for (i = 0; i < BLOCKS; i++) {
+		for (j = 0; j < 16; j++)
+			blocks[i][j] = (uint32_t) (i * 16 + j) * 2654435761u;
+		memcpy(states[i], sha_256_h0, sizeof states[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < ROUNDS; i++)
+		e->compress(states, NULL, (const uint32_t (*)[16]) blocks, 0, BLOCKS);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void sha_256_engine_init()
+{
+	struct engine candidates[5];
+	int count = 0;
+	double best, t;
+	int i;
+
+	candidates[count].name = "scalar";
+	candidates[count].lanes = 1;
+	candidates[count++].compress = compress_scalar;
+
+#ifdef SHA_256_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.1")) {
+		candidates[count].name = "sse4.1";
+		candidates[count].lanes = 4;
+		candidates[count++].compress = compress_sse41;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		candidates[count].name = "avx2";
+		candidates[count].lanes = 8;
+		candidates[count++].compress = compress_avx2;
+	}
+	if (__builtin_cpu_supports("avx512f")) {
+		candidates[count].name = "avx512";
+		candidates[count].lanes = 16;
+		candidates[count++].compress = compress_avx512;
+	}
+	if (__builtin_cpu_supports("sse4.1") && cpu_has_sha()) {
+		candidates[count].name = "sha-ni";
+		candidates[count].lanes = 4;
+		candidates[count++].compress = compress_shani;
+	}
+#endif
+
+	/* Keep the fastest kernel; the first pass of each also warms up its code and data. */
+	selected = candidates[0];
+	best = measure(&candidates[0]);
+	for (i = 1; i < count; i++) {
+		measure(&candidates[i]);
+		t = measure(&candidates[i]);
+		if (t < best) {
+			best = t;
+			selected = candidates[i];
+		}
+	}
+}
+
+const char* sha_256_engine_name()
+{
+	return selected.name;
+}
+
+int sha_256_engine_lanes()
+{
+	return selected.lanes;
+}
+
+void sha_256_compress_batch(uint32_t (*state)[8], const uint32_t (*block)[16], int n)
+{
+	selected.compress(state, NULL, block, 0, n);
+}
+
+void sha_256_compress_from_batch(uint32_t (*state)[8], const uint32_t (*work)[8], const uint32_t (*block)[16],
+	int first, int n)
+{
+	selected.compress(state, work, block, first, n);
+}
+
+/*
+ * Pads n messages of the same single-block length: the padding and length words are laid
+ * out once, and every lane only packs its whole message words, four bytes at a time.
+ */
+static void pack_uniform(uint32_t (*blocks)[16], const char* const* msgs, size_t len, int n)
+{
+	uint32_t layout[16];
+	size_t words = len >> 2;
+	size_t tail = len & 3;
+	uint32_t word;
+	int i;
+	size_t j;
+
+	memset(layout, 0x00, sizeof layout);
+	layout[words] = (uint32_t) 0x80 << (24 - 8 * tail);
+	layout[15] = (uint32_t) (len << 3);
+	for (i = 0; i < n; i++) {
+		const uint8_t *p = (const uint8_t *) msgs[i];
+
+		memcpy(blocks[i], layout, sizeof layout);
+		for (j = 0; j < words; j++) {
+			memcpy(&word, p + 4 * j, sizeof word);
+			blocks[i][j] = __builtin_bswap32(word);
+		}
+		for (j = 0; j < tail; j++)
+			blocks[i][words] |= (uint32_t) p[4 * words + j] << (24 - 8 * j);
+	}
+}
+
+void sha_256_batch(const char* const* msgs, const size_t* lens, int n, uint32_t (*digests)[8])
+{
+	uint32_t blocks[SHA_256_MAX_LANES][16];
+	int index[SHA_256_MAX_LANES];
+	int count = 0;
+	int i, j;
+
+	/* A batch staged by length shares one padding layout. */
+	for (i = 1; i < n && lens[i] == lens[0]; i++)
+		;
+	if (n > 0 && i == n && lens[0] <= SHA_256_MAX_SINGLE_BLOCK) {
+		pack_uniform(blocks, msgs, lens[0], n);
+		for (i = 0; i < n; i++)
+			memcpy(digests[i], sha_256_h0, sizeof digests[i]);
+		selected.compress(digests, NULL, (const uint32_t (*)[16]) blocks, 0, n);
+		return;
+	}
+
+	/* Pad every short message into its own block, hash long ones directly. */
+	for (i = 0; i < n; i++) {
+		if (lens[i] > SHA_256_MAX_SINGLE_BLOCK) {
+			sha_256_words(digests[i], msgs[i], lens[i]);
+			continue;
+		}
+		sha_256_single_block_words(blocks[count], msgs[i], lens[i]);
+		index[count++] = i;
+	}
+	if (count == 0)
+		return;
+
+	/* Compress in place, the digests start as the initial hash values. */
+	if (count == n) {
+		for (i = 0; i < n; i++)
+			memcpy(digests[i], sha_256_h0, sizeof digests[i]);
+		selected.compress(digests, NULL, (const uint32_t (*)[16]) blocks, 0, n);
+		return;
+	}
+	{
+		uint32_t states[SHA_256_MAX_LANES][8];
+
+		for (i = 0; i < count; i++)
+			memcpy(states[i], sha_256_h0, sizeof states[i]);
+		selected.compress(states, NULL, (const uint32_t (*)[16]) blocks, 0, count);
+		for (i = 0; i < count; i++)
+			for (j = 0; j < 8; j++)
+				digests[index[i]][j] = states[i][j];
+	}
+}
+
+void sha_256_prefix_batch(const struct sha_256_prefix* const* prefixes, const char* const* tails,
+	const size_t* lens, int n, uint32_t (*digests)[8])
+{
+	uint32_t blocks[SHA_256_MAX_LANES][16];
+	uint32_t states[SHA_256_MAX_LANES][8];
+	uint32_t work[SHA_256_MAX_LANES][8];
+	int index[SHA_256_MAX_LANES];
+	int count = 0;
+	int first = -1;
+	int i;
+
+	/* Build the last block of every message; tails that spill over take the scalar path. */
+	for (i = 0; i < n; i++) {
+		if (!sha_256_prefix_block(prefixes[i], blocks[count], tails[i], lens[i])) {
+			sha_256_prefix_finish(prefixes[i], digests[i], tails[i], lens[i]);
+			continue;
+		}
+		memcpy(states[count], prefixes[i]->h, sizeof states[count]);
+		memcpy(work[count], prefixes[i]->work, sizeof work[count]);
+		/* Lanes run in lockstep, so the precomputed rounds are only used when they all agree. */
+		if (first == -1)
+			first = prefixes[i]->rounds;
+		else if (first != prefixes[i]->rounds)
+			first = 0;
+		index[count++] = i;
+	}
+	if (count == 0)
+		return;
+
+	selected.compress(states, (const uint32_t (*)[8]) work, (const uint32_t (*)[16]) blocks, first, count);
+	for (i = 0; i < count; i++)
+		memcpy(digests[index[i]], states[i], sizeof states[i]);
+}
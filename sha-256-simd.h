@@ -0,0 +1,97 @@
+/** sha-256-simd.h
+ * This file contains the declarations of the multi-buffer SHA-256 engine used by the
+ * consumer threads. Instead of hashing one candidate at a time, the engine compresses a
+ * batch of independent blocks per call using the widest kernel the CPU supports:
+ * - SHA-NI: the x86 SHA extensions, one block at a time but in dedicated hardware.
+ * - AVX-512: 16 lanes of 32-bit words per instruction.
+ * - AVX2: 8 lanes.
+ * - SSE4.1: 4 lanes.
+ * - scalar: `sha_256_compress` from sha-256.c, used when nothing else is available.
+ *
+ * The kernel is chosen once by `sha_256_engine_init`, which checks cpuid for every
+ * candidate kernel and keeps the one with the highest measured throughput.
+ */
+
+#ifndef __SHA256_SIMD_H
+#define __SHA256_SIMD_H
+#include <stdint.h>
+#include <stddef.h>
+#include "sha-256.h"
+
+/* Widest batch any kernel processes in a single pass. */
+#define SHA_256_MAX_LANES 16
+
+/** sha_256_engine_init()
+ * This function detects the instruction sets supported by the CPU, measures the
+ * throughput of every usable kernel on a short synthetic batch and selects the
+ * fastest one. It must be called once by main before any thread is created.
+ */
+void sha_256_engine_init();
+
+/** sha_256_engine_name()
+ * @return const char* Name of the selected kernel (e.g. "avx2").
+ */
+const char* sha_256_engine_name();
+
+/** sha_256_engine_lanes()
+ * @return int Number of candidates the selected kernel hashes per pass, which is the
+ * natural batch size for callers.
+ */
+int sha_256_engine_lanes();
+
+/** sha_256_compress_batch()
+ * This function runs the compression function on `n` independent (state, block) pairs
+ * with the selected kernel, updating each state in place.
+ *
+ * @param state Array of `n` hash states, eight 32-bit words each.
+ * @param block Array of `n` blocks, sixteen big-endian 32-bit words each.
+ * @param n Number of pairs to compress.
+ */
+void sha_256_compress_batch(uint32_t (*)[8], const uint32_t (*)[16], int);
+
+/** sha_256_compress_from_batch()
+ * This function finishes `n` independent compressions whose first rounds were already
+ * run with `sha_256_rounds` (see sha-256.h), e.g. the rounds fixed by a shared prefix.
+ * Every lane resumes after the same number of rounds.
+ *
+ * @param state Array of `n` hash states, eight 32-bit words each, updated in place.
+ * @param work Array of `n` working variables after the first `first` rounds.
+ * @param block Array of `n` complete blocks, sixteen big-endian 32-bit words each.
+ * @param first Number of rounds already run, at most 16.
+ * @param n Number of compressions.
+ */
+void sha_256_compress_from_batch(uint32_t (*)[8], const uint32_t (*)[8], const uint32_t (*)[16], int, int);
+
+/** sha_256_batch()
+ * This function hashes `n` independent messages. Messages of at most
+ * SHA_256_MAX_SINGLE_BLOCK bytes are padded into single blocks and compressed together
+ * by the selected kernel; longer messages fall back to the scalar implementation. When
+ * all `n` messages have the same length, as in the batches the consumers stage by
+ * length, the padding is laid out once and the messages are packed a word at a time.
+ *
+ * @param msgs Array of `n` pointers to the messages.
+ * @param lens Array of `n` message lengths in bytes.
+ * @param n Number of messages, at most SHA_256_MAX_LANES.
+ * @param digests Receives `n` digests as eight big-endian 32-bit words each.
+ */
+void sha_256_batch(const char* const*, const size_t*, int, uint32_t (*)[8]);
+
+/** sha_256_prefix_batch()
+ * This function is the shared-prefix batch API: it hashes `n` messages of the form
+ * prefix + tail, where each prefix was precomputed once with `sha_256_prefix_init`
+ * (see sha-256.h) and is typically shared by many tails, e.g. every trailing-digit
+ * variant of a word. The last block of every message is compressed by the selected
+ * kernel, resuming after the rounds the prefix already ran when every lane of the
+ * batch has the same number of them. Tails that do not fit the prefix's last block
+ * fall back to the scalar `sha_256_prefix_finish`.
+ *
+ * @param prefixes Array of `n` pointers to precomputed prefixes, which may repeat.
+ * @param tails Array of `n` pointers to the tails.
+ * @param lens Array of `n` tail lengths in bytes.
+ * @param n Number of messages, at most SHA_256_MAX_LANES.
+ * @param digests Receives `n` digests as eight big-endian 32-bit words each.
+ */
+void sha_256_prefix_batch(const struct sha_256_prefix* const*, const char* const*, const size_t*, int,
+    uint32_t (*)[8]);
+
+#endif
@@ -20,7 +20,7 @@
  * Initialize array of round constants:
  * (first 32 bits of the fractional parts of the cube roots of the first 64 primes 2..311):
  */
-static const uint32_t k[] = {
+const uint32_t sha_256_k[64] = {
 	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
 	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
 	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
@@ -31,6 +31,14 @@ static const uint32_t k[] = {
 	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
+/*
+ * Initial hash values:
+ * (first 32 bits of the fractional parts of the square roots of the first 8 primes 2..19):
+ */
+const uint32_t sha_256_h0[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
 struct buffer_state {
 	const uint8_t * p;
 	size_t len;
@@ -180,7 +188,7 @@ void calc_sha_256(uint8_t hash[32], const void * input, size_t len)
 		for (i = 0; i < 64; i++) {
 			const uint32_t s1 = right_rot(ah[4], 6) ^ right_rot(ah[4], 11) ^ right_rot(ah[4], 25);
 			const uint32_t ch = (ah[4] & ah[5]) ^ (~ah[4] & ah[6]);
-			const uint32_t temp1 = ah[7] + s1 + ch + k[i] + w[i];
+			const uint32_t temp1 = ah[7] + s1 + ch + sha_256_k[i] + w[i];
 			const uint32_t s0 = right_rot(ah[0], 2) ^ right_rot(ah[0], 13) ^ right_rot(ah[0], 22);
 			const uint32_t maj = (ah[0] & ah[1]) ^ (ah[0] & ah[2]) ^ (ah[1] & ah[2]);
 			const uint32_t temp2 = s0 + maj;
@@ -210,6 +218,228 @@ void calc_sha_256(uint8_t hash[32], const void * input, size_t len)
 	}
 }
 
+/*
+ * Runs the first `count` rounds (count <= 16) of the compression of `block` on the
+ * working variables `work`, which start as a copy of the hash state. Only the first
+ * 16 message schedule words are needed, so nothing depends on the rest of the block
+ * beyond word count - 1.
+ */
+void sha_256_rounds(uint32_t work[8], const uint32_t block[16], int count)
+{
+	uint32_t a, b, c, d, e, f, g, hh;
+	int i;
+
+	a = work[0]; b = work[1]; c = work[2]; d = work[3];
+	e = work[4]; f = work[5]; g = work[6]; hh = work[7];
+
+	for (i = 0; i < count; i++) {
+		const uint32_t s1 = right_rot(e, 6) ^ right_rot(e, 11) ^ right_rot(e, 25);
+		const uint32_t ch = (e & f) ^ (~e & g);
+		const uint32_t temp1 = hh + s1 + ch + sha_256_k[i] + block[i];
+		const uint32_t s0 = right_rot(a, 2) ^ right_rot(a, 13) ^ right_rot(a, 22);
+		const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+		const uint32_t temp2 = s0 + maj;
+
+		hh = g; g = f; f = e; e = d + temp1;
+		d = c; c = b; b = a; a = temp1 + temp2;
+	}
+
+	work[0] = a; work[1] = b; work[2] = c; work[3] = d;
+	work[4] = e; work[5] = f; work[6] = g; work[7] = hh;
+}
+
+/*
+ * Finishes the compression of `block` from round `first`, given the working variables
+ * `work` produced by sha_256_rounds(work, block, first), and adds the result to h.
+ */
+void sha_256_compress_from(uint32_t h[8], const uint32_t work[8], const uint32_t block[16], int first)
+{
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, hh;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = block[i];
+	for (i = 16; i < 64; i++) {
+		const uint32_t s0 = right_rot(w[i - 15], 7) ^ right_rot(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		const uint32_t s1 = right_rot(w[i - 2], 17) ^ right_rot(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	a = work[0]; b = work[1]; c = work[2]; d = work[3];
+	e = work[4]; f = work[5]; g = work[6]; hh = work[7];
+
+	for (i = first; i < 64; i++) {
+		const uint32_t s1 = right_rot(e, 6) ^ right_rot(e, 11) ^ right_rot(e, 25);
+		const uint32_t ch = (e & f) ^ (~e & g);
+		const uint32_t temp1 = hh + s1 + ch + sha_256_k[i] + w[i];
+		const uint32_t s0 = right_rot(a, 2) ^ right_rot(a, 13) ^ right_rot(a, 22);
+		const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+		const uint32_t temp2 = s0 + maj;
+
+		hh = g; g = f; f = e; e = d + temp1;
+		d = c; c = b; b = a; a = temp1 + temp2;
+	}
+
+	h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+	h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+}
+
+/*
+ * Runs the compression function on one 512-bit block given as 16 big-endian words,
+ * updating the hash state h in place.
+ */
+void sha_256_compress(uint32_t h[8], const uint32_t block[16])
+{
+	sha_256_compress_from(h, h, block, 0);
+}
+
+/*
+ * Builds the single padded block of a message of at most SHA_256_MAX_SINGLE_BLOCK bytes
+ * directly as big-endian words: the message bytes, the 0x80 terminator, zeroes, and the
+ * bit length in the last word (the high length word is always zero for such messages).
+ */
+void sha_256_single_block_words(uint32_t block[16], const void *input, size_t len)
+{
+	const uint8_t *p = input;
+	size_t i;
+
+	memset(block, 0x00, 16 * sizeof(uint32_t));
+	for (i = 0; i < len; i++)
+		block[i >> 2] |= (uint32_t) p[i] << (24 - 8 * (i & 3));
+	block[len >> 2] |= (uint32_t) 0x80 << (24 - 8 * (len & 3));
+	block[15] = (uint32_t) (len << 3);
+}
+
+void sha_256_single_block(uint32_t digest[8], const void *input, size_t len)
+{
+	uint32_t block[16];
+	int i;
+
+	sha_256_single_block_words(block, input, len);
+	for (i = 0; i < 8; i++)
+		digest[i] = sha_256_h0[i];
+	sha_256_compress(digest, block);
+}
+
+void sha_256_words(uint32_t digest[8], const void *input, size_t len)
+{
+	uint8_t hash[32];
+	int i;
+
+	if (len <= SHA_256_MAX_SINGLE_BLOCK) {
+		sha_256_single_block(digest, input, len);
+		return;
+	}
+	calc_sha_256(hash, input, len);
+	for (i = 0; i < 8; i++)
+		digest[i] = (uint32_t) hash[i * 4] << 24 | (uint32_t) hash[i * 4 + 1] << 16 |
+			(uint32_t) hash[i * 4 + 2] << 8 | (uint32_t) hash[i * 4 + 3];
+}
+
+void sha_256_prefix_init(struct sha_256_prefix *prefix, const void *input, size_t len)
+{
+	const uint8_t *p = input;
+	size_t i;
+
+	memcpy(prefix->h, sha_256_h0, sizeof prefix->h);
+	prefix->total = len;
+
+	/* Absorb every complete 64-byte block of the prefix. */
+	while (len >= CHUNK_SIZE) {
+		for (i = 0; i < 16; i++)
+			prefix->block[i] = (uint32_t) p[i * 4] << 24 | (uint32_t) p[i * 4 + 1] << 16 |
+				(uint32_t) p[i * 4 + 2] << 8 | (uint32_t) p[i * 4 + 3];
+		sha_256_compress(prefix->h, prefix->block);
+		p += CHUNK_SIZE;
+		len -= CHUNK_SIZE;
+	}
+
+	/* Keep the rest as the head of the last block and run the rounds its complete words fix. */
+	memset(prefix->block, 0x00, sizeof prefix->block);
+	for (i = 0; i < len; i++)
+		prefix->block[i >> 2] |= (uint32_t) p[i] << (24 - 8 * (i & 3));
+	prefix->partial = len;
+	prefix->rounds = (int) (len >> 2);
+	memcpy(prefix->work, prefix->h, sizeof prefix->work);
+	sha_256_rounds(prefix->work, prefix->block, prefix->rounds);
+}
+
+int sha_256_prefix_block(const struct sha_256_prefix *prefix, uint32_t block[16], const void *tail, size_t len)
+{
+	const uint8_t *p = tail;
+	size_t at = prefix->partial;
+	uint64_t bits;
+	size_t i;
+
+	if (at + len > SHA_256_MAX_SINGLE_BLOCK)
+		return 0;
+
+	memcpy(block, prefix->block, 16 * sizeof(uint32_t));
+	for (i = 0; i < len; i++, at++)
+		block[at >> 2] |= (uint32_t) p[i] << (24 - 8 * (at & 3));
+	block[at >> 2] |= (uint32_t) 0x80 << (24 - 8 * (at & 3));
+	bits = (prefix->total + len) << 3;
+	block[14] = (uint32_t) (bits >> 32);
+	block[15] = (uint32_t) bits;
+	return 1;
+}
+
+void sha_256_prefix_finish(const struct sha_256_prefix *prefix, uint32_t digest[8], const void *tail, size_t len)
+{
+	const uint8_t *p = tail;
+	uint32_t block[16];
+	uint8_t chunk[CHUNK_SIZE];
+	size_t at, i;
+	uint64_t bits;
+
+	memcpy(digest, prefix->h, 8 * sizeof(uint32_t));
+
+	/* Common case: the tail fits the last block, resume after the precomputed rounds. */
+	if (sha_256_prefix_block(prefix, block, tail, len)) {
+		sha_256_compress_from(digest, prefix->work, block, prefix->rounds);
+		return;
+	}
+
+	/* Otherwise stream the prefix head and the tail through as many blocks as needed. */
+	for (at = 0; at < prefix->partial; at++)
+		chunk[at] = (uint8_t) (prefix->block[at >> 2] >> (24 - 8 * (at & 3)));
+	bits = (prefix->total + len) << 3;
+	for (;;) {
+		while (at < CHUNK_SIZE && len > 0) {
+			chunk[at++] = *p++;
+			len--;
+		}
+		if (at == CHUNK_SIZE) {
+			for (i = 0; i < 16; i++)
+				block[i] = (uint32_t) chunk[i * 4] << 24 | (uint32_t) chunk[i * 4 + 1] << 16 |
+					(uint32_t) chunk[i * 4 + 2] << 8 | (uint32_t) chunk[i * 4 + 3];
+			sha_256_compress(digest, block);
+			at = 0;
+			continue;
+		}
+		break;
+	}
+
+	/* Terminator, then the length either in this block or in one more. */
+	chunk[at++] = 0x80;
+	if (at > CHUNK_SIZE - TOTAL_LEN_LEN) {
+		memset(chunk + at, 0x00, CHUNK_SIZE - at);
+		for (i = 0; i < 16; i++)
+			block[i] = (uint32_t) chunk[i * 4] << 24 | (uint32_t) chunk[i * 4 + 1] << 16 |
+				(uint32_t) chunk[i * 4 + 2] << 8 | (uint32_t) chunk[i * 4 + 3];
+		sha_256_compress(digest, block);
+		at = 0;
+	}
+	memset(chunk + at, 0x00, CHUNK_SIZE - at);
+	for (i = 0; i < 14; i++)
+		block[i] = (uint32_t) chunk[i * 4] << 24 | (uint32_t) chunk[i * 4 + 1] << 16 |
+			(uint32_t) chunk[i * 4 + 2] << 8 | (uint32_t) chunk[i * 4 + 3];
+	block[14] = (uint32_t) (bits >> 32);
+	block[15] = (uint32_t) bits;
+	sha_256_compress(digest, block);
+}
+
 void sha_256_string(char string[65], const void *input, size_t len)
 {
         uint8_t hash[32];
@@ -1,5 +1,14 @@
 #ifndef __SHA256_H
 #define __SHA256_H
+#include <stdint.h>
+#include <stddef.h>
+
+/* Longest message that still fits a single padded 512-bit block (64 - 1 - 8 bytes). */
+#define SHA_256_MAX_SINGLE_BLOCK 55
+
+/* Round constants and initial hash values, shared with the multi-lane kernels. */
+extern const uint32_t sha_256_k[64];
+extern const uint32_t sha_256_h0[8];
 
 void calc_sha_256(uint8_t hash[32], const void *input, size_t len);
 
@@ -13,4 +22,107 @@ void calc_sha_256(uint8_t hash[32], const void *input, size_t len);
  */
 void sha_256_string(char string[65], const void *input, size_t len);
 
+/*
+ * Work shared by every message that starts with the same prefix: the state after the
+ * complete 64-byte blocks of the prefix, the rest of the prefix as the head of the last
+ * block, and the working variables after the rounds that only depend on that head
+ * (one round per complete 32-bit word of it).
+ */
+struct sha_256_prefix {
+	uint32_t h[8];
+	uint32_t work[8];
+	uint32_t block[16];
+	size_t partial;
+	uint64_t total;
+	int rounds;
+};
+
+/*****************************************************************************************
+ * Runs the SHA-256 compression function on a single 512-bit block
+ * @params h: the eight 32-bit words of hash state, updated in place
+ * @params block: the block to compress, as 16 big-endian 32-bit words
+ ******************************************************************************************
+ */
+void sha_256_compress(uint32_t h[8], const uint32_t block[16]);
+
+/*****************************************************************************************
+ * Runs the first rounds of a compression, which only read the first `count` block words
+ * @params work: the working variables, initialized to the hash state and updated in place
+ * @params block: the block being compressed, only words 0..count-1 are read
+ * @params count: the number of rounds to run, at most 16
+ ******************************************************************************************
+ */
+void sha_256_rounds(uint32_t work[8], const uint32_t block[16], int count);
+
+/*****************************************************************************************
+ * Finishes a compression started with sha_256_rounds
+ * @params h: the eight 32-bit words of hash state, updated in place
+ * @params work: the working variables after the first `first` rounds
+ * @params block: the complete block, which must agree with the words used for those rounds
+ * @params first: the number of rounds already run
+ ******************************************************************************************
+ */
+void sha_256_compress_from(uint32_t h[8], const uint32_t work[8], const uint32_t block[16], int first);
+
+/*****************************************************************************************
+ * Builds the padded block of a message of at most SHA_256_MAX_SINGLE_BLOCK bytes
+ * @params block: receives the padded block as 16 big-endian 32-bit words
+ * @params input: an array of bytes in which the message is contained
+ * @params len: the number of bytes of input, at most SHA_256_MAX_SINGLE_BLOCK
+ ******************************************************************************************
+ */
+void sha_256_single_block_words(uint32_t block[16], const void *input, size_t len);
+
+/*****************************************************************************************
+ * Fast path for messages of at most SHA_256_MAX_SINGLE_BLOCK bytes: the padded block is
+ * built directly and compressed once, skipping the general chunking state machine
+ * @params digest: receives the hash as eight 32-bit words (big-endian word order), which
+ *                 can be compared against decoded targets one word at a time
+ * @params input: an array of bytes in which the input of the hash is contained
+ * @params len: the number of bytes of input, at most SHA_256_MAX_SINGLE_BLOCK
+ ******************************************************************************************
+ */
+void sha_256_single_block(uint32_t digest[8], const void *input, size_t len);
+
+/*****************************************************************************************
+ * Computes the sha-256 hash of input as eight 32-bit words, using the single-block fast
+ * path for short messages and calc_sha_256 for longer ones
+ * @params digest: receives the hash as eight 32-bit words (big-endian word order)
+ * @params input: an array of bytes in which the input of the hash is contained
+ * @params len: an integer containing the number of bytes of input to hash
+ ******************************************************************************************
+ */
+void sha_256_words(uint32_t digest[8], const void *input, size_t len);
+
+/*****************************************************************************************
+ * Precomputes the work shared by every message starting with the given prefix
+ * @params prefix: receives the precomputed state
+ * @params input: an array of bytes in which the prefix is contained
+ * @params len: the number of bytes of prefix, of any length
+ ******************************************************************************************
+ */
+void sha_256_prefix_init(struct sha_256_prefix *prefix, const void *input, size_t len);
+
+/*****************************************************************************************
+ * Builds the padded last block of prefix + tail when it fits in a single block
+ * @params prefix: the precomputed prefix
+ * @params block: receives the last block as 16 big-endian 32-bit words
+ * @params tail: an array of bytes in which the tail is contained
+ * @params len: the number of bytes of tail
+ * @return 1 if the block was built, 0 if prefix + tail needs more than one more block
+ ******************************************************************************************
+ */
+int sha_256_prefix_block(const struct sha_256_prefix *prefix, uint32_t block[16], const void *tail, size_t len);
+
+/*****************************************************************************************
+ * Computes the sha-256 hash of prefix + tail, skipping the rounds precomputed in prefix
+ * when the tail fits in the last block
+ * @params prefix: the precomputed prefix
+ * @params digest: receives the hash as eight 32-bit words (big-endian word order)
+ * @params tail: an array of bytes in which the tail is contained
+ * @params len: the number of bytes of tail, of any length
+ ******************************************************************************************
+ */
+void sha_256_prefix_finish(const struct sha_256_prefix *prefix, uint32_t digest[8], const void *tail, size_t len);
+
 #endif
@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "sha-512.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHA_512_X86 1
+#endif
+
+/* A kernel compresses n independent (state, block) pairs in place. */
+typedef void (*compress_fn)(uint64_t (*state)[8], const uint64_t (*block)[16], int n);
+
+/* Round constants, the first 64 bits of the fractional parts of the cube roots of the first 80 primes. */
+static const uint64_t sha_512_k[80] = {
+	0x428a2f98d728ae22ull, 0x7137449123ef65cdull, 0xb5c0fbcfec4d3b2full, 0xe9b5dba58189dbbcull,
+	0x3956c25bf348b538ull, 0x59f111f1b605d019ull, 0x923f82a4af194f9bull, 0xab1c5ed5da6d8118ull,
+	0xd807aa98a3030242ull, 0x12835b0145706fbeull, 0x243185be4ee4b28cull, 0x550c7dc3d5ffb4e2ull,
+	0x72be5d74f27b896full, 0x80deb1fe3b1696b1ull, 0x9bdc06a725c71235ull, 0xc19bf174cf692694ull,
+	0xe49b69c19ef14ad2ull, 0xefbe4786384f25e3ull, 0x0fc19dc68b8cd5b5ull, 0x240ca1cc77ac9c65ull,
+	0x2de92c6f592b0275ull, 0x4a7484aa6ea6e483ull, 0x5cb0a9dcbd41fbd4ull, 0x76f988da831153b5ull,
+	0x983e5152ee66dfabull, 0xa831c66d2db43210ull, 0xb00327c898fb213full, 0xbf597fc7beef0ee4ull,
+	0xc6e00bf33da88fc2ull, 0xd5a79147930aa725ull, 0x06ca6351e003826full, 0x142929670a0e6e70ull,
+	0x27b70a8546d22ffcull, 0x2e1b21385c26c926ull, 0x4d2c6dfc5ac42aedull, 0x53380d139d95b3dfull,
+	0x650a73548baf63deull, 0x766a0abb3c77b2a8ull, 0x81c2c92e47edaee6ull, 0x92722c851482353bull,
+	0xa2bfe8a14cf10364ull, 0xa81a664bbc423001ull, 0xc24b8b70d0f89791ull, 0xc76c51a30654be30ull,
+	0xd192e819d6ef5218ull, 0xd69906245565a910ull, 0xf40e35855771202aull, 0x106aa07032bbd1b8ull,
+	0x19a4c116b8d2d0c8ull, 0x1e376c085141ab53ull, 0x2748774cdf8eeb99ull, 0x34b0bcb5e19b48a8ull,
+	0x391c0cb3c5c95a63ull, 0x4ed8aa4ae3418acbull, 0x5b9cca4f7763e373ull, 0x682e6ff3d6b2b8a3ull,
+	0x748f82ee5defb2fcull, 0x78a5636f43172f60ull, 0x84c87814a1f0ab72ull, 0x8cc702081a6439ecull,
+	0x90befffa23631e28ull, 0xa4506cebde82bde9ull, 0xbef9a3f7b2c67915ull, 0xc67178f2e372532bull,
+	0xca273eceea26619cull, 0xd186b8c721c0c207ull, 0xeada7dd6cde0eb1eull, 0xf57d4f7fee6ed178ull,
+	0x06f067aa72176fbaull, 0x0a637dc5a2c898a6ull, 0x113f9804bef90daeull, 0x1b710b35131c471bull,
+	0x28db77f523047d84ull, 0x32caab7b40c72493ull, 0x3c9ebe0a15c9bebcull, 0x431d67c49c100d4cull,
+	0x4cc5d4becb3e42b6ull, 0x597f299cfc657e2aull, 0x5fcb6fab3ad6faecull, 0x6c44198c4a475817ull,
+};
+
+/* Initial hash values, the first 64 bits of the fractional parts of the square roots of the first 8 primes. */
+static const uint64_t sha_512_h0[8] = {
+	0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull, 0x3c6ef372fe94f82bull, 0xa54ff53a5f1d36f1ull,
+	0x510e527fade682d1ull, 0x9b05688c2b3e6c1full, 0x1f83d9abfb41bd6bull, 0x5be0cd19137e2179ull,
+};
+
+/*
+ * Scalar: the template with a single lane of plain 64-bit words, also used for the
+ * blocks of long messages.
+ */
+#define LANES_FN compress_scalar
+#define LANES_ATTR
+#define LANES 1
+#define VEC uint64_t
+#define V_ADD(a, b) ((a) + (b))
+#define V_XOR3(a, b, c) ((a) ^ (b) ^ (c))
+#define V_SRL(x, n) ((x) >> (n))
+#define V_ROR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+#define V_CH(e, f, g) (((e) & (f)) ^ (~(e) & (g)))
+#define V_MAJ(a, b, c) (((a) & (b)) | ((c) & ((a) | (b))))
+#define V_SET1(x) ((uint64_t) (x))
+#define V_LOAD(p) (*(p))
+#define V_STORE(p, x) (*(p) = (x))
+#include "sha-512-lanes.inc"
+#undef LANES_FN
+#undef LANES_ATTR
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR3
+#undef V_SRL
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+#ifdef SHA_512_X86
+
+/*
+ * AVX2, 4 lanes.
+ */
+#define LANES_FN compress_avx2
+#define LANES_ATTR __attribute__((target("avx2")))
+#define LANES 4
+#define VEC __m256i
+#define V_ADD(a, b) _mm256_add_epi64(a, b)
+#define V_XOR3(a, b, c) _mm256_xor_si256(_mm256_xor_si256(a, b), c)
+#define V_SRL(x, n) _mm256_srli_epi64(x, n)
+#define V_ROR(x, n) _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+#define V_CH(e, f, g) _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g))
+#define V_MAJ(a, b, c) _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)))
+#define V_SET1(x) _mm256_set1_epi64x((long long) (x))
+#define V_LOAD(p) _mm256_load_si256((const __m256i *) (p))
+#define V_STORE(p, x) _mm256_store_si256((__m256i *) (p), x)
+#include "sha-512-lanes.inc"
+#undef LANES_FN
+#undef LANES_ATTR
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR3
+#undef V_SRL
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+/*
+ * AVX-512, 8 lanes. Rotates and the three-input boolean functions map to single instructions.
+ */
+#define LANES_FN compress_avx512
+#define LANES_ATTR __attribute__((target("avx512f")))
+#define LANES 8
+#define VEC __m512i
+#define V_ADD(a, b) _mm512_add_epi64(a, b)
+#define V_XOR3(a, b, c) _mm512_ternarylogic_epi64(a, b, c, 0x96)
+#define V_SRL(x, n) _mm512_srli_epi64(x, n)
+#define V_ROR(x, n) _mm512_ror_epi64(x, n)
+#define V_CH(e, f, g) _mm512_ternarylogic_epi64(e, f, g, 0xca)
+#define V_MAJ(a, b, c) _mm512_ternarylogic_epi64(a, b, c, 0xe8)
+#define V_SET1(x) _mm512_set1_epi64((long long) (x))
+#define V_LOAD(p) _mm512_load_si512((const void *) (p))
+#define V_STORE(p, x) _mm512_store_si512((void *) (p), x)
+#include "sha-512-lanes.inc"
+#undef LANES_FN
+#undef LANES_ATTR
+#undef LANES
+#undef VEC
+#undef V_ADD
+#undef V_XOR3
+#undef V_SRL
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+
+#endif
+
+/* Candidate kernels, in the order they are measured. */
+struct engine {
+	const char *name;
+	int lanes;
+	compress_fn compress;
+};
+
+static struct engine selected = { "scalar", 1, compress_scalar };
+
+/* Read 128 bytes as sixteen big-endian 64-bit words. */
+static void load_block(uint64_t block[16], const uint8_t *p)
+{
+	int i, j;
+
+	for (i = 0; i < 16; i++) {
+		block[i] = 0;
+		for (j = 0; j < 8; j++)
+			block[i] = block[i] << 8 | *p++;
+	}
+}
+
+/* Pad a message of at most SHA_512_MAX_SINGLE_BLOCK bytes into a block. */
+static void single_block(uint64_t block[16], const char *msg, size_t len)
+{
+	size_t i;
+
+	memset(block, 0, 128);
+	for (i = 0; i < len; i++)
+		block[i >> 3] |= (uint64_t) (uint8_t) msg[i] << (56 - 8 * (i & 7));
+	block[len >> 3] |= 0x80ull << (56 - 8 * (len & 7));
+	block[15] = (uint64_t) len << 3;
+}
+
+/* Hash a message of any length one block at a time with the scalar kernel. */
+static void hash_long(uint64_t state[8], const uint8_t *msg, size_t len)
+{
+	uint8_t last[256];
+	uint64_t block[16];
+	uint64_t bits = (uint64_t) len * 8;
+	size_t done, rest, size, i;
+
+	for (done = 0; len - done >= 128; done += 128) {
+		load_block(block, msg + done);
+		compress_scalar((uint64_t (*)[8]) state, (const uint64_t (*)[16]) block, 1);
+	}
+
+	/* The padding and the 128-bit length take one more block, or two if the rest leaves no room. */
+	rest = len - done;
+	size = rest <= SHA_512_MAX_SINGLE_BLOCK ? 128 : 256;
+	memset(last, 0, size);
+	memcpy(last, msg + done, rest);
+	last[rest] = 0x80;
+	for (i = 0; i < 8; i++)
+		last[size - 1 - i] = (uint8_t) (bits >> (8 * i));
+	for (i = 0; i < size; i += 128) {
+		load_block(block, last + i);
+		compress_scalar((uint64_t (*)[8]) state, (const uint64_t (*)[16]) block, 1);
+	}
+}
+
+/* Write a state as sixteen big-endian 32-bit digest words. */
+static void to_digest(const uint64_t state[8], uint32_t *digest)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		digest[2 * i] = (uint32_t) (state[i] >> 32);
+		digest[2 * i + 1] = (uint32_t) state[i];
+	}
+}
+
+void sha_512_batch(const char *const *msgs, const size_t *lens, int n, uint32_t *digests)
+{
+	uint64_t blocks[16][16];
+	uint64_t states[16][8];
+	int index[16];
+	int count = 0;
+	int i;
+
+	/* Pad every short message into its own block, hash long ones directly. */
+	for (i = 0; i < n; i++) {
+		if (lens[i] > SHA_512_MAX_SINGLE_BLOCK) {
+			uint64_t state[8];
+
+			memcpy(state, sha_512_h0, sizeof state);
+			hash_long(state, (const uint8_t *) msgs[i], lens[i]);
+			to_digest(state, digests + i * 16);
+			continue;
+		}
+		single_block(blocks[count], msgs[i], lens[i]);
+		memcpy(states[count], sha_512_h0, sizeof states[count]);
+		index[count++] = i;
+	}
+	if (count == 0)
+		return;
+
+	selected.compress(states, (const uint64_t (*)[16]) blocks, count);
+	for (i = 0; i < count; i++)
+		to_digest(states[i], digests + index[i] * 16);
+}
+
+/* Seconds spent by kernel e compressing a fixed synthetic batch. */
+static double measure(const struct engine *e)
+{
+	enum { BLOCKS = 1024, ROUNDS = 4 };
+	static uint64_t states[BLOCKS][8];
+	static uint64_t blocks[BLOCKS][16];
+	struct timespec start, end;
+	int i, j;
+
+	for (i = 0; i < BLOCKS; i++) {
+		for (j = 0; j < 16; j++)
+			blocks[i][j] = (uint64_t) (i * 16 + j) * 0x9e3779b97f4a7c15ull;
+		memcpy(states[i], sha_512_h0, sizeof states[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < ROUNDS; i++)
+		e->compress(states, (const uint64_t (*)[16]) blocks, BLOCKS);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void sha_512_engine_init()
+{
+	struct engine candidates[3];
+	int count = 0;
+	double best, t;
+	int i;
+
+	candidates[count].name = "scalar";
+	candidates[count].lanes = 1;
+	candidates[count++].compress = compress_scalar;
+
+#ifdef SHA_512_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		candidates[count].name = "avx2";
+		candidates[count].lanes = 4;
+		candidates[count++].compress = compress_avx2;
+	}
+	if (__builtin_cpu_supports("avx512f")) {
+		candidates[count].name = "avx512";
+		candidates[count].lanes = 8;
+		candidates[count++].compress = compress_avx512;
+	}
+#endif
+
+	/* Keep the fastest kernel; the first pass of each also warms up its code and data. */
+	selected = candidates[0];
+	best = measure(&candidates[0]);
+	for (i = 1; i < count; i++) {
+		measure(&candidates[i]);
+		t = measure(&candidates[i]);
+		if (t < best) {
+			best = t;
+			selected = candidates[i];
+		}
+	}
+}
+
+const char *sha_512_engine_name()
+{
+	return selected.name;
+}
+
+int sha_512_engine_lanes()
+{
+	return selected.lanes;
+}
@@ -0,0 +1,60 @@
+/** sha-512.h
+ * This file contains the declarations of the SHA-512 kernels selected with
+ * `--hash-type sha512` (see hash.h). SHA-512 works on 128-byte blocks of 64-bit words, so
+ * every candidate of up to SHA_512_MAX_SINGLE_BLOCK bytes, which covers every word the
+ * program generates, is a single block. Like the SHA-256 engine (see sha-256-simd.h),
+ * the engine pads a batch of candidates into single blocks and compresses them together
+ * with the widest kernel the CPU supports:
+ * - AVX-512: 8 lanes of 64-bit words per instruction.
+ * - AVX2: 4 lanes.
+ * - scalar: one message at a time, which 64-bit registers already make fast.
+ *
+ * Digests are returned as sixteen big-endian 32-bit words, the most significant half of
+ * every state word first, so the target set handles them like the other digests.
+ *
+ * The main components of this file include:
+ * - sha_512_engine_init(): Selects the fastest kernel.
+ * - sha_512_batch(): Hashes a batch of candidates.
+ */
+
+#ifndef __SHA512_H
+#define __SHA512_H
+#include <stdint.h>
+#include <stddef.h>
+
+/* Longest message that still fits a single padded 1024-bit block (128 - 1 - 16 bytes). */
+#define SHA_512_MAX_SINGLE_BLOCK 111
+/* Widest batch any kernel processes in a single pass. */
+#define SHA_512_MAX_LANES 8
+
+/** sha_512_engine_init()
+ * This function detects the instruction sets supported by the CPU, measures the
+ * throughput of every usable kernel and selects the fastest one. It must be called once
+ * by main before any thread is created.
+ */
+void sha_512_engine_init();
+
+/** sha_512_engine_name()
+ * @return const char* Name of the selected kernel (e.g. "avx2").
+ */
+const char* sha_512_engine_name();
+
+/** sha_512_engine_lanes()
+ * @return int Number of candidates the selected kernel hashes per pass.
+ */
+int sha_512_engine_lanes();
+
+/** sha_512_batch()
+ * This function hashes `n` independent messages. Messages of at most
+ * SHA_512_MAX_SINGLE_BLOCK bytes are padded into single blocks and compressed together
+ * by the selected kernel, in passes of its width; longer ones are hashed one block at
+ * a time.
+ *
+ * @param msgs Array of `n` pointers to the messages.
+ * @param lens Array of `n` message lengths in bytes.
+ * @param n Number of messages, at most 16.
+ * @param digests Receives `n` digests of sixteen 32-bit words each, one after the other.
+ */
+void sha_512_batch(const char* const*, const size_t*, int, uint32_t*);
+
+#endif
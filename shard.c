@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "shard.h"
+#include "dictionary.h"
+#include "hash.h"
+#include "mask.h"
+#include "targets.h"
+#include "global.h"
+
+void shard_dictionary(const Dictionary* dict, Dictionary* slice) {
+    *slice = *dict;
+    if (OPTIONS.numShards <= 1) {
+        return;
+    }
+    // the same newline-aligned split as between producers, so it only depends on the file
+    DictRange* shards = malloc(OPTIONS.numShards * sizeof(DictRange));
+    split_dictionary(dict, OPTIONS.numShards, shards);
+    slice->data = shards[OPTIONS.shardIndex].cursor;
+    slice->size = shards[OPTIONS.shardIndex].end - shards[OPTIONS.shardIndex].cursor;
+    free(shards);
+}
+
+void shard_keyspace(uint64_t* start, uint64_t* end) {
+    uint64_t n = OPTIONS.numShards;
+    uint64_t i = OPTIONS.shardIndex;
+    // the first keyspace % n shards take one index more
+    uint64_t extra = MASK.keyspace % n;
+    *start = MASK.keyspace / n * i + (i < extra ? i : extra);
+    *end = *start + MASK.keyspace / n + (i < extra ? 1 : 0);
+}
+
+// length of the key of an output line, the hash and the field after it: the salt of a
+// hash:salt:password line, or the password of a hash:password line, which is the same
+// whichever shard cracked the hash
+static int key_length(const char* line) {
+    int hexLength = strcspn(line, ":");
+    if (line[hexLength] == '\0') {
+        return hexLength;
+    }
+    return hexLength + 1 + strcspn(line + hexLength + 1, ":");
+}
+
+// order output lines by their key, so a target cracked by several shards is written once
+// and salted targets of the same hash are all kept
+static int compare_lines(const void* a, const void* b) {
+    const char* x = *(char* const*)a;
+    const char* y = *(char* const*)b;
+    int lenX = key_length(x), lenY = key_length(y);
+    int length = lenX < lenY ? lenX : lenY;
+    int order = strncmp(x, y, length);
+    // the ':' ending the shorter key is compared as a character, so lines are in the
+    // order of `LC_ALL=C sort`
+    return order != 0 || lenX == lenY ? order : (unsigned char)x[length] - (unsigned char)y[length];
+}
+
+int merge_shards(int numFiles, char** files) {
+    if (numFiles < 2) {
+        printf("usage: cracker --merge <merged_file> <shard_output_file>...\n");
+        return 1;
+    }
+    char** lines = NULL;
+    int numLines = 0, capacity = 0;
+    char line[MAX_TARGET_TEXT + MAX_WORD_LENGTH + 2];
+
+    // read every hash:password and hash:salt:password line of every shard
+    for (int f = 1; f < numFiles; f++) {
+        FILE* file = fopen(files[f], "r");
+        if (file == NULL) {
+            printf("error: '%s' is an invalid file\n", files[f]);
+            return 1;
+        }
+        while (fgets(line, sizeof(line), file) != NULL) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] == '\0') {
+                continue;
+            }
+            // the merge does not know the hash type, any digest size of --hash-type is valid
+            int hexLength = strspn(line, "0123456789abcdef");
+            if (!is_hash_length(hexLength) || line[hexLength] != ':') {
+                printf("warning: skipping invalid line in '%s': %s\n", files[f], line);
+                continue;
+            }
+            if (numLines == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                lines = realloc(lines, capacity * sizeof(char*));
+            }
+            lines[numLines++] = strdup(line);
+        }
+        fclose(file);
+    }
+
+    FILE* merged = fopen(files[0], "w");
+    if (merged == NULL) {
+        printf("error: failed to open '%s'\n", files[0]);
+        return 1;
+    }
+    // sort by key and keep the first line of every target
+    qsort(lines, numLines, sizeof(char*), compare_lines);
+    int numHashes = 0;
+    for (int i = 0; i < numLines; i++) {
+        if (i == 0 || compare_lines(&lines[i - 1], &lines[i]) != 0) {
+            fprintf(merged, "%s\n", lines[i]);
+            numHashes++;
+        }
+    }
+    fclose(merged);
+    printf("merged:   %d cracked hashes from %d files into %s\n", numHashes, numFiles - 1, files[0]);
+
+    for (int i = 0; i < numLines; i++) {
+        free(lines[i]);
+    }
+    free(lines);
+    return 0;
+}
@@ -0,0 +1,52 @@
+/** shard.h
+ * This file contains the declarations used to spread one job over several machines with
+ * `--shard i/N`. Every process of the job runs the same command with its own shard
+ * number, and takes a disjoint slice of the work computed from the command alone, so no
+ * coordination is needed: the dictionary is split into N newline-aligned byte ranges
+ * exactly as it would be split between N producers, and a mask's keyspace into N index
+ * ranges. Shard i takes the i-th slice and splits it further between its own threads.
+ * The per-shard output files are then combined with `--merge`.
+ *
+ * The main components of this file include:
+ * - shard_dictionary(): Returns the slice of the dictionary of this process's shard.
+ * - shard_keyspace(): Returns the slice of the mask keyspace of this process's shard.
+ * - merge_shards(): Merges the output files of several shards into one.
+ */
+
+#ifndef __SHARD__
+#define __SHARD__
+#include <stdint.h>
+#include "dictionary.h"
+
+/** shard_dictionary()
+ * This function returns the newline-aligned slice of the dictionary assigned to the
+ * shard in `OPTIONS`, the whole dictionary when the job is not sharded.
+ *
+ * @param dict The mapped dictionary.
+ * @param slice Receives the slice, which starts at the beginning of a line.
+ */
+void shard_dictionary(const Dictionary*, Dictionary*);
+
+/** shard_keyspace()
+ * This function returns the range of mask keyspace indices assigned to the shard in
+ * `OPTIONS`, the whole keyspace when the job is not sharded.
+ *
+ * @param start Receives the first index of the range.
+ * @param end Receives one past the last index of the range.
+ */
+void shard_keyspace(uint64_t*, uint64_t*);
+
+/** merge_shards()
+ * This function merges the output files of the shards of a job into one file. Every
+ * hash:password (hash:salt:password for a target with a salt) line is kept once, targets
+ * cracked by several shards are only written once, and the lines are sorted by hash and
+ * salt, so the result does not depend on how the work was split. Lines that do not start
+ * with a hash and ':' are reported and skipped.
+ *
+ * @param numFiles Number of files in `files`.
+ * @param files The merged output file, followed by the output file of every shard.
+ * @return int 0 on success, 1 if a file cannot be opened.
+ */
+int merge_shards(int, char**);
+
+#endif
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "sink.h"
+#include "potfile.h"
+#include "checkpoint.h"
+#include "targets.h"
+#include "global.h"
+
+/** Hit
+ * One queued hit, or a marker queued by sink_sync() when `outfile` is NULL.
+ */
+typedef struct Hit {
+    _Atomic(struct Hit*) next;         // Hit queued after this one, NULL until it is linked
+    FILE* outfile;                     // Output file of the hit, NULL for a marker
+    int index;                         // Index of the cracked target in `TARGETS`
+    char word[MAX_WORD_LENGTH];        // The password, terminated
+    int reached;                       // Flag set once the writer reaches a marker
+} Hit;
+
+// the queue and the state of the writer thread
+static struct {
+    _Atomic(Hit*) head;          // Last hit queued, swapped in by every thread that queues one
+    Hit* tail;                   // Next hit to write, only used by the writer
+    Hit stub;                    // Placeholder keeping the queue non-empty
+    atomic_int stopping;         // Flag set by finish_sink() once no hit can be queued
+    int running;                 // Flag set while the writer takes markers
+    pthread_mutex_t mutex;       // Mutex protecting `running` and the flags of the markers
+    pthread_cond_t reached;      // Signaled when the writer reaches a marker
+    pthread_t thread;            // Thread of the writer
+} sink = { .mutex = PTHREAD_MUTEX_INITIALIZER, .reached = PTHREAD_COND_INITIALIZER };
+
+// link a hit at the head of the queue, wait-free for any number of threads
+static void push(Hit* hit) {
+    atomic_store_explicit(&hit->next, NULL, memory_order_relaxed);
+    Hit* previous = atomic_exchange_explicit(&sink.head, hit, memory_order_acq_rel);
+    // until this store the hit is queued but not reachable, the writer waits for it
+    atomic_store_explicit(&previous->next, hit, memory_order_release);
+}
+
+// unlink the hit at the tail of the queue, returns NULL if there is none or the next one
+// is still being linked
+static Hit* pop() {
+    Hit* tail = sink.tail;
+    Hit* next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (tail == &sink.stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        sink.tail = tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+    if (next != NULL) {
+        sink.tail = next;
+        return tail;
+    }
+    // the tail is the only hit left, put the stub behind it so it can be taken
+    if (tail != atomic_load_explicit(&sink.head, memory_order_acquire)) {
+        return NULL;
+    }
+    push(&sink.stub);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next != NULL) {
+        sink.tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+// flush a file as `--sync` asks, or always to the kernel for a checkpoint
+static void sync_file(FILE* file, int checkpoint) {
+    if (file == NULL || (OPTIONS.sync == SYNC_NONE && !checkpoint)) {
+        return;
+    }
+    fflush(file);
+    if (OPTIONS.sync == SYNC_FSYNC) {
+        fsync(fileno(file));
+    }
+}
+
+// write every hit that can be taken from the queue as one batch, returns their number
+static int drain() {
+    FILE* written = NULL;
+    int count = 0;
+    Hit* hit;
+    while ((hit = pop()) != NULL) {
+        // everything before a marker is written, flush it and wake the thread waiting
+        if (hit->outfile == NULL) {
+            sync_file(written, 1);
+            written = NULL;
+            pthread_mutex_lock(&sink.mutex);
+            hit->reached = 1;
+            pthread_cond_broadcast(&sink.reached);
+            pthread_mutex_unlock(&sink.mutex);
+            continue;
+        }
+        if (written != NULL && written != hit->outfile) {
+            sync_file(written, 0);
+        }
+        written = hit->outfile;
+
+        char target[MAX_TARGET_TEXT + 1];
+        target_to_text(hit->index, target);
+        fprintf(hit->outfile, "%s:%s\n", target, hit->word);
+        if (!OPTIONS.quiet) {
+            printf("%s:%s\n", target, hit->word);
+        }
+        // and record the hit for the next checkpoint and for later runs
+        checkpoint_cracked(target, hit->word);
+        potfile_add(target, hit->word);
+        free(hit);
+        count++;
+    }
+    sync_file(written, 0);
+    return count;
+}
+
+// write the queued hits in batches until the run is finished and the queue is empty
+static void* writer(void* arg) {
+    struct timespec interval = { 0, (long)(SINK_INTERVAL * 1e9) };
+    while (1) {
+        int stopping = atomic_load(&sink.stopping);
+        if (drain() == 0) {
+            if (stopping) {
+                break;
+            }
+            nanosleep(&interval, NULL);
+        }
+    }
+    // markers are queued under the mutex, so none is left once this is set
+    pthread_mutex_lock(&sink.mutex);
+    sink.running = 0;
+    pthread_mutex_unlock(&sink.mutex);
+    drain();
+    if (!OPTIONS.quiet) {
+        fflush(stdout);
+    }
+    return NULL;
+}
+
+void start_sink() {
+    atomic_init(&sink.stub.next, NULL);
+    atomic_init(&sink.head, &sink.stub);
+    sink.tail = &sink.stub;
+    atomic_init(&sink.stopping, 0);
+    pthread_mutex_lock(&sink.mutex);
+    sink.running = 1;
+    pthread_mutex_unlock(&sink.mutex);
+    pthread_create(&sink.thread, NULL, writer, NULL);
+}
+
+void finish_sink() {
+    atomic_store(&sink.stopping, 1);
+    pthread_join(sink.thread, NULL);
+}
+
+void output_to_file(FILE* outfile, int index, const char* word) {
+    Hit* hit = malloc(sizeof(Hit));
+    hit->outfile = outfile;
+    hit->index = index;
+    strcpy(hit->word, word);
+    push(hit);
+}
+
+void sink_sync() {
+    Hit marker;
+    marker.outfile = NULL;
+    marker.reached = 0;
+    pthread_mutex_lock(&sink.mutex);
+    if (sink.running) {
+        push(&marker);
+        while (!marker.reached) {
+            pthread_cond_wait(&sink.reached, &sink.mutex);
+        }
+    }
+    pthread_mutex_unlock(&sink.mutex);
+}
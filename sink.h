@@ -0,0 +1,68 @@
+/** sink.h
+ * This file contains the declarations of the result sink, which takes the writing of hits
+ * off the hashing threads. A thread that cracks a target only pushes the hit on a
+ * lock-free queue (a linked list whose producers each swap themselves in as its head with
+ * one atomic exchange), so a hit never waits for I/O or for any lock, however many hits
+ * per second the run finds. A dedicated writer thread drains the queue in batches: every
+ * hit of a batch is appended to the output file, echoed on standard output unless
+ * `--quiet` is given, recorded for the checkpoint and appended to the potfile (see
+ * potfile.h), and the output file is then flushed as `--sync` asks:
+ * - SYNC_FLUSH: flushed to the kernel after every batch, so hits survive the process.
+ * - SYNC_FSYNC: also written to disk with `fsync` after every batch, so they survive the
+ *   machine.
+ * - SYNC_NONE: left to the buffering of stdio until a checkpoint or the end of the run.
+ * When the queue is empty the writer sleeps SINK_INTERVAL seconds before looking again,
+ * so the hashing threads never have to wake it. The output file holds the hits of one
+ * run: main truncates it for a fresh run and only a `--resume` appends to it, since the
+ * hits that must outlive a run are kept in the potfile.
+ *
+ * A hit is pushed before its word is finished, and a checkpoint calls sink_sync() after
+ * reading the progress of the ranges, so every hit below the progress it saves is in the
+ * output file and in the list of the state file (see checkpoint.h).
+ *
+ * The main components of this file include:
+ * - start_sink()/finish_sink(): Run the writer thread, and drain and stop it.
+ * - output_to_file(): Queues a hit for the writer.
+ * - sink_sync(): Waits until every hit queued so far is written.
+ */
+
+#ifndef __SINK__
+#define __SINK__
+#include <stdio.h>
+
+// seconds the writer sleeps when it finds the queue empty
+#define SINK_INTERVAL 0.01
+
+/** start_sink()
+ * This function starts the writer thread. It must be called after start_checkpoints(),
+ * so the writer never receives the signals of the checkpoint thread, and before any
+ * hashing thread is created.
+ */
+void start_sink();
+
+/** finish_sink()
+ * This function writes the hits still queued, flushes the output files and stops the
+ * writer thread. It must be called once every hashing thread has been joined, and before
+ * finish_checkpoints().
+ */
+void finish_sink();
+
+/** output_to_file()
+ * This function queues a cracked target for the writer thread, which reports it as
+ * hash:password (hash:salt:password for a target with a salt) in the output file and on
+ * standard output. The password is copied, so the caller may reuse it at once. Any thread
+ * may call it, it never blocks.
+ *
+ * @param outfile The output file, opened once by main.
+ * @param index Index of the cracked target in `TARGETS`.
+ * @param word The password that produced the target hash.
+ */
+void output_to_file(FILE*, int, const char*);
+
+/** sink_sync()
+ * This function waits until the writer has written and flushed every hit queued before
+ * the call. It returns at once if the writer is not running.
+ */
+void sink_sync();
+
+#endif
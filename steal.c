@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "steal.h"
+#include "block.h"
+#include "metrics.h"
+#include "global.h"
+
+void init_work_queues(int numConsumers, int numProducers) {
+    // every admitted block fits in any one deque, plus one in-flight block per producer
+    int capacity = MAX_GLOBAL_BLOCKS + numProducers;
+
+    QUEUES.queues = aligned_alloc(64, numConsumers * sizeof(WorkQueue));
+    QUEUES.numQueues = numConsumers;
+    for (int i = 0; i < numConsumers; i++) {
+        WorkQueue* queue = &QUEUES.queues[i];
+        queue->blocks = malloc(capacity * sizeof(WordBlock*));
+        queue->head = queue->tail = queue->count = 0;
+        queue->capacity = capacity;
+        pthread_mutex_init(&queue->mutex, NULL);
+    }
+    atomic_init(&QUEUES.queued, 0);
+    atomic_init(&QUEUES.sleepingConsumers, 0);
+    atomic_init(&QUEUES.sleepingProducers, 0);
+}
+
+int push_block(WordBlock* block, int index) {
+    // wait while the scheduler is full; the count is checked without a lock, so up to one
+    // block per producer may overshoot, which the deque capacity allows for
+    if (atomic_load(&QUEUES.queued) >= MAX_GLOBAL_BLOCKS) {
+        pthread_mutex_lock(&BUFFER.mutex);
+        atomic_fetch_add(&QUEUES.sleepingProducers, 1);
+        while (atomic_load(&QUEUES.queued) >= MAX_GLOBAL_BLOCKS && !isFound) {
+            metrics_wait(&BUFFER.notFull, &BUFFER.mutex, METRIC_FULL_WAIT);
+        }
+        atomic_fetch_sub(&QUEUES.sleepingProducers, 1);
+        pthread_mutex_unlock(&BUFFER.mutex);
+    }
+    // consumers have cracked every target, nobody will take the block
+    if (isFound) {
+        release_block(block);
+        return 0;
+    }
+
+    // append the block to the back of the consumer's deque
+    WorkQueue* queue = &QUEUES.queues[index];
+    pthread_mutex_lock(&queue->mutex);
+    queue->blocks[queue->tail] = block;
+    queue->tail = (queue->tail + 1) % queue->capacity;
+    queue->count++;
+    atomic_fetch_add(&QUEUES.queued, 1);
+    pthread_mutex_unlock(&queue->mutex);
+
+    // only take the global mutex when a consumer is actually asleep, and wake just one
+    if (atomic_load(&QUEUES.sleepingConsumers) > 0) {
+        pthread_mutex_lock(&BUFFER.mutex);
+        pthread_cond_signal(&BUFFER.notEmpty);
+        pthread_mutex_unlock(&BUFFER.mutex);
+    }
+    return 1;
+}
+
+// pop a block from the front (own deque) or back (stolen) of a deque, NULL if it is empty
+static WordBlock* take_block(WorkQueue* queue, int steal) {
+    WordBlock* block = NULL;
+    pthread_mutex_lock(&queue->mutex);
+    if (queue->count > 0) {
+        if (steal) {
+            queue->tail = (queue->tail + queue->capacity - 1) % queue->capacity;
+            block = queue->blocks[queue->tail];
+        }
+        else {
+            block = queue->blocks[queue->head];
+            queue->head = (queue->head + 1) % queue->capacity;
+        }
+        queue->count--;
+        atomic_fetch_sub(&QUEUES.queued, 1);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return block;
+}
+
+WordBlock* steal_block(int index) {
+    int n = QUEUES.numQueues;
+
+    while (1) {
+        // own deque first, then every other deque starting with the next consumer
+        WordBlock* block = take_block(&QUEUES.queues[index], 0);
+        for (int i = 1; block == NULL && i < n; i++) {
+            block = take_block(&QUEUES.queues[(index + i) % n], 1);
+        }
+        if (block != NULL) {
+            // a slot was freed, wake one producer if any is waiting for it
+            if (atomic_load(&QUEUES.sleepingProducers) > 0) {
+                pthread_mutex_lock(&BUFFER.mutex);
+                pthread_cond_signal(&BUFFER.notFull);
+                pthread_mutex_unlock(&BUFFER.mutex);
+            }
+            return block;
+        }
+
+        // every deque is empty, sleep until a block is pushed or the run ends; the
+        // sleeper count is raised before rechecking, so a concurrent push always sees it
+        pthread_mutex_lock(&BUFFER.mutex);
+        atomic_fetch_add(&QUEUES.sleepingConsumers, 1);
+        while (atomic_load(&QUEUES.queued) == 0 && !isDone && !isFound) {
+            metrics_wait(&BUFFER.notEmpty, &BUFFER.mutex, METRIC_EMPTY_WAIT);
+        }
+        atomic_fetch_sub(&QUEUES.sleepingConsumers, 1);
+        int finished = isFound || (isDone && atomic_load(&QUEUES.queued) == 0);
+        pthread_mutex_unlock(&BUFFER.mutex);
+        if (finished) {
+            return NULL;
+        }
+    }
+}
+
+void free_work_queues() {
+    for (int i = 0; i < QUEUES.numQueues; i++) {
+        WorkQueue* queue = &QUEUES.queues[i];
+        // recycle blocks left queued by an early finish
+        while (queue->count > 0) {
+            release_block(queue->blocks[queue->head]);
+            queue->head = (queue->head + 1) % queue->capacity;
+            queue->count--;
+        }
+        pthread_mutex_destroy(&queue->mutex);
+        free(queue->blocks);
+    }
+    free(QUEUES.queues);
+    QUEUES.queues = NULL;
+    QUEUES.numQueues = 0;
+}
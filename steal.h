@@ -0,0 +1,94 @@
+/** steal.h
+ * This file contains the declarations of the work-stealing scheduler, the alternative to
+ * the single `GlobalBuffer` queue selected with `--scheduler steal`. Every consumer owns a
+ * deque of word blocks behind its own mutex. Producers deal their blocks round-robin over
+ * the deques, a consumer pops the oldest block of its own deque and, once it runs dry,
+ * steals the newest block of another consumer's deque. Queue operations only ever touch
+ * one deque's lock, so consumers no longer contend on `BUFFER.mutex` for every block.
+ *
+ * `BUFFER.mutex` and its condition variables are only used to sleep: consumers wait on
+ * `notEmpty` when every deque is empty and producers wait on `notFull` when the scheduler
+ * already holds MAX_GLOBAL_BLOCKS blocks. Wake-ups are only sent when someone is actually
+ * asleep, and a new block wakes a single consumer instead of the whole herd.
+ *
+ * The main components of this file include:
+ * - The `WorkQueue` structure, one consumer's deque.
+ * - The `WorkQueues` structure, the set of deques and the shared counters.
+ * - init_work_queues(): Allocates one deque per consumer.
+ * - push_block(): Hands a block from a producer to a consumer's deque.
+ * - steal_block(): Takes a block from the consumer's own deque or steals one.
+ * - free_work_queues(): Releases every queued block and frees the deques.
+ */
+
+#ifndef __STEAL__
+#define __STEAL__
+#include <pthread.h>
+#include <stdatomic.h>
+#include "block.h"
+
+/** WorkQueue
+ * A circular deque of blocks owned by one consumer. Each deque sits on its own cache
+ * lines so that the locks of neighbouring consumers do not share a line.
+ */
+typedef struct {
+    WordBlock** blocks;          // Circular array of queued blocks
+    int head;                    // Index of the oldest block, popped by the owner
+    int tail;                    // Index one past the newest block, stolen by thieves
+    int count;                   // Current count of blocks in the deque
+    int capacity;                // Size of the circular array
+    pthread_mutex_t mutex;       // Mutex for synchronizing access to this deque
+} __attribute__((aligned(64))) WorkQueue;
+
+/** WorkQueues
+ * The deques of every consumer and the counters shared by the whole scheduler.
+ */
+typedef struct {
+    WorkQueue* queues;           // One deque per consumer
+    int numQueues;               // Number of consumers
+    atomic_int queued;           // Number of blocks in all deques
+    atomic_int sleepingConsumers;// Number of consumers waiting on BUFFER.notEmpty
+    atomic_int sleepingProducers;// Number of producers waiting on BUFFER.notFull
+} WorkQueues;
+
+// per-consumer deques, used instead of the global buffer's queue by SCHED_STEAL
+extern WorkQueues QUEUES;
+
+/** init_work_queues()
+ * This function allocates one empty deque per consumer. Each deque can hold every block
+ * the scheduler admits, so a push never fails even if all blocks land on one consumer.
+ *
+ * @param numConsumers Number of consumer threads.
+ * @param numProducers Number of producer threads.
+ */
+void init_work_queues(int, int);
+
+/** push_block()
+ * This function appends a block to the deque of a consumer and wakes one sleeping
+ * consumer, if any. If the scheduler already holds MAX_GLOBAL_BLOCKS blocks the producer
+ * first sleeps until a consumer takes one. If every target has been cracked (`isFound`
+ * flag is set), the block is released and the function returns 0.
+ *
+ * @param block The block of words to queue.
+ * @param queue Index of the consumer whose deque receives the block.
+ * @return int 1 if the block was queued, 0 if every target is cracked.
+ */
+int push_block(WordBlock*, int);
+
+/** steal_block()
+ * This function pops the oldest block of a consumer's own deque. If it is empty, the
+ * function visits the other deques in turn and steals the newest block of the first
+ * non-empty one. If every deque is empty, the consumer sleeps until a block is pushed.
+ *
+ * @param queue Index of the calling consumer's deque.
+ * @return WordBlock* The block to process. Returns `NULL` if every target is cracked
+ * or all producers are done and every deque is empty.
+ */
+WordBlock* steal_block(int);
+
+/** free_work_queues()
+ * This function releases the blocks left in the deques by an early finish and frees
+ * the deques. It must only be called after all threads have been joined.
+ */
+void free_work_queues();
+
+#endif
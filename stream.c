@@ -0,0 +1,224 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "stream.h"
+#include "global.h"
+
+// the input, the chunks and the state of the reader thread
+static struct {
+    int fd;                      // Descriptor of the input
+    StreamChunk* chunks;         // Every chunk of the pool
+    StreamChunk* free;           // Free list of the chunks holding no words
+    StreamChunk* head;           // Oldest queued chunk, NULL if none is
+    StreamChunk* tail;           // Newest queued chunk
+    int ended;                   // Flag set once no chunk will be queued anymore
+    int stopping;                // Flag set by finish_stream()
+    atomic_int waiting;          // Number of producers waiting for a chunk
+    pthread_mutex_t mutex;       // Mutex protecting the queue, the free list and the flags
+    pthread_cond_t queued;       // Signaled when a chunk is queued or the input ends
+    pthread_cond_t freed;        // Signaled when a chunk is released or the run stops
+    pthread_t thread;            // Thread of the reader
+} stream;
+
+int is_stream(const char* path) {
+    struct stat info;
+    if (strcmp(path, "-") == 0) {
+        return 1;
+    }
+    return stat(path, &info) == 0 && !S_ISREG(info.st_mode) && !S_ISDIR(info.st_mode);
+}
+
+void open_stream(const char* path) {
+    stream.fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+    if (stream.fd < 0) {
+        printf("error: '%s' is an invalid file\n", path);
+        printf("ensure file exists and entered correctly\n\n");
+        exit(1);
+    }
+    // a larger pipe holds more of the generator's output between two reads, the kernel
+    // may refuse it, which only costs more reads
+#ifdef F_SETPIPE_SZ
+    fcntl(stream.fd, F_SETPIPE_SZ, STREAM_CHUNK_SIZE);
+#endif
+}
+
+// queue a chunk of whole lines for the producers
+static void queue_chunk(StreamChunk* chunk) {
+    pthread_mutex_lock(&stream.mutex);
+    chunk->next = NULL;
+    if (stream.tail != NULL) {
+        stream.tail->next = chunk;
+    }
+    else {
+        stream.head = chunk;
+    }
+    stream.tail = chunk;
+    pthread_cond_signal(&stream.queued);
+    pthread_mutex_unlock(&stream.mutex);
+}
+
+// take a free chunk, waiting for the producers to release one, returns NULL once the
+// run is stopping or every target is cracked
+static StreamChunk* free_chunk() {
+    pthread_mutex_lock(&stream.mutex);
+    // cracking the last target signals nothing here, so look at it between two waits
+    while (stream.free == NULL && !stream.stopping && !isFound) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += STREAM_POLL_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+        pthread_cond_timedwait(&stream.freed, &stream.mutex, &deadline);
+    }
+    StreamChunk* chunk = NULL;
+    if (!stream.stopping && !isFound) {
+        chunk = stream.free;
+        stream.free = chunk->next;
+    }
+    pthread_mutex_unlock(&stream.mutex);
+    return chunk;
+}
+
+// read the input into chunks and queue them until it is exhausted or the run is over
+static void* reader(void* arg) {
+    StreamChunk* chunk = free_chunk();
+    size_t size = 0;
+    int skipping = 0, eof = 0;
+
+    while (chunk != NULL && !eof) {
+        // wait for input, looking at the state of the run between two polls
+        struct pollfd input = { stream.fd, POLLIN, 0 };
+        int ready = poll(&input, 1, STREAM_POLL_MS);
+        if (isFound) {
+            break;
+        }
+        if (ready < 0 && errno != EINTR) {
+            eof = 1;
+        }
+        else if (ready > 0) {
+            ssize_t n = read(stream.fd, chunk->data + size, STREAM_CHUNK_SIZE - size);
+            if (n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN)) {
+                eof = 1;
+            }
+            else if (n > 0) {
+                size += n;
+            }
+        }
+        // the rest of a line longer than a chunk is dropped up to its newline
+        if (skipping && size > 0) {
+            char* newline = memchr(chunk->data, '\n', size);
+            size_t dropped = newline == NULL ? size : (size_t)(newline - chunk->data) + 1;
+            memmove(chunk->data, chunk->data + dropped, size - dropped);
+            size -= dropped;
+            skipping = newline == NULL;
+        }
+
+        // keep filling the chunk unless it is full, the input ended or a producer is idle
+        if (size == 0 || (size < STREAM_CHUNK_SIZE && !eof && atomic_load(&stream.waiting) == 0)) {
+            continue;
+        }
+        // queue the whole lines, a line cut by the end of the chunk goes to the next one
+        char* last = memrchr(chunk->data, '\n', size);
+        size_t whole = eof ? size : (last == NULL ? 0 : (size_t)(last - chunk->data) + 1);
+        if (whole == 0) {
+            if (size == STREAM_CHUNK_SIZE) {
+                size = 0;
+                skipping = 1;
+            }
+            continue;
+        }
+        StreamChunk* full = chunk;
+        full->size = whole;
+        queue_chunk(full);
+        if (eof) {
+            break;
+        }
+        // the chunk just queued is only read below `whole`, and it may come back at once
+        chunk = free_chunk();
+        if (chunk != NULL) {
+            memmove(chunk->data, full->data + whole, size - whole);
+        }
+        size -= whole;
+    }
+
+    // the producers waiting for input see that there is no more
+    pthread_mutex_lock(&stream.mutex);
+    stream.ended = 1;
+    pthread_cond_broadcast(&stream.queued);
+    pthread_mutex_unlock(&stream.mutex);
+    return NULL;
+}
+
+void start_stream() {
+    stream.chunks = malloc(STREAM_CHUNKS * sizeof(StreamChunk));
+    stream.free = NULL;
+    for (int i = 0; i < STREAM_CHUNKS; i++) {
+        stream.chunks[i].data = malloc(STREAM_CHUNK_SIZE);
+        stream.chunks[i].size = 0;
+        stream.chunks[i].next = stream.free;
+        stream.free = &stream.chunks[i];
+    }
+    stream.head = stream.tail = NULL;
+    stream.ended = stream.stopping = 0;
+    atomic_init(&stream.waiting, 0);
+    pthread_mutex_init(&stream.mutex, NULL);
+    pthread_cond_init(&stream.queued, NULL);
+    pthread_cond_init(&stream.freed, NULL);
+    pthread_create(&stream.thread, NULL, reader, NULL);
+}
+
+void finish_stream() {
+    pthread_mutex_lock(&stream.mutex);
+    stream.stopping = 1;
+    pthread_cond_broadcast(&stream.freed);
+    pthread_mutex_unlock(&stream.mutex);
+    pthread_join(stream.thread, NULL);
+
+    for (int i = 0; i < STREAM_CHUNKS; i++) {
+        free(stream.chunks[i].data);
+    }
+    free(stream.chunks);
+    pthread_mutex_destroy(&stream.mutex);
+    pthread_cond_destroy(&stream.queued);
+    pthread_cond_destroy(&stream.freed);
+    close(stream.fd);
+}
+
+StreamChunk* take_chunk() {
+    pthread_mutex_lock(&stream.mutex);
+    // while a producer waits, the reader queues what it has read without filling the chunk
+    if (stream.head == NULL && !stream.ended) {
+        atomic_fetch_add(&stream.waiting, 1);
+        while (stream.head == NULL && !stream.ended) {
+            pthread_cond_wait(&stream.queued, &stream.mutex);
+        }
+        atomic_fetch_sub(&stream.waiting, 1);
+    }
+    StreamChunk* chunk = NULL;
+    if (stream.head != NULL && !isFound) {
+        chunk = stream.head;
+        stream.head = chunk->next;
+        if (stream.head == NULL) {
+            stream.tail = NULL;
+        }
+    }
+    pthread_mutex_unlock(&stream.mutex);
+    return chunk;
+}
+
+void release_chunk(StreamChunk* chunk) {
+    pthread_mutex_lock(&stream.mutex);
+    chunk->next = stream.free;
+    stream.free = chunk;
+    pthread_cond_signal(&stream.freed);
+    pthread_mutex_unlock(&stream.mutex);
+}
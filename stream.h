@@ -0,0 +1,93 @@
+/** stream.h
+ * This file contains the declarations of the streamed dictionary, read from standard
+ * input (`-`) or from a pipe, FIFO or terminal, which cannot be mapped like a file (see
+ * dictionary.h). It lets candidates come straight from an external generator:
+ *     gen | cracker - hashes.txt result.txt 2 8
+ *
+ * A reader thread drains the input with `read` into STREAM_CHUNKS chunks of
+ * STREAM_CHUNK_SIZE bytes, recycled through a free list, so no memory is allocated while
+ * the run streams. It keeps reading into a chunk until it is full, the input ends or a
+ * producer is waiting for words, then queues the chunk up to its last newline: the start
+ * of a line split by the end of a chunk is moved to the beginning of the next one, so every
+ * queued chunk holds whole lines. Producers take the chunks in turn and scan each in place
+ * with next_word(), exactly like their range of a mapped dictionary, then release it. The
+ * pipe is enlarged to a chunk where the kernel allows it, so each `read` empties more of
+ * it, and the generator only waits once every chunk is filled and queued, when the hashing
+ * is behind by that much. A line longer than a whole chunk is skipped.
+ *
+ * A streamed dictionary has no size and is read once, so there is no progress to save: a
+ * streamed run writes no checkpoint and cannot be resumed, sharded or fused.
+ *
+ * The main components of this file include:
+ * - The `StreamChunk` structure, a chunk of whole lines of the input.
+ * - is_stream(): Tells whether a dictionary path is streamed.
+ * - open_stream(): Opens the input.
+ * - start_stream()/finish_stream(): Run and stop the reader thread.
+ * - take_chunk()/release_chunk(): Hand the chunks to the producers and back.
+ */
+
+#ifndef __STREAM__
+#define __STREAM__
+#include <stddef.h>
+
+// bytes of a chunk, also the pipe size asked of the kernel
+#define STREAM_CHUNK_SIZE (1 << 20)
+// chunks of the pool, the most input buffered ahead of the producers
+#define STREAM_CHUNKS 16
+// milliseconds the reader waits for input before it looks at the state of the run again
+#define STREAM_POLL_MS 10
+
+/** StreamChunk
+ * A chunk of the input holding whole lines, the last one with its newline except at the
+ * end of the input.
+ */
+typedef struct StreamChunk {
+    char* data;                  // The lines, STREAM_CHUNK_SIZE bytes allocated
+    size_t size;                 // Number of bytes of whole lines
+    struct StreamChunk* next;    // Next chunk in the queue or the free list
+} StreamChunk;
+
+/** is_stream()
+ * @param path Path of the dictionary.
+ * @return int 1 if the dictionary is `-` (standard input) or exists and is not a regular
+ *             file or a directory, such as a FIFO, 0 otherwise.
+ */
+int is_stream(const char*);
+
+/** open_stream()
+ * This function opens the streamed dictionary and enlarges its pipe. Opening a FIFO waits
+ * for its writer. If the input cannot be opened, the function prints an error and exits.
+ *
+ * @param path Path of the dictionary, `-` for standard input.
+ */
+void open_stream(const char*);
+
+/** start_stream()
+ * This function allocates the chunks and starts the reader thread. It must be called
+ * after start_checkpoints(), so the reader never receives the signals of the checkpoint
+ * thread.
+ */
+void start_stream();
+
+/** finish_stream()
+ * This function stops the reader thread, frees the chunks and closes the input. It must
+ * be called once every producer has been joined.
+ */
+void finish_stream();
+
+/** take_chunk()
+ * This function takes the oldest queued chunk, waiting for the reader if none is.
+ *
+ * @return StreamChunk* The chunk, to be returned with release_chunk(), or NULL once the
+ *                      input is exhausted or every target is cracked.
+ */
+StreamChunk* take_chunk();
+
+/** release_chunk()
+ * This function returns a chunk whose words have all been packed to the free list.
+ *
+ * @param chunk The chunk to release.
+ */
+void release_chunk(StreamChunk*);
+
+#endif
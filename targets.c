@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <stdint.h>
+#include "targets.h"
+#include "hash.h"
+#include "balance.h"
+#include "sha-256.h"
+#include "global.h"
+
+// insert target `index` into the table, returns 0 if an equal digest with the same salt
+// is already present
+static int insert_slot(int index) {
+    const uint32_t* digest = TARGETS.targets[index].digest;
+    uint32_t pos = digest[0] & TARGETS.mask;
+
+    // linear probing until an empty slot or a duplicate is found
+    while (TARGETS.slots[pos].index != -1) {
+        int other = TARGETS.slots[pos].index;
+        if (TARGETS.targets[other].salt == TARGETS.targets[index].salt
+                && memcmp(TARGETS.targets[other].digest, digest, sizeof(uint32_t) * HASH.digestWords) == 0) {
+            return 0;
+        }
+        pos = (pos + 1) & TARGETS.mask;
+    }
+    TARGETS.slots[pos].tag = digest[0];
+    TARGETS.slots[pos].index = index;
+    return 1;
+}
+
+// allocated size of TARGETS.salts while the hash file is read
+static int saltCapacity = 0;
+
+// FNV-1a hash of a salt, the key of the salt table
+static uint32_t salt_hash(const char* text, int len) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// index of a salt in the table of distinct salts, -1 if absent, or its new index if `add`
+static int lookup_salt(const char* text, int len, int add) {
+    uint32_t pos = salt_hash(text, len) & TARGETS.saltMask;
+    while (TARGETS.saltSlots[pos] != -1) {
+        const Salt* salt = &TARGETS.salts[TARGETS.saltSlots[pos]];
+        if (salt->len == len && memcmp(salt->text, text, len) == 0) {
+            return TARGETS.saltSlots[pos];
+        }
+        pos = (pos + 1) & TARGETS.saltMask;
+    }
+    if (!add) {
+        return -1;
+    }
+    if (TARGETS.numSalts == saltCapacity) {
+        saltCapacity = saltCapacity ? saltCapacity * 2 : 16;
+        TARGETS.salts = realloc(TARGETS.salts, saltCapacity * sizeof(Salt));
+    }
+    Salt* salt = &TARGETS.salts[TARGETS.numSalts];
+    memcpy(salt->text, text, len);
+    salt->text[len] = '\0';
+    salt->len = len;
+    atomic_init(&salt->numLeft, 0);
+    TARGETS.saltSlots[pos] = TARGETS.numSalts;
+    return TARGETS.numSalts++;
+}
+
+void load_targets(char* path) {
+    FILE* file = fopen(path, "r");
+    // check if file pointer is null (indicating invalid file)
+    if (file == NULL) {
+        printf("error: '%s' is an invalid file\n", path);
+        printf("ensure file exists and entered correctly\n\n");
+        exit(1);
+    }
+
+    // read every line into a growable array of digests and of their salts
+    int capacity = 64;
+    int count = 0;
+    Target* targets = malloc(capacity * sizeof(Target));
+    char (*salts)[MAX_SALT_LENGTH + 1] = malloc(capacity * sizeof(*salts));
+    char line[256];
+    int lineNum = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        lineNum++;
+        // strip trailing whitespace and newline
+        size_t len = strlen(line);
+        while (len > 0 && isspace((unsigned char)line[len - 1])) {
+            line[--len] = '\0';
+        }
+        // skip blank lines
+        if (len == 0) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            targets = realloc(targets, capacity * sizeof(Target));
+            salts = realloc(salts, capacity * sizeof(*salts));
+        }
+        // the hash may be followed by :salt
+        int hexLength = strcspn(line, ":");
+        if (hexLength != HASH.hexLength || !hash_decode_hex(line, targets[count].digest)) {
+            printf("warning: skipping invalid hash on line %d of '%s', expected %d hex characters for %s\n",
+                lineNum, path, HASH.hexLength, HASH.name);
+            continue;
+        }
+        const char* salt = line[hexLength] == ':' ? line + hexLength + 1 : "";
+        if (strlen(salt) > MAX_SALT_LENGTH || strchr(salt, ':') != NULL) {
+            printf("warning: skipping invalid salt on line %d of '%s', expected at most %d characters and no ':'\n",
+                lineNum, path, MAX_SALT_LENGTH);
+            continue;
+        }
+        strcpy(salts[count], salt);
+        targets[count].cracked = 0;
+        count++;
+    }
+    fclose(file);
+
+    if (count == 0) {
+        printf("Failed to read hash value\n");
+        free(targets);
+        free(salts);
+        exit(1);
+    }
+
+    // number every distinct salt, so targets and candidates refer to salts by index
+    uint32_t saltSize = 16;
+    while (saltSize < (uint32_t)count * 2) {
+        saltSize <<= 1;
+    }
+    TARGETS.salts = NULL;
+    TARGETS.numSalts = 0;
+    TARGETS.salted = 0;
+    TARGETS.saltMask = saltSize - 1;
+    TARGETS.saltSlots = malloc(saltSize * sizeof(int));
+    for (uint32_t i = 0; i < saltSize; i++) {
+        TARGETS.saltSlots[i] = -1;
+    }
+    for (int i = 0; i < count; i++) {
+        int saltLen = strlen(salts[i]);
+        targets[i].salt = lookup_salt(salts[i], saltLen, 1);
+        TARGETS.salted |= saltLen > 0;
+    }
+    free(salts);
+
+    // size the table to at most half full so probe chains stay short
+    uint32_t size = 16;
+    while (size < (uint32_t)count * 2) {
+        size <<= 1;
+    }
+    TARGETS.targets = targets;
+    TARGETS.numTargets = 0;
+    TARGETS.numCracked = 0;
+    TARGETS.mask = size - 1;
+    TARGETS.slots = malloc(size * sizeof(TargetSlot));
+    for (uint32_t i = 0; i < size; i++) {
+        TARGETS.slots[i].index = -1;
+    }
+
+    // compact the array while inserting so duplicates are dropped
+    for (int i = 0; i < count; i++) {
+        targets[TARGETS.numTargets] = targets[i];
+        if (insert_slot(TARGETS.numTargets)) {
+            atomic_fetch_add_explicit(&TARGETS.salts[targets[i].salt].numLeft, 1, memory_order_relaxed);
+            TARGETS.numTargets++;
+        }
+    }
+
+    // a prepended salt is the same prefix of every candidate hashed with it, so the
+    // SHA-256 state after it is computed once here instead of once per candidate
+    if (OPTIONS.saltSide == SALT_PREPEND && HASH.type == HASH_SHA256) {
+        for (int i = 0; i < TARGETS.numSalts; i++) {
+            sha_256_prefix_init(&TARGETS.salts[i].prefix, TARGETS.salts[i].text, TARGETS.salts[i].len);
+        }
+    }
+}
+
+void free_targets() {
+    free(TARGETS.targets);
+    free(TARGETS.slots);
+    free(TARGETS.salts);
+    free(TARGETS.saltSlots);
+    TARGETS.targets = NULL;
+    TARGETS.slots = NULL;
+    TARGETS.salts = NULL;
+    TARGETS.saltSlots = NULL;
+    saltCapacity = 0;
+}
+
+int find_target(const uint32_t* words, int salt) {
+    uint32_t pos = words[0] & TARGETS.mask;
+
+    while (TARGETS.slots[pos].index != -1) {
+        // compare the tag first, then the salt and the rest of the digest word by word
+        if (TARGETS.slots[pos].tag == words[0] && TARGETS.targets[TARGETS.slots[pos].index].salt == salt) {
+            const uint32_t* digest = TARGETS.targets[TARGETS.slots[pos].index].digest;
+            int i = 1;
+            while (i < HASH.digestWords && digest[i] == words[i]) {
+                i++;
+            }
+            if (i == HASH.digestWords) {
+                return TARGETS.slots[pos].index;
+            }
+        }
+        pos = (pos + 1) & TARGETS.mask;
+    }
+    return -1;
+}
+
+int find_target_text(const char* text, const char** rest) {
+    uint32_t digest[HASH_MAX_WORDS];
+    if (!hash_decode_hex(text, digest)) {
+        return -1;
+    }
+    const char* end = text + HASH.hexLength;
+    // a target with a salt is written hash:salt, one without as a bare hash, so the field
+    // after the hash is only a salt if it makes the digest a target
+    if (TARGETS.salted && *end == ':') {
+        const char* start = end + 1;
+        int len = strcspn(start, ":");
+        int salt = lookup_salt(start, len, 0);
+        int index = salt < 0 ? -1 : find_target(digest, salt);
+        if (index >= 0) {
+            if (rest != NULL) {
+                *rest = start + len;
+            }
+            return index;
+        }
+    }
+    if (rest != NULL) {
+        *rest = end;
+    }
+    int salt = TARGETS.salted ? lookup_salt("", 0, 0) : 0;
+    return salt < 0 ? -1 : find_target(digest, salt);
+}
+
+int mark_cracked(int index) {
+    if (atomic_exchange(&TARGETS.targets[index].cracked, 1)) {
+        return 0;
+    }
+    atomic_fetch_sub_explicit(&TARGETS.salts[TARGETS.targets[index].salt].numLeft, 1, memory_order_relaxed);
+
+    // every target has been cracked, signal all threads to terminate; the flag is set
+    // under the mutex, so a thread checking it before waiting cannot miss the wake-up
+    if (atomic_fetch_add(&TARGETS.numCracked, 1) + 1 == TARGETS.numTargets) {
+        pthread_mutex_lock(&BUFFER.mutex);
+        isFound = 1;
+        pthread_cond_broadcast(&BUFFER.notFull);
+        pthread_cond_broadcast(&BUFFER.notEmpty);
+        pthread_mutex_unlock(&BUFFER.mutex);
+        balance_wake();
+    }
+    return 1;
+}
+
+void target_to_text(int index, char text[MAX_TARGET_TEXT + 1]) {
+    hash_encode_hex(TARGETS.targets[index].digest, text);
+    if (TARGETS.salts[TARGETS.targets[index].salt].len > 0) {
+        snprintf(text + HASH.hexLength, MAX_TARGET_TEXT + 1 - HASH.hexLength, ":%s",
+            TARGETS.salts[TARGETS.targets[index].salt].text);
+    }
+}
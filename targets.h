@@ -0,0 +1,154 @@
+/** targets.h
+ * This file contains the declarations of the data structures and functions used to hold
+ * the set of target hashes the program is trying to crack. Every line of the hash file is
+ * decoded from hexadecimal into a raw digest of the `--hash-type` algorithm (see hash.h)
+ * once at startup, so the hot path in the consumer threads compares binary digests
+ * instead of formatted hex strings.
+ *
+ * A line may also be written `hash:salt`, for a hash of the password joined to a salt of
+ * its own: after it (`--salt-side append`, the default) or before it (`--salt-side
+ * prepend`). Every distinct salt is stored once, and each target records the index of its
+ * salt, so the consumers hash every candidate once per salt and look the digest up
+ * together with that index. Unsalted lines use the empty salt.
+ *
+ * The main components of this file include:
+ * - The `Target` structure, which holds one decoded digest, its salt and whether it has
+ *   been cracked.
+ * - The `Salt` structure, one distinct salt of the hash file.
+ * - The `TargetSet` structure, an open addressing hash table keyed on the first 32-bit
+ *   word of each digest. Digests are uniformly distributed, so that word is used directly
+ *   as the hash and a probe touches one small, contiguous slot array.
+ * - load_targets(): Reads and decodes the hash file into the global `TARGETS` set.
+ * - find_target(): Looks a freshly computed digest up in the set in O(1).
+ * - find_target_text(): Looks a hash written as in the hash file up in the set.
+ * - mark_cracked(): Records a hit and updates the termination flag.
+ * - target_to_text(): Formats a target as in the hash file.
+ */
+
+#ifndef __TARGETS__
+#define __TARGETS__
+#include <stdint.h>
+#include <stdatomic.h>
+#include "hash.h"
+#include "sha-256.h"
+
+// longest salt of a hash file line
+#define MAX_SALT_LENGTH 64
+// longest target written as in the hash file, hash:salt
+#define MAX_TARGET_TEXT (HASH_MAX_HEX + 1 + MAX_SALT_LENGTH)
+
+/** Target
+ * A single target hash decoded into raw bytes. The `cracked` flag is set once, by the
+ * atomic exchange of the thread that cracks the target.
+ */
+typedef struct {
+    uint32_t digest[HASH_MAX_WORDS]; // Raw digest decoded as big-endian words, HASH.digestWords used
+    int salt;                    // Index of the salt of the target in `salts`
+    atomic_int cracked;          // Flag to indicate this target has already been found
+} Target;
+
+/** Salt
+ * One distinct salt of the hash file, shared by every target that uses it. With
+ * `--salt-side prepend` and SHA-256, the state after absorbing the salt is computed once
+ * at load time as a shared prefix (see sha-256.h), so each candidate only hashes its own
+ * characters. `numLeft` is counted down by mark_cracked(), and read to skip salts whose
+ * targets are all cracked.
+ */
+typedef struct {
+    char text[MAX_SALT_LENGTH + 1];  // The salt, terminated
+    int len;                         // Length of the salt, 0 for unsalted targets
+    atomic_int numLeft;              // Number of targets of this salt not cracked yet
+    struct sha_256_prefix prefix;    // SHA-256 state after the salt, when it is prepended
+} Salt;
+
+/** TargetSlot
+ * One slot of the open addressing table. The `tag` is the first digest word so most
+ * failed probes are rejected without touching the `Target` array at all.
+ */
+typedef struct {
+    uint32_t tag;                // First 32-bit word of the digest (big-endian)
+    int index;                   // Index into `targets`, or -1 if the slot is empty
+} TargetSlot;
+
+/** TargetSet
+ * This structure holds every target digest along with the lookup table used by
+ * the consumer threads.
+ */
+typedef struct {
+    Target* targets;             // Array of unique target digests
+    int numTargets;              // Number of unique target digests
+    atomic_int numCracked;       // Number of targets cracked so far
+    TargetSlot* slots;           // Open addressing table (power of two sized)
+    uint32_t mask;               // Table size - 1, used to wrap probe indices
+    Salt* salts;                 // Every distinct salt, the empty one included if used
+    int numSalts;                // Number of distinct salts
+    int salted;                  // Flag set if any target has a non-empty salt
+    int* saltSlots;              // Open addressing table of salt indices, -1 if empty
+    uint32_t saltMask;           // Salt table size - 1
+} TargetSet;
+
+// set of target hashes to be matched
+extern TargetSet TARGETS;
+
+/** load_targets()
+ * This function opens the hash file, decodes every hexadecimal hash of the selected
+ * algorithm (`HASH.hexLength` characters), optionally followed by `:salt`, into the global
+ * `TARGETS` set and builds the lookup tables. Salts may not contain ':' nor be longer
+ * than MAX_SALT_LENGTH characters. Blank lines are ignored, invalid lines are reported
+ * and skipped, and duplicated hashes are only stored once per salt. With `--salt-side
+ * prepend` and SHA-256, the prefix of every salt is precomputed. If the file
+ * cannot be opened or contains no valid hash, the function prints an error and exits.
+ *
+ * @param path Path to the hash file.
+ */
+void load_targets(char*);
+
+/** free_targets()
+ * This function releases the memory held by the global `TARGETS` set.
+ */
+void free_targets();
+
+/** find_target()
+ * This function looks up a raw digest computed with a given salt in the global `TARGETS`
+ * set. The digest is given as `HASH.digestWords` 32-bit words in big-endian order, as
+ * produced by the hash kernels.
+ *
+ * @param words The digest to look up.
+ * @param salt Index of the salt the candidate was hashed with, 0 for an unsalted file.
+ * @return int Index of the matching target, or -1 if the digest is not a target.
+ */
+int find_target(const uint32_t*, int);
+
+/** find_target_text()
+ * This function looks up a hash written as in the hash file and the output file: the
+ * `HASH.hexLength` hexadecimal characters, followed by `:salt` if the target has a salt.
+ * Anything after them, such as `:password`, is not part of the target.
+ *
+ * @param text The hash to look up.
+ * @param rest Receives the end of the target in `text`, unless it is NULL.
+ * @return int Index of the matching target, or -1 if the hash is invalid or not a target.
+ */
+int find_target_text(const char*, const char**);
+
+/** mark_cracked()
+ * This function records that the target at `index` has been cracked, and counts it off
+ * its salt. It takes no lock, so any thread may call it: of threads that crack the same
+ * target at once, exactly one sees it newly cracked. When the last target is cracked, the
+ * `isFound` flag is set under the global buffer mutex and every waiting thread is woken up
+ * so the program can terminate.
+ *
+ * @param index Index of the target returned by `find_target`.
+ * @return int 1 if this call cracked the target, 0 if another thread already did.
+ */
+int mark_cracked(int);
+
+/** target_to_text()
+ * This function formats the target at `index` as in the hash file: its digest as
+ * `HASH.hexLength` hexadecimal characters, followed by `:salt` if the target has a salt.
+ *
+ * @param index Index of the target.
+ * @param text Output buffer of at least MAX_TARGET_TEXT + 1 characters.
+ */
+void target_to_text(int, char[MAX_TARGET_TEXT + 1]);
+
+#endif
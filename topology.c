@@ -0,0 +1,337 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sched.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "topology.h"
+#include "dictionary.h"
+#include "hash.h"
+#include "metrics.h"
+#include "global.h"
+
+// sysfs directory of the logical CPUs
+#define CPU_DIR "/sys/devices/system/cpu"
+// pages of the dictionary sampled to find its node
+#define DICT_SAMPLES 64
+// highest node number counted when sampling the dictionary
+#define MAX_NODES 64
+// seconds each SMT probe hashes for
+#define SMT_PROBE_SECONDS 0.03
+// plural ending of a count in the layout report
+#define PLURAL(n) ((n) == 1 ? "" : "s")
+
+// one logical CPU the process may run on
+typedef struct {
+    int cpu;                     // Logical CPU number
+    int core;                    // Core id within its package
+    int package;                 // Physical package (socket)
+    int node;                    // NUMA node
+    int sibling;                 // Index among the SMT siblings of its core, 0 for the first
+} CpuInfo;
+
+// the topology and the plan, only set once plan_threads() plans a placement
+static CpuInfo* cpus = NULL;
+static int numCpus = 0, numCores = 0, numPackages = 0, numNodes = 0, smtWidth = 1;
+static int dictNode = 0;
+static cpu_set_t readers;        // CPUs of the dictionary's node, for producers
+static int* hashers = NULL;      // Logical CPU of every hashing thread, in order of id
+static int numHashers = 0;
+static double smtGain = 0;       // Hash rate of two siblings over one, 0 if not probed
+static int planned = 0;
+
+// read one integer from a sysfs file, -1 if it cannot be read
+static int read_sysfs(int cpu, const char* name) {
+    char path[128];
+    snprintf(path, sizeof(path), CPU_DIR "/cpu%d/%s", cpu, name);
+    FILE* file = fopen(path, "r");
+    int value = -1;
+    if (file != NULL) {
+        if (fscanf(file, "%d", &value) != 1) {
+            value = -1;
+        }
+        fclose(file);
+    }
+    return value;
+}
+
+// node of a CPU, from the nodeN link in its sysfs directory, 0 without NUMA
+static int cpu_node(int cpu) {
+    char path[128];
+    snprintf(path, sizeof(path), CPU_DIR "/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    int node = 0;
+    if (dir != NULL) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+                node = atoi(entry->d_name + 4);
+                break;
+            }
+        }
+        closedir(dir);
+    }
+    return node;
+}
+
+// count the distinct values of one field of the CPUs
+static int count_distinct(size_t offset) {
+    int count = 0;
+    for (int i = 0; i < numCpus; i++) {
+        int value = *(const int*)((const char*)&cpus[i] + offset);
+        int seen = 0;
+        for (int j = 0; j < i && !seen; j++) {
+            seen = *(const int*)((const char*)&cpus[j] + offset) == value;
+        }
+        count += !seen;
+    }
+    return count;
+}
+
+// read every CPU of the affinity mask of the process, without sysfs each is its own core
+static void load_topology() {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        CPU_SET(0, &allowed);
+    }
+    cpus = malloc(CPU_COUNT(&allowed) * sizeof(CpuInfo));
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        CpuInfo* info = &cpus[numCpus++];
+        info->cpu = cpu;
+        info->core = read_sysfs(cpu, "topology/core_id");
+        info->package = read_sysfs(cpu, "topology/physical_package_id");
+        info->node = cpu_node(cpu);
+        if (info->core < 0) {
+            info->core = cpu;
+        }
+        if (info->package < 0) {
+            info->package = 0;
+        }
+        // siblings share a package and a core id
+        info->sibling = 0;
+        for (int j = 0; j < numCpus - 1; j++) {
+            info->sibling += cpus[j].package == info->package && cpus[j].core == info->core;
+        }
+        if (info->sibling + 1 > smtWidth) {
+            smtWidth = info->sibling + 1;
+        }
+        numCores += info->sibling == 0;
+    }
+    numPackages = count_distinct(offsetof(CpuInfo, package));
+    numNodes = count_distinct(offsetof(CpuInfo, node));
+}
+
+// the node holding most of the sampled pages of the dictionary
+static int dictionary_node(const Dictionary* dict) {
+    if (numNodes < 2 || dict->size == 0) {
+        return cpus[0].node;
+    }
+    int counts[MAX_NODES] = { 0 };
+    int best = cpus[0].node;
+#ifdef SYS_move_pages
+    long page = sysconf(_SC_PAGESIZE);
+    const char* first = dict->data - (uintptr_t)dict->data % page;
+    size_t numPages = (dict->data + dict->size - first + page - 1) / page;
+    void* pages[DICT_SAMPLES];
+    int status[DICT_SAMPLES];
+    int n = 0;
+    for (; n < DICT_SAMPLES && (size_t)n < numPages; n++) {
+        pages[n] = (void*)(first + numPages * n / DICT_SAMPLES * page);
+        // a page only has a node once it is mapped, reading it maps it from the page cache
+        (void)*(volatile const char*)pages[n];
+    }
+    // without target nodes, move_pages only reports the node of every page
+    if (syscall(SYS_move_pages, 0, (unsigned long)n, pages, NULL, status, 0) == 0) {
+        for (int i = 0; i < n; i++) {
+            if (status[i] >= 0 && status[i] < MAX_NODES) {
+                counts[status[i]]++;
+            }
+        }
+        for (int i = 0; i < MAX_NODES; i++) {
+            best = counts[i] > counts[best] ? i : best;
+        }
+    }
+#endif
+    return best;
+}
+
+// one thread of an SMT probe, hashing batches on its CPU for a fixed time
+typedef struct {
+    int cpu;
+    double rate;                 // Batches per second
+} SmtProbe;
+
+static void* smt_probe(void* arg) {
+    SmtProbe* probe = (SmtProbe*)arg;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(probe->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    char words[HASH_MAX_LANES][16];
+    const char* msgs[HASH_MAX_LANES];
+    size_t lens[HASH_MAX_LANES];
+    uint32_t digests[HASH_MAX_LANES * HASH_MAX_WORDS];
+    for (int i = 0; i < HASH.lanes; i++) {
+        lens[i] = snprintf(words[i], sizeof(words[i]), "probe%02d", i);
+        msgs[i] = words[i];
+    }
+    long batches = 0;
+    uint64_t start = metrics_now(), now;
+    do {
+        HASH.batch(msgs, lens, HASH.lanes, digests);
+        batches++;
+        now = metrics_now();
+    } while ((now - start) / 1e9 < SMT_PROBE_SECONDS);
+    probe->rate = batches / ((now - start) / 1e9);
+    return NULL;
+}
+
+// total hash rate of probes run together on the given CPUs
+static double probe_rate(const int* probeCpus, int n) {
+    SmtProbe probes[2];
+    pthread_t ids[2];
+    double rate = 0;
+    for (int i = 0; i < n; i++) {
+        probes[i].cpu = probeCpus[i];
+        pthread_create(&ids[i], NULL, smt_probe, &probes[i]);
+    }
+    for (int i = 0; i < n; i++) {
+        pthread_join(ids[i], NULL);
+        rate += probes[i].rate;
+    }
+    return rate;
+}
+
+// hashing CPUs come first by sibling, then from the dictionary's node, then in order
+static int compare_hashers(const void* a, const void* b) {
+    const CpuInfo* x = (const CpuInfo*)a;
+    const CpuInfo* y = (const CpuInfo*)b;
+    int keys[2][5] = {
+        { x->sibling, x->node != dictNode, x->node, x->package, x->cpu },
+        { y->sibling, y->node != dictNode, y->node, y->package, y->cpu },
+    };
+    for (int i = 0; i < 5; i++) {
+        if (keys[0][i] != keys[1][i]) {
+            return keys[0][i] < keys[1][i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+void plan_threads(const Dictionary* dict) {
+    if (OPTIONS.numProducers != THREADS_AUTO && OPTIONS.numConsumers != THREADS_AUTO) {
+        return;
+    }
+    load_topology();
+    dictNode = dictionary_node(dict);
+    CPU_ZERO(&readers);
+    for (int i = 0; i < numCpus; i++) {
+        if (cpus[i].node == dictNode) {
+            CPU_SET(cpus[i].cpu, &readers);
+        }
+    }
+
+    // two threads on the siblings of one core against one thread alone on it
+    int useSmt = 0;
+    for (int i = 0; i < numCpus && smtWidth > 1 && smtGain == 0; i++) {
+        for (int j = 0; j < i; j++) {
+            if (cpus[i].sibling == 1 && cpus[j].package == cpus[i].package && cpus[j].core == cpus[i].core) {
+                int pair[2] = { cpus[j].cpu, cpus[i].cpu };
+                double alone = probe_rate(pair, 1);
+                smtGain = alone > 0 ? probe_rate(pair, 2) / alone : 0;
+                useSmt = smtGain >= SMT_MIN_GAIN;
+                break;
+            }
+        }
+    }
+
+    // one hashing thread per CPU kept, in the order they are filled
+    qsort(cpus, numCpus, sizeof(CpuInfo), compare_hashers);
+    hashers = malloc(numCpus * sizeof(int));
+    for (int i = 0; i < numCpus; i++) {
+        if (useSmt || cpus[i].sibling == 0) {
+            hashers[numHashers++] = cpus[i].cpu;
+        }
+    }
+    if (OPTIONS.numConsumers == THREADS_AUTO) {
+        OPTIONS.numConsumers = numHashers;
+    }
+    if (OPTIONS.numProducers == THREADS_AUTO) {
+        OPTIONS.numProducers = (OPTIONS.numConsumers + CONSUMERS_PER_PRODUCER - 1) / CONSUMERS_PER_PRODUCER;
+    }
+    planned = 1;
+}
+
+void pin_thread(int role, int id) {
+    if (!planned) {
+        return;
+    }
+    cpu_set_t set;
+    if (role == ROLE_PRODUCER) {
+        set = readers;
+    }
+    else {
+        // more hashing threads than CPUs wrap around
+        CPU_ZERO(&set);
+        CPU_SET(hashers[id % numHashers], &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// format a list of CPUs with runs of consecutive CPUs as ranges, e.g. 0-7,16
+static void format_cpus(const int* list, int n, char* out, size_t size) {
+    size_t at = 0;
+    out[0] = '\0';
+    for (int i = 0; i < n && at < size; i++) {
+        int last = i;
+        while (last + 1 < n && list[last + 1] == list[last] + 1) {
+            last++;
+        }
+        if (last > i) {
+            at += snprintf(out + at, size - at, "%s%d-%d", i > 0 ? "," : "", list[i], list[last]);
+        }
+        else {
+            at += snprintf(out + at, size - at, "%s%d", i > 0 ? "," : "", list[i]);
+        }
+        i = last;
+    }
+}
+
+void print_layout() {
+    if (!planned) {
+        return;
+    }
+    char smt[64];
+    if (smtGain > 0) {
+        snprintf(smt, sizeof(smt), "SMT %s (siblings hash %.2fx one)", smtGain >= SMT_MIN_GAIN ? "used" : "unused",
+            smtGain);
+    }
+    else {
+        snprintf(smt, sizeof(smt), "no SMT");
+    }
+    printf("topology:    %d node%s, %d package%s, %d core%s, %d CPU%s, %s\n", numNodes, PLURAL(numNodes),
+        numPackages, PLURAL(numPackages), numCores, PLURAL(numCores), numCpus, PLURAL(numCpus), smt);
+
+    // the first hashing CPUs are taken, in order
+    char list[256];
+    int numPinned = OPTIONS.numConsumers < numHashers ? OPTIONS.numConsumers : numHashers;
+    format_cpus(hashers, numPinned, list, sizeof(list));
+    printf("layout:      %d %s%s pinned to CPU%s %s", OPTIONS.numConsumers,
+        OPTIONS.dictFile == NULL || OPTIONS.fused ? "worker" : "consumer", PLURAL(OPTIONS.numConsumers),
+        PLURAL(numPinned), list);
+    if (OPTIONS.dictFile != NULL && !OPTIONS.fused) {
+        printf(", %d producer%s on node %d (dictionary)", OPTIONS.numProducers, PLURAL(OPTIONS.numProducers),
+            dictNode);
+    }
+    printf("\n");
+}
@@ -0,0 +1,63 @@
+/** topology.h
+ * This file contains the declarations of the thread placement used when a thread count
+ * is given as `auto`. The CPU topology is read from sysfs (/sys/devices/system/cpu):
+ * every logical CPU the process may run on, its core, package and NUMA node, and which
+ * logical CPUs are SMT siblings of the same core.
+ *
+ * From it, hashing threads (consumers, fused workers and mask workers) get one logical
+ * CPU each: one per physical core, or one per SMT thread when a short probe of the
+ * selected hash kernel on two siblings of a core shows that they hash enough more
+ * together than one alone. Cores of the node holding the dictionary are filled first.
+ * Producers are allowed on every CPU of that node, so the words they copy come from
+ * local memory. The node of the dictionary is the one holding most of a sample of its
+ * pages, as reported by the kernel (`move_pages`).
+ *
+ * Each thread pins itself first thing, before it allocates anything, so its buffers are
+ * placed on its own node by the kernel's first-touch policy. Explicit thread counts keep
+ * the default scheduling, with no pinning.
+ *
+ * The main components of this file include:
+ * - plan_threads(): Reads the topology and resolves `auto` thread counts.
+ * - pin_thread(): Pins the calling thread to its planned CPUs.
+ * - print_layout(): Reports the topology and the chosen layout.
+ */
+
+#ifndef __TOPOLOGY__
+#define __TOPOLOGY__
+#include "dictionary.h"
+
+// a hashing thread on each SMT sibling must beat one per core by this factor
+#define SMT_MIN_GAIN 1.15
+// a producer packs words far faster than a consumer hashes their candidates, so one
+// producer keeps this many consumers fed
+#define CONSUMERS_PER_PRODUCER 8
+
+/** plan_threads()
+ * This function plans the placement of the threads when either thread count of the
+ * global `OPTIONS` is `THREADS_AUTO`: it reads the CPU topology, finds the node of the
+ * dictionary, probes the SMT siblings with the selected hash kernel, and replaces each
+ * `auto` count with the number of hashing CPUs, or for the producers with one per
+ * CONSUMERS_PER_PRODUCER consumers. It must be called after hash_engine_init() and
+ * before any thread is created; with explicit counts it does nothing.
+ *
+ * @param dict The mapped dictionary, empty for a plain mask attack.
+ */
+void plan_threads(const Dictionary*);
+
+/** pin_thread()
+ * This function pins the calling thread to the CPUs planned for it: a producer to the
+ * CPUs of the dictionary's node, a hashing thread to one logical CPU, in order of `id`.
+ * Does nothing if no placement was planned.
+ *
+ * @param role ROLE_PRODUCER or ROLE_CONSUMER (see metrics.h).
+ * @param id Index of the thread within its role.
+ */
+void pin_thread(int, int);
+
+/** print_layout()
+ * This function prints the topology and the placement of the producers and hashing
+ * threads, if a placement was planned.
+ */
+void print_layout();
+
+#endif
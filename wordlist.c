@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "wordlist.h"
+#include "dictionary.h"
+
+// one slot of the set of distinct words, the word is words[index - 1], 0 if the slot is empty
+typedef struct {
+    uint64_t hash;
+    uint64_t index;
+} WordSlot;
+
+// FNV-1a hash of a word
+static uint64_t hash_word(const char* word, int len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)word[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// insert a slot into a table known not to hold its word
+static void insert_slot(WordSlot* slots, uint64_t mask, WordSlot slot) {
+    uint64_t pos = slot.hash & mask;
+    while (slots[pos].index != 0) {
+        pos = (pos + 1) & mask;
+    }
+    slots[pos] = slot;
+}
+
+int compile_wordlist(int numArgs, char** args) {
+    if (numArgs != 2) {
+        printf("usage: cracker --compile-dict <dictionary_file> <compiled_file>\n\n");
+        return 1;
+    }
+    Dictionary dict;
+    open_dictionary(args[0], &dict);
+    if (dict.compiled != NULL) {
+        printf("error: '%s' is already compiled\n\n", args[0]);
+        return 1;
+    }
+
+    // keep the first occurrence of every word, in the order of the file, and count the
+    // distinct words of every length
+    uint64_t capacity = 1 << 16, numWords = 0, numRead = 0;
+    uint64_t slotMask = 2 * capacity - 1;
+    WordView* words = malloc(capacity * sizeof(WordView));
+    WordSlot* slots = calloc(slotMask + 1, sizeof(WordSlot));
+    uint64_t counts[WORDLIST_LENGTHS] = { 0 };
+    DictRange range = { dict.data, dict.data + dict.size };
+    WordView word;
+    while (next_word(&range, &word)) {
+        numRead++;
+        uint64_t hash = hash_word(word.ptr, word.len);
+        uint64_t pos = hash & slotMask;
+        while (slots[pos].index != 0) {
+            const WordView* seen = &words[slots[pos].index - 1];
+            if (slots[pos].hash == hash && seen->len == word.len && memcmp(seen->ptr, word.ptr, word.len) == 0) {
+                break;
+            }
+            pos = (pos + 1) & slotMask;
+        }
+        if (slots[pos].index != 0) {
+            continue;
+        }
+        // the table stays at most half full
+        if (numWords == capacity) {
+            capacity *= 2;
+            words = realloc(words, capacity * sizeof(WordView));
+            WordSlot* old = slots;
+            uint64_t oldMask = slotMask;
+            slotMask = 2 * capacity - 1;
+            slots = calloc(slotMask + 1, sizeof(WordSlot));
+            for (uint64_t i = 0; i <= oldMask; i++) {
+                if (old[i].index != 0) {
+                    insert_slot(slots, slotMask, old[i]);
+                }
+            }
+            free(old);
+            pos = hash & slotMask;
+            while (slots[pos].index != 0) {
+                pos = (pos + 1) & slotMask;
+            }
+        }
+        words[numWords++] = word;
+        slots[pos].hash = hash;
+        slots[pos].index = numWords;
+        counts[word.len]++;
+    }
+    free(slots);
+
+    // the buckets follow each other, shortest words first
+    WordlistHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WORDLIST_MAGIC, sizeof(header.magic));
+    header.version = WORDLIST_VERSION;
+    header.numLengths = WORDLIST_LENGTHS;
+    header.numWords = numWords;
+    header.wordsOffset = WORDLIST_WORDS_OFFSET;
+    for (int len = 0; len < WORDLIST_LENGTHS; len++) {
+        header.buckets[len].offset = header.wordsSize;
+        header.buckets[len].count = counts[len];
+        header.wordsSize += counts[len] * (len + 1);
+    }
+
+    // write the file through a shared mapping, every word straight into its bucket
+    size_t size = header.wordsOffset + header.wordsSize;
+    int fd = open(args[1], O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, size) != 0) {
+        printf("error: failed to create '%s'\n\n", args[1]);
+        exit(1);
+    }
+    char* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        printf("error: failed to map '%s' into memory\n\n", args[1]);
+        exit(1);
+    }
+    memcpy(data, &header, sizeof(header));
+    uint64_t next[WORDLIST_LENGTHS];
+    for (int len = 0; len < WORDLIST_LENGTHS; len++) {
+        next[len] = header.wordsOffset + header.buckets[len].offset;
+    }
+    for (uint64_t i = 0; i < numWords; i++) {
+        char* at = data + next[words[i].len];
+        memcpy(at, words[i].ptr, words[i].len);
+        at[words[i].len] = '\n';
+        next[words[i].len] += words[i].len + 1;
+    }
+    if (munmap(data, size) != 0 || close(fd) != 0) {
+        printf("error: failed to write '%s'\n\n", args[1]);
+        exit(1);
+    }
+    free(words);
+    close_dictionary(&dict);
+
+    printf("compiled:    %s, %llu words read, %llu distinct\n", args[1], (unsigned long long)numRead,
+        (unsigned long long)numWords);
+    printf("size:        %zu bytes of words, %zu bytes in all\n\n", (size_t)header.wordsSize, size);
+    return 0;
+}
+
+const WordlistHeader* wordlist_header(const char* data, size_t size, const char* path) {
+    if (size < sizeof(WORDLIST_MAGIC) - 1 || memcmp(data, WORDLIST_MAGIC, sizeof(WORDLIST_MAGIC) - 1) != 0) {
+        return NULL;
+    }
+    // the bucket table must describe exactly the words that follow the header
+    const WordlistHeader* header = (const WordlistHeader*)data;
+    int valid = size >= sizeof(WordlistHeader) && header->version == WORDLIST_VERSION
+        && header->numLengths == WORDLIST_LENGTHS && header->wordsOffset >= sizeof(WordlistHeader)
+        && header->wordsOffset <= size && header->wordsSize == size - header->wordsOffset;
+    uint64_t offset = 0;
+    for (int len = 0; valid && len < WORDLIST_LENGTHS; len++) {
+        valid = header->buckets[len].offset == offset && (len > 0 || header->buckets[len].count == 0);
+        offset += header->buckets[len].count * (len + 1);
+    }
+    if (!valid || offset != header->wordsSize) {
+        printf("error: '%s' is not a valid compiled wordlist of version %d, compile it again\n", path,
+            WORDLIST_VERSION);
+        exit(1);
+    }
+    return header;
+}
+
+const char* wordlist_boundary(const WordlistHeader* header, const char* at) {
+    const char* words = (const char*)header + header->wordsOffset;
+    uint64_t offset = at - words;
+    for (int len = 1; len < WORDLIST_LENGTHS; len++) {
+        const WordlistBucket* bucket = &header->buckets[len];
+        // the buckets follow each other, so the first one ending after the position holds it
+        if (offset < bucket->offset + bucket->count * (len + 1)) {
+            uint64_t index = (offset - bucket->offset + len) / (len + 1);
+            return words + bucket->offset + index * (len + 1);
+        }
+    }
+    return words + header->wordsSize;
+}
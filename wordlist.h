@@ -0,0 +1,93 @@
+/** wordlist.h
+ * This file contains the declarations of compiled wordlists, a binary form of a text
+ * dictionary for dictionaries that are cracked against again and again. It is written
+ * once with `cracker --compile-dict <dictionary_file> <compiled_file>` and then given to
+ * the cracker in place of the text file, which recognizes it by its magic number.
+ *
+ * Compiling does once what every run would otherwise redo: lines are validated and
+ * stripped of carriage returns, empty and overlong lines (see next_word()) are dropped,
+ * and repeated words are removed. The distinct words are stored grouped by length, so
+ * a compiled wordlist is a header followed by one bucket of words per length, shortest
+ * first, each word followed by a newline and in the order of the text file within its
+ * bucket. The buckets are text in the same format as a dictionary, so the cracker maps
+ * the file and reads the words in place, exactly as it reads a text dictionary, with no
+ * parsing at load time. Every word of a bucket takes length + 1 bytes, so the header's
+ * table of buckets is also an index from any offset to the word boundary at or after
+ * it, used to split the words between readers and shards without scanning.
+ *
+ * The header is written in the byte order of the machine that compiled it.
+ *
+ * The main components of this file include:
+ * - The `WordlistHeader` structure, the header and the bucket table of a compiled file.
+ * - compile_wordlist(): The `--compile-dict` subcommand.
+ * - wordlist_header(): Recognizes and checks a mapped compiled wordlist.
+ * - wordlist_boundary(): Finds the start of a word from the bucket table.
+ */
+
+#ifndef __WORDLIST__
+#define __WORDLIST__
+#include <stdint.h>
+#include <stddef.h>
+
+// magic number and version of the compiled format
+#define WORDLIST_MAGIC "CRKWORDS"
+#define WORDLIST_VERSION 1
+// number of buckets of the format, one per length, at least MAX_WORD_LENGTH
+#define WORDLIST_LENGTHS 128
+// the words start on the page after the header
+#define WORDLIST_WORDS_OFFSET 4096
+
+/** WordlistBucket
+ * The words of one length in a compiled wordlist.
+ */
+typedef struct {
+    uint64_t offset;             // Offset of the first word from the start of the words
+    uint64_t count;              // Number of words of this length
+} WordlistBucket;
+
+/** WordlistHeader
+ * The header of a compiled wordlist, at the start of the file.
+ */
+typedef struct {
+    char magic[8];               // WORDLIST_MAGIC, without terminator
+    uint32_t version;            // WORDLIST_VERSION
+    uint32_t numLengths;         // WORDLIST_LENGTHS
+    uint64_t numWords;           // Number of distinct words
+    uint64_t wordsOffset;        // Offset of the words from the start of the file
+    uint64_t wordsSize;          // Size of the words in bytes, newlines included
+    WordlistBucket buckets[WORDLIST_LENGTHS]; // Bucket of every word length
+} WordlistHeader;
+
+/** compile_wordlist()
+ * This function implements `cracker --compile-dict <dictionary_file> <compiled_file>`:
+ * it reads a text dictionary and writes its distinct words as a compiled wordlist.
+ *
+ * @param numArgs Number of arguments after `--compile-dict`.
+ * @param args The dictionary file, then the compiled file.
+ * @return int Exit status of the program.
+ */
+int compile_wordlist(int, char**);
+
+/** wordlist_header()
+ * This function recognizes a mapped file as a compiled wordlist. If it starts with the
+ * magic number but is not a valid compiled wordlist of this version, the function prints
+ * an error and exits.
+ *
+ * @param data Start of the mapped file.
+ * @param size Size of the file.
+ * @param path Path of the file, for the error message.
+ * @return const WordlistHeader* The header, or NULL if the file is a text dictionary.
+ */
+const WordlistHeader* wordlist_header(const char*, size_t, const char*);
+
+/** wordlist_boundary()
+ * This function returns the start of the first word at or after a position within the
+ * words of a compiled wordlist, using the bucket table.
+ *
+ * @param header Header of the mapped compiled wordlist.
+ * @param at Position within its words.
+ * @return const char* Start of the word, or the end of the words.
+ */
+const char* wordlist_boundary(const WordlistHeader*, const char*);
+
+#endif